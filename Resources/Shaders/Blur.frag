@@ -0,0 +1,29 @@
+#version 450 core
+
+uniform sampler2D colorTexture; // Diffused colors with the downsample pyramid as mipmaps
+uniform sampler2D blurTexture;  // Diffused blur strength relative to maximumStrength
+uniform float maximumStrength;
+uniform vec2 texelsPerUnit;
+
+in vec2 fsTextureCoords;
+
+out vec4 outColor;
+
+void main()
+{
+    // Strength is a radius in world units, level n of the pyramid averages about 2^n texels
+    vec2 radius = texture(blurTexture, fsTextureCoords).r * maximumStrength * texelsPerUnit;
+    float lod = log2(1.0f + max(radius.x, radius.y));
+
+    // Four trilinear taps half a texel of the level apart hide the blocks of the coarse levels.
+    // The spread vanishes at level 0, so unblurred pixels stay sharp.
+    vec2 spread = 0.5f * (exp2(lod) - 1.0f) / vec2(textureSize(colorTexture, 0));
+
+    vec4 color = vec4(0);
+    color += textureLod(colorTexture, fsTextureCoords + vec2(-spread.x, -spread.y), lod);
+    color += textureLod(colorTexture, fsTextureCoords + vec2(spread.x, -spread.y), lod);
+    color += textureLod(colorTexture, fsTextureCoords + vec2(-spread.x, spread.y), lod);
+    color += textureLod(colorTexture, fsTextureCoords + vec2(spread.x, spread.y), lod);
+
+    outColor = 0.25f * color;
+}
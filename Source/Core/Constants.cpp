@@ -9,10 +9,31 @@ namespace DiffusionCurveRenderer
     extern const std::string DOWNSAMPLE_RENDERER = "DownsampleRenderer";
     extern const std::string UPSAMPLE_RENDERER = "UpsampleRenderer";
     extern const std::string BLUR_RENDERER = "BlurRenderer";
+    extern const std::string CPU_DIFFUSION_SOLVER = "CpuDiffusionSolver";
+    extern const std::string CPU_CONSTRAINT_RASTERIZER = "CpuConstraintRasterizer";
+    extern const std::string PCG_DIFFUSION_SOLVER = "PcgDiffusionSolver";
+    extern const std::string WALK_ON_SPHERES = "WalkOnSpheres";
+    extern const std::string TILED_EXPORTER = "TiledExporter";
+    extern const std::string DEEP_ZOOM_EXPORTER = "DeepZoomExporter";
     extern const std::string CURVE_SELECTION_RENDERER = "CurveSelectionRenderer";
     extern const std::string RENDERER_MANAGER = "RendererManager";
     extern const std::string CURVE_CONTAINER_GET_CURVE_AROUND = "CurveContainer::GetCurveAround";
     extern const std::string BEZIER_FIND_COLOR_POINT_AROUND = "Bezier::FindColorPointAround";
+    extern const std::string VECTORIZATION_CANNY = "Vectorization::Canny";
+    extern const std::string VECTORIZATION_GAUSSIAN_STACK = "Vectorization::GaussianStack";
+    extern const std::string VECTORIZATION_EDGE_STACK = "Vectorization::EdgeStack";
+    extern const std::string VECTORIZATION_EDGE_TRACER = "Vectorization::EdgeTracer";
+    extern const std::string VECTORIZATION_POTRACE = "Vectorization::Potrace";
+    extern const std::string VECTORIZATION_CURVE_CONSTRUCTOR = "Vectorization::CurveConstructor";
+    extern const std::string VECTORIZATION_COLOR_SAMPLER = "Vectorization::ColorSampler";
+
+    extern const std::string GPU_CHORONOMETER_PREFIX = "GPU::";
+    extern const std::string GPU_CONTOUR_RENDERER = "GPU::ContourRenderer";
+    extern const std::string GPU_COLOR_RENDERER = "GPU::ColorRenderer";
+    extern const std::string GPU_DOWNSAMPLE_RENDERER = "GPU::DownsampleRenderer";
+    extern const std::string GPU_UPSAMPLE_RENDERER = "GPU::UpsampleRenderer";
+    extern const std::string GPU_BLUR_RENDERER = "GPU::BlurRenderer";
+    extern const std::string GPU_CURVE_SELECTION_RENDERER = "GPU::CurveSelectionRenderer";
 
     extern const std::vector<std::string> ALL_CHORONOMETER_IDs = {
         CONTOUR_RENDERER,
@@ -20,10 +41,23 @@ namespace DiffusionCurveRenderer
         DOWNSAMPLE_RENDERER,
         UPSAMPLE_RENDERER,
         BLUR_RENDERER,
+        CPU_DIFFUSION_SOLVER,
+        CPU_CONSTRAINT_RASTERIZER,
+        PCG_DIFFUSION_SOLVER,
+        WALK_ON_SPHERES,
+        TILED_EXPORTER,
+        DEEP_ZOOM_EXPORTER,
         CURVE_SELECTION_RENDERER,
         RENDERER_MANAGER,
         CURVE_CONTAINER_GET_CURVE_AROUND,
-        BEZIER_FIND_COLOR_POINT_AROUND
+        BEZIER_FIND_COLOR_POINT_AROUND,
+        VECTORIZATION_CANNY,
+        VECTORIZATION_GAUSSIAN_STACK,
+        VECTORIZATION_EDGE_STACK,
+        VECTORIZATION_EDGE_TRACER,
+        VECTORIZATION_POTRACE,
+        VECTORIZATION_CURVE_CONSTRUCTOR,
+        VECTORIZATION_COLOR_SAMPLER
     };
 
     extern QVector4D USE_THIS_COLOR_WHEN_A_CURVE_SELECTED = QVector4D(0.1, 0.1, 0.1, 1);
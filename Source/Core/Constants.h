@@ -15,6 +15,7 @@ namespace DiffusionCurveRenderer
     constexpr float DEFAULT_DIFFUSION_WIDTH = 0.75f;
     constexpr float DEFAULT_CONTOUR_THICKNESS = 4.0f;
     constexpr float DEFAULT_BLUR_STRENGTH = 0.25f;
+    constexpr float MAXIMUM_BLUR_STRENGTH = 64.0f; // World units, blur radius at the strongest blur point
     constexpr int DEFAULT_SMOOTH_ITERATIONS = 20;
 
     // General render settings
@@ -23,12 +24,18 @@ namespace DiffusionCurveRenderer
 
     // Curve selection (Obsolete)
     constexpr float DEFAULT_CURVE_SELECTION_WIDTH = 20.0f;
+    constexpr int CURVE_SELECTION_REGION_SIZE = 128; // Pixels, side of the scissored region re-rendered around a query
 
     // Overlay painter (Gui)
     constexpr float HANDLE_OUTER_DISK_RADIUS_PX = 15.0f; // Pixels
     constexpr float HANDLE_INNER_DISK_RADIUS_PX = 8.0f;  // Pixels
     constexpr float COLOR_POINT_HANDLE_OFFSET_PX = 0.0f; // Pixels
 
+    // Vectorization
+    constexpr size_t DEFAULT_GAUSSIAN_STACK_MEMORY_BUDGET = size_t(1) << 30; // Bytes, blurred images kept by GaussianStack
+    constexpr qint64 DEFAULT_VECTORIZATION_CACHE_CAPACITY = qint64(512) << 20; // Bytes, files kept by VectorizationCache
+    constexpr int EDGE_STACK_PREFETCH_RADIUS = 2;                              // Edge levels computed ahead on each side of the one shown
+
     // Others
     extern QVector4D USE_THIS_COLOR_WHEN_A_CURVE_SELECTED;
 
@@ -38,10 +45,32 @@ namespace DiffusionCurveRenderer
     extern const std::string DOWNSAMPLE_RENDERER;
     extern const std::string UPSAMPLE_RENDERER;
     extern const std::string BLUR_RENDERER;
+    extern const std::string CPU_DIFFUSION_SOLVER;
+    extern const std::string CPU_CONSTRAINT_RASTERIZER;
+    extern const std::string PCG_DIFFUSION_SOLVER;
+    extern const std::string WALK_ON_SPHERES;
+    extern const std::string TILED_EXPORTER;
+    extern const std::string DEEP_ZOOM_EXPORTER;
     extern const std::string CURVE_SELECTION_RENDERER;
     extern const std::string RENDERER_MANAGER;
     extern const std::string CURVE_CONTAINER_GET_CURVE_AROUND;
     extern const std::string BEZIER_FIND_COLOR_POINT_AROUND;
+    extern const std::string VECTORIZATION_CANNY;
+    extern const std::string VECTORIZATION_GAUSSIAN_STACK;
+    extern const std::string VECTORIZATION_EDGE_STACK;
+    extern const std::string VECTORIZATION_EDGE_TRACER;
+    extern const std::string VECTORIZATION_POTRACE;
+    extern const std::string VECTORIZATION_CURVE_CONSTRUCTOR;
+    extern const std::string VECTORIZATION_COLOR_SAMPLER;
+
+    // GPU Choronometer IDs (per level IDs are created on the fly with the same prefix)
+    extern const std::string GPU_CHORONOMETER_PREFIX;
+    extern const std::string GPU_CONTOUR_RENDERER;
+    extern const std::string GPU_COLOR_RENDERER;
+    extern const std::string GPU_DOWNSAMPLE_RENDERER;
+    extern const std::string GPU_UPSAMPLE_RENDERER;
+    extern const std::string GPU_BLUR_RENDERER;
+    extern const std::string GPU_CURVE_SELECTION_RENDERER;
 
     extern const std::vector<std::string> ALL_CHORONOMETER_IDs;
 }
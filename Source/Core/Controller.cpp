@@ -9,10 +9,13 @@
 #include "Gui/OverlayPainter.h"
 #include "Renderer/BitmapRenderer/BitmapRenderer.h"
 #include "Renderer/RendererManager.h"
+#include "Renderer/TiledExporter/DeepZoomExporter.h"
+#include "Renderer/TiledExporter/TiledExporter.h"
 #include "Util/Chronometer.h"
 #include "Util/Exporter.h"
 #include "Util/Importer.h"
 #include "Util/Logger.h"
+#include "Util/Tracer.h"
 #include "Vectorization/VectorizationManager.h"
 
 #include <QtImGui.h>
@@ -49,6 +52,10 @@ DiffusionCurveRenderer::Controller::Controller(QObject* parent)
     mVectorizationManagerThread = new QThread;
     mVectorizationManager->moveToThread(mVectorizationManagerThread);
 
+    Tracer::SetCurrentThreadName("Main");
+    connect(mVectorizationManagerThread, &QThread::started, mVectorizationManager, []()
+            { Tracer::SetCurrentThreadName("Vectorization"); }, Qt::DirectConnection);
+
     connect(mWindow, &Window::Initialize, this, &Controller::Initialize);
     connect(mWindow, &Window::Render, this, &Controller::Render);
     connect(mWindow, &Window::Resize, this, &Controller::Resize);
@@ -101,6 +108,28 @@ DiffusionCurveRenderer::Controller::Controller(QObject* parent)
             {
                 mRendererManager->Save(path, mRenderModes); //
             });
+
+    connect(mImGuiWindow, &ImGuiWindow::ExportTiled, this, [=](const QString& path, int width, int height, int tileSize)
+            {
+                mTiledExporter->SetTileSize(tileSize);
+                mTiledExporter->SetSmoothIterations(mRendererManager->GetSmoothIterations());
+                mTiledExporter->SetSolverType(mRendererManager->GetDiffusionSolverType());
+                mTiledExporter->Start(path, width, height, mRenderModes); //
+            });
+
+    connect(mImGuiWindow, &ImGuiWindow::ExportDeepZoom, this, [=](const QString& path, int width, int height, int tileSize)
+            {
+                mDeepZoomExporter->SetWindowSize(tileSize);
+                mDeepZoomExporter->SetSmoothIterations(mRendererManager->GetSmoothIterations());
+                mDeepZoomExporter->SetSolverType(mRendererManager->GetDiffusionSolverType());
+                mDeepZoomExporter->Start(path, width, height, mRenderModes); //
+            });
+
+    connect(mImGuiWindow, &ImGuiWindow::CancelTiledExport, this, [=]()
+            {
+                mTiledExporter->Cancel();
+                mDeepZoomExporter->Cancel();
+            });
     
     // New signal connections for enhanced features
     connect(mImGuiWindow, &ImGuiWindow::DuplicateCurve, this, &Controller::DuplicateCurve);
@@ -114,6 +143,12 @@ DiffusionCurveRenderer::Controller::Controller(QObject* parent)
                 Exporter::ExportAsJson(mCurveContainer->GetCurves(), path); //
             });
 
+    connect(mImGuiWindow, &ImGuiWindow::TraceRecordingChanged, this, [=](bool enabled)
+            { Tracer::SetEnabled(enabled); });
+
+    connect(mImGuiWindow, &ImGuiWindow::ExportTrace, this, [=](const QString& path)
+            { Tracer::Dump(path.toStdString()); });
+
     connect(mImGuiWindow, &ImGuiWindow::ImportXml, this, [=](const QString& path)
             {
                 const auto& curves = Importer::ImportFromXml(path);
@@ -140,12 +175,17 @@ DiffusionCurveRenderer::Controller::Controller(QObject* parent)
                 } //
             });
 
+    // Cancel() and RequestVectorization() are thread safe and called directly, the thread of the manager may be busy
+    // vectorizing. A new image supersedes the running vectorization.
+    connect(mImGuiWindow, &ImGuiWindow::LoadImage, mVectorizationManager, &VectorizationManager::Cancel, Qt::DirectConnection);
     connect(mImGuiWindow, &ImGuiWindow::LoadImage, mVectorizationManager, &VectorizationManager::LoadImage, Qt::QueuedConnection);
-    connect(mImGuiWindow, &ImGuiWindow::Vectorize, mVectorizationManager, &VectorizationManager::Vectorize, Qt::QueuedConnection);
+    connect(mImGuiWindow, &ImGuiWindow::Vectorize, mVectorizationManager, &VectorizationManager::RequestVectorization, Qt::DirectConnection);
+    connect(mImGuiWindow, &ImGuiWindow::CancelVectorization, mVectorizationManager, &VectorizationManager::Cancel, Qt::DirectConnection);
 
     connect(mVectorizationManager, &VectorizationManager::ProgressChanged, mImGuiWindow, &ImGuiWindow::SetVectorizationProgress, Qt::QueuedConnection);
     connect(mVectorizationManager, &VectorizationManager::VectorizationStageChanged, mImGuiWindow, &ImGuiWindow::SetVectorizationStage, Qt::QueuedConnection);
     connect(mVectorizationManager, &VectorizationManager::ImageLoaded, this, &Controller::OnImageLoaded, Qt::QueuedConnection);
+    connect(mVectorizationManager, &VectorizationManager::ImageReady, this, &Controller::OnVectorizationImageReady, Qt::QueuedConnection);
     connect(mVectorizationManager, &VectorizationManager::VectorizationStageFinished, this, &Controller::OnVectorizationStageFinished, Qt::QueuedConnection);
     connect(mVectorizationManager, &VectorizationManager::VectorizationFinished, this, &Controller::OnVectorizationFinished, Qt::QueuedConnection);
 }
@@ -174,6 +214,11 @@ void DiffusionCurveRenderer::Controller::Run()
     mWindow->show();
 }
 
+void DiffusionCurveRenderer::Controller::SetVectorizationMemoryBudget(size_t bytes)
+{
+    mVectorizationManager->SetGaussianStackMemoryBudget(bytes);
+}
+
 void DiffusionCurveRenderer::Controller::Initialize()
 {
     initializeOpenGLFunctions();
@@ -183,6 +228,16 @@ void DiffusionCurveRenderer::Controller::Initialize()
     mRendererManager->Initialize();
     mBitmapRenderer = mRendererManager->GetBitmapRenderer();
 
+    mTiledExporter = new TiledExporter;
+    mTiledExporter->SetCamera(mCamera);
+    mTiledExporter->SetCurveContainer(mCurveContainer);
+    mTiledExporter->Initialize();
+
+    mDeepZoomExporter = new DeepZoomExporter;
+    mDeepZoomExporter->SetCamera(mCamera);
+    mDeepZoomExporter->SetCurveContainer(mCurveContainer);
+    mDeepZoomExporter->Initialize();
+
     QtImGui::initialize(mWindow);
 }
 
@@ -192,6 +247,19 @@ void DiffusionCurveRenderer::Controller::Render(float ifps)
     mWidth = mWindow->width() * mDevicePixelRatio;
     mHeight = mWindow->height() * mDevicePixelRatio;
 
+    Tracer::AddFrameMarker(mFrameIndex++);
+    mRendererManager->BeginFrame();
+
+    // One tile per frame keeps the window responsive during large exports
+    if (mTiledExporter->IsRunning())
+        mTiledExporter->Step();
+
+    if (mDeepZoomExporter->IsRunning())
+        mDeepZoomExporter->Step();
+
+    mImGuiWindow->SetTiledExportRunning(mTiledExporter->IsRunning() || mDeepZoomExporter->IsRunning());
+    mImGuiWindow->SetTiledExportProgress(mDeepZoomExporter->IsRunning() ? mDeepZoomExporter->GetProgress() : mTiledExporter->GetProgress());
+
     { // RendererManager
 
         MEASURE_CALL_TIME(RENDERER_MANAGER);
@@ -264,7 +332,10 @@ void DiffusionCurveRenderer::Controller::OnMousePressed(QMouseEvent* event)
         return;
     }
 
+    // Curve picking may need to refresh the selection buffer
+    mWindow->makeCurrent();
     mEventHandler->OnMousePressed(event);
+    mWindow->doneCurrent();
 }
 
 void DiffusionCurveRenderer::Controller::OnMouseReleased(QMouseEvent* event)
@@ -279,10 +350,6 @@ void DiffusionCurveRenderer::Controller::OnMouseMoved(QMouseEvent* event)
         return;
     }
 
-    mWindow->makeCurrent();
-    mRendererManager->RenderForCurveSelection();
-    mWindow->doneCurrent();
-
     mEventHandler->OnMouseMoved(event);
 }
 
@@ -308,24 +375,20 @@ void DiffusionCurveRenderer::Controller::OnVectorizationViewOptionChanged(Vector
             mBitmapRenderer->SetImage(image, GL_RGB, GL_BGR);
             break;
         }
+        // Computed on the thread pool, OnVectorizationImageReady() shows them
         case VectorizationViewOption::ViewEdges:
         {
-            cv::Mat image = mVectorizationManager->GetCannyEdges();
-            mBitmapRenderer->SetImage(image, GL_R8, GL_RED);
+            mVectorizationManager->RequestImage(option, 0);
             break;
         }
         case VectorizationViewOption::ViewGaussianStack:
         {
-            int index = mImGuiWindow->GetGaussianStackLayer();
-            cv::Mat image = mVectorizationManager->GetGaussianStackLayer(index);
-            mBitmapRenderer->SetImage(image, GL_RGB8, GL_BGR);
+            mVectorizationManager->RequestImage(option, mImGuiWindow->GetGaussianStackLayer());
             break;
         }
         case VectorizationViewOption::ChooseEdgeStackLevel:
         {
-            int index = mImGuiWindow->GetEdgeStackLayer();
-            cv::Mat image = mVectorizationManager->GetEdgeStackLayer(index);
-            mBitmapRenderer->SetImage(image, GL_R8, GL_RED);
+            mVectorizationManager->RequestImage(option, mImGuiWindow->GetEdgeStackLayer());
             break;
         }
         default:
@@ -352,14 +415,34 @@ void DiffusionCurveRenderer::Controller::ClearCanvas()
 
 void DiffusionCurveRenderer::Controller::OnGaussianStackLayerChanged(int layer)
 {
-    cv::Mat image = mVectorizationManager->GetGaussianStackLayer(layer);
-    mBitmapRenderer->SetImage(image, GL_RGB8, GL_BGR);
+    mVectorizationManager->RequestImage(VectorizationViewOption::ViewGaussianStack, layer);
 }
 
 void DiffusionCurveRenderer::Controller::OnEdgeStackLayerChanged(int layer)
 {
-    cv::Mat image = mVectorizationManager->GetEdgeStackLayer(layer);
-    mBitmapRenderer->SetImage(image, GL_R8, GL_RED);
+    mVectorizationManager->RequestImage(VectorizationViewOption::ChooseEdgeStackLevel, layer);
+}
+
+void DiffusionCurveRenderer::Controller::OnVectorizationImageReady(VectorizationViewOption option, int layer, cv::Mat image)
+{
+    // The user may have moved on while the image was computed
+    if (mImGuiWindow->GetVectorizationViewOption() != option)
+        return;
+
+    if (option == VectorizationViewOption::ViewGaussianStack && mImGuiWindow->GetGaussianStackLayer() != layer)
+        return;
+
+    if (option == VectorizationViewOption::ChooseEdgeStackLevel && mImGuiWindow->GetEdgeStackLayer() != layer)
+        return;
+
+    mWindow->makeCurrent();
+
+    if (option == VectorizationViewOption::ViewGaussianStack)
+        mBitmapRenderer->SetImage(image, GL_RGB8, GL_BGR);
+    else
+        mBitmapRenderer->SetImage(image, GL_R8, GL_RED);
+
+    mWindow->doneCurrent();
 }
 
 void DiffusionCurveRenderer::Controller::OnVectorizationStageFinished(VectorizationStage stage, QVariant additionalData)
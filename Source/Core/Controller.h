@@ -22,6 +22,8 @@ namespace DiffusionCurveRenderer
     class ImGuiWindow;
     class BitmapRenderer;
     class VectorizationManager;
+    class TiledExporter;
+    class DeepZoomExporter;
 
     class Controller : public QObject, protected QOpenGLExtraFunctions
     {
@@ -34,6 +36,9 @@ namespace DiffusionCurveRenderer
 
         void Run();
 
+        // Bytes the Gaussian stack of the vectorization may keep, DEFAULT_GAUSSIAN_STACK_MEMORY_BUDGET by default
+        void SetVectorizationMemoryBudget(size_t bytes);
+
       public slots:
         // Core Events
         void Initialize();
@@ -53,6 +58,7 @@ namespace DiffusionCurveRenderer
         void OnEdgeStackLayerChanged(int layer);
 
         void OnImageLoaded(cv::Mat image);
+        void OnVectorizationImageReady(VectorizationViewOption option, int layer, cv::Mat image);
         void OnVectorizationStageFinished(VectorizationStage stage, QVariant additionalData);
         void OnVectorizationFinished(const QVector<CurvePtr>& curves);
 
@@ -69,6 +75,7 @@ namespace DiffusionCurveRenderer
         float mDevicePixelRatio{ 1.0f };
         float mWidth{ INITIAL_WIDTH };
         float mHeight{ INITIAL_HEIGHT };
+        uint64_t mFrameIndex{ 0 };
 
         RendererManager* mRendererManager;
         OrthographicCamera* mCamera;
@@ -78,6 +85,8 @@ namespace DiffusionCurveRenderer
         ImGuiWindow* mImGuiWindow;
         BitmapRenderer* mBitmapRenderer;
         VectorizationManager* mVectorizationManager;
+        TiledExporter* mTiledExporter{ nullptr };
+        DeepZoomExporter* mDeepZoomExporter{ nullptr };
 
         Window* mWindow;
 
@@ -0,0 +1,130 @@
+#include "CurveBvh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void DiffusionCurveRenderer::CurveBvh::Build(std::vector<CurveSegment> segments)
+{
+    mSegments = std::move(segments);
+    mNodes.clear();
+
+    if (mSegments.empty())
+        return;
+
+    mNodes.reserve(2 * mSegments.size() / MAX_LEAF_SIZE + 1);
+    BuildRecursive(0, int(mSegments.size()));
+}
+
+int DiffusionCurveRenderer::CurveBvh::BuildRecursive(int first, int count)
+{
+    const int index = int(mNodes.size());
+    mNodes.push_back(Node{});
+
+    QVector2D min(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+    QVector2D max(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+
+    for (int i = first; i < first + count; ++i)
+    {
+        const auto& segment = mSegments[i];
+
+        min.setX(std::min({ min.x(), segment.start.x(), segment.end.x() }));
+        min.setY(std::min({ min.y(), segment.start.y(), segment.end.y() }));
+        max.setX(std::max({ max.x(), segment.start.x(), segment.end.x() }));
+        max.setY(std::max({ max.y(), segment.start.y(), segment.end.y() }));
+    }
+
+    mNodes[index].min = min;
+    mNodes[index].max = max;
+
+    if (count <= MAX_LEAF_SIZE)
+    {
+        mNodes[index].first = first;
+        mNodes[index].count = count;
+        return index;
+    }
+
+    // Median split of the segment midpoints along the longer side
+    const int axis = (max.x() - min.x()) >= (max.y() - min.y()) ? 0 : 1;
+    const int half = count / 2;
+
+    std::nth_element(mSegments.begin() + first, //
+                     mSegments.begin() + first + half,
+                     mSegments.begin() + first + count,
+                     [axis](const CurveSegment& a, const CurveSegment& b) { //
+                         return (a.start[axis] + a.end[axis]) < (b.start[axis] + b.end[axis]);
+                     });
+
+    BuildRecursive(first, half);
+    const int right = BuildRecursive(first + half, count - half);
+
+    mNodes[index].first = right;
+    mNodes[index].count = 0;
+
+    return index;
+}
+
+bool DiffusionCurveRenderer::CurveBvh::FindClosest(const QVector2D& point, ClosestSegmentPoint& closest) const
+{
+    if (mNodes.empty())
+        return false;
+
+    float bestDistanceSquared = std::numeric_limits<float>::max();
+
+    int stack[64];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const Node& node = mNodes[stack[--stackSize]];
+
+        if (DistanceSquaredToBox(point, node) >= bestDistanceSquared)
+            continue;
+
+        if (node.count > 0)
+        {
+            for (int i = node.first; i < node.first + node.count; ++i)
+            {
+                const auto& segment = mSegments[i];
+
+                const QVector2D direction = segment.end - segment.start;
+                const float lengthSquared = direction.lengthSquared();
+                const float s = lengthSquared > 0.0f ? std::clamp(QVector2D::dotProduct(point - segment.start, direction) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+                const QVector2D position = segment.start + s * direction;
+                const float distanceSquared = (point - position).lengthSquared();
+
+                if (distanceSquared < bestDistanceSquared)
+                {
+                    bestDistanceSquared = distanceSquared;
+                    closest.position = position;
+                    closest.t = segment.t0 + s * (segment.t1 - segment.t0);
+                    closest.segment = i;
+                }
+            }
+        }
+        else
+        {
+            // Push the farther child first so that the nearer one is visited next and tightens the bound early
+            const int left = int(&node - mNodes.data()) + 1;
+            const int right = node.first;
+
+            const bool leftIsNearer = DistanceSquaredToBox(point, mNodes[left]) <= DistanceSquaredToBox(point, mNodes[right]);
+
+            stack[stackSize++] = leftIsNearer ? right : left;
+            stack[stackSize++] = leftIsNearer ? left : right;
+        }
+    }
+
+    closest.distance = std::sqrt(bestDistanceSquared);
+
+    return true;
+}
+
+float DiffusionCurveRenderer::CurveBvh::DistanceSquaredToBox(const QVector2D& point, const Node& node)
+{
+    const float dx = std::max({ node.min.x() - point.x(), 0.0f, point.x() - node.max.x() });
+    const float dy = std::max({ node.min.y() - point.y(), 0.0f, point.y() - node.max.y() });
+
+    return dx * dx + dy * dy;
+}
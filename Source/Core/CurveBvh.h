@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QVector2D>
+#include <vector>
+
+namespace DiffusionCurveRenderer
+{
+    // Piece of a flattened Bezier patch, t0 and t1 are the curve parameters at its ends
+    struct CurveSegment
+    {
+        QVector2D start;
+        QVector2D end;
+        int patch;
+        float t0;
+        float t1;
+    };
+
+    struct ClosestSegmentPoint
+    {
+        QVector2D position;
+        float distance;
+        float t; // Curve parameter at position
+        int segment;
+    };
+
+    // Bounding volume hierarchy over curve segments for closest point queries.
+    // Immutable after Build(), so queries can run from any number of threads.
+    class CurveBvh
+    {
+      public:
+        CurveBvh() = default;
+
+        void Build(std::vector<CurveSegment> segments);
+
+        // Returns false if there are no segments
+        bool FindClosest(const QVector2D& point, ClosestSegmentPoint& closest) const;
+
+        const CurveSegment& GetSegment(int index) const { return mSegments[index]; }
+        int GetNumberOfSegments() const { return int(mSegments.size()); }
+
+      private:
+        struct Node
+        {
+            QVector2D min;
+            QVector2D max;
+            int first; // Leaf: first segment, interior: right child, left child is the next node
+            int count; // 0 for interior nodes
+        };
+
+        int BuildRecursive(int first, int count);
+
+        static float DistanceSquaredToBox(const QVector2D& point, const Node& node);
+
+        std::vector<CurveSegment> mSegments;
+        std::vector<Node> mNodes;
+
+        static constexpr int MAX_LEAF_SIZE = 4;
+    };
+}
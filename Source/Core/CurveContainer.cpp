@@ -3,24 +3,31 @@
 #include "Util/Chronometer.h"
 #include "Util/Logger.h"
 
+#include <algorithm>
+#include <limits>
+
 void DiffusionCurveRenderer::CurveContainer::AddCurve(CurvePtr curve)
 {
     mCurves << curve;
+    ++mVersion;
 }
 
 void DiffusionCurveRenderer::CurveContainer::AddCurves(QList<CurvePtr> curves)
 {
     mCurves.append(curves);
+    ++mVersion;
 }
 
 void DiffusionCurveRenderer::CurveContainer::RemoveCurve(CurvePtr curve)
 {
     mCurves.removeAll(curve);
+    ++mVersion;
 }
 
 void DiffusionCurveRenderer::CurveContainer::Clear()
 {
     mCurves.clear();
+    ++mVersion;
 }
 
 DiffusionCurveRenderer::CurvePtr DiffusionCurveRenderer::CurveContainer::GetCurve(int index)
@@ -29,6 +36,47 @@ DiffusionCurveRenderer::CurvePtr DiffusionCurveRenderer::CurveContainer::GetCurv
     return mCurves.at(index);
 }
 
+QRectF DiffusionCurveRenderer::CurveContainer::GetBoundingBox() const
+{
+    float minX = std::numeric_limits<float>::max();
+    float minY = std::numeric_limits<float>::max();
+    float maxX = std::numeric_limits<float>::lowest();
+    float maxY = std::numeric_limits<float>::lowest();
+
+    for (const auto& curve : mCurves)
+    {
+        for (int i = 0; i < curve->GetNumberOfControlPoints(); ++i)
+        {
+            const QVector2D position = curve->GetControlPointPosition(i);
+            minX = std::min(minX, position.x());
+            minY = std::min(minY, position.y());
+            maxX = std::max(maxX, position.x());
+            maxY = std::max(maxY, position.y());
+        }
+    }
+
+    if (maxX < minX || maxY < minY)
+    {
+        return QRectF();
+    }
+
+    return QRectF(QPointF(minX, minY), QPointF(maxX, maxY));
+}
+
+uint64_t DiffusionCurveRenderer::CurveContainer::GetVersion() const
+{
+    // Structural changes live in the upper bits so that removing a curve cannot cancel out against the sum
+    // of the remaining curve versions, which only ever grow when a curve is edited.
+    uint64_t version = mVersion << 32;
+
+    for (const auto& curve : mCurves)
+    {
+        version += curve->GetVersion();
+    }
+
+    return version;
+}
+
 DiffusionCurveRenderer::CurvePtr DiffusionCurveRenderer::CurveContainer::GetCurveAround(const QVector2D& test, float radius)
 {
     MEASURE_CALL_TIME(CURVE_CONTAINER_GET_CURVE_AROUND);
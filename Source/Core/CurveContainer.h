@@ -4,6 +4,7 @@
 #include "Curve/Spline.h"
 #include "Util/Macros.h"
 
+#include <QRectF>
 #include <QVector>
 
 namespace DiffusionCurveRenderer
@@ -22,6 +23,12 @@ namespace DiffusionCurveRenderer
         CurvePtr GetCurveAround(const QVector2D& test, float radius = 8.0f);
         int GetTotalNumberOfCurves() const { return mCurves.size(); }
 
+        // Bounding box of the control points, which contains all curves
+        QRectF GetBoundingBox() const;
+
+        // Changes whenever a curve is added, removed or its geometry is updated
+        uint64_t GetVersion() const;
+
         float GetGlobalContourThickness() { return mGlobalContourThickness; }
         float GetGlobalDiffusionWidth() { return mGlobalDiffusionWidth; }
         float GetGlobalDiffusionGap() { return mGlobalDiffusionGap; }
@@ -39,5 +46,7 @@ namespace DiffusionCurveRenderer
         float mGlobalDiffusionWidth{ DEFAULT_DIFFUSION_WIDTH };
         float mGlobalDiffusionGap{ DEFAULT_DIFFUSION_GAP };
         float mGlobalBlurStrength{ DEFAULT_BLUR_STRENGTH };
+
+        uint64_t mVersion{ 0 };
     };
 }
\ No newline at end of file
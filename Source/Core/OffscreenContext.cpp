@@ -0,0 +1,71 @@
+#include "OffscreenContext.h"
+
+#include "Util/Logger.h"
+
+#include <QOpenGLFunctions>
+#include <QSurfaceFormat>
+
+DiffusionCurveRenderer::OffscreenContext::~OffscreenContext()
+{
+    if (mContext && mContext == QOpenGLContext::currentContext())
+    {
+        mContext->doneCurrent();
+    }
+}
+
+bool DiffusionCurveRenderer::OffscreenContext::Initialize()
+{
+    QSurfaceFormat format;
+    format.setRenderableType(QSurfaceFormat::OpenGL);
+    format.setVersion(4, 5);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+
+    mContext = std::make_unique<QOpenGLContext>();
+    mContext->setFormat(format);
+
+    if (mContext->create() == false)
+    {
+        LOG_FATAL("OffscreenContext::Initialize: Could not create an OpenGL 4.5 core context.");
+        return false;
+    }
+
+    mSurface = std::make_unique<QOffscreenSurface>();
+    mSurface->setFormat(mContext->format());
+    mSurface->create();
+
+    if (mSurface->isValid() == false)
+    {
+        LOG_FATAL("OffscreenContext::Initialize: Could not create an offscreen surface.");
+        return false;
+    }
+
+    if (MakeCurrent() == false)
+    {
+        return false;
+    }
+
+    const auto* functions = mContext->functions();
+
+    LOG_INFO("OffscreenContext::Initialize: Vendor: {}, Renderer: {}, Version: {}",
+             reinterpret_cast<const char*>(functions->glGetString(GL_VENDOR)),
+             reinterpret_cast<const char*>(functions->glGetString(GL_RENDERER)),
+             reinterpret_cast<const char*>(functions->glGetString(GL_VERSION)));
+
+    return true;
+}
+
+bool DiffusionCurveRenderer::OffscreenContext::MakeCurrent()
+{
+    if (mContext->makeCurrent(mSurface.get()) == false)
+    {
+        LOG_FATAL("OffscreenContext::MakeCurrent: Could not make the context current.");
+        return false;
+    }
+
+    return true;
+}
+
+void DiffusionCurveRenderer::OffscreenContext::DoneCurrent()
+{
+    mContext->doneCurrent();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Util/Macros.h"
+
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <memory>
+
+namespace DiffusionCurveRenderer
+{
+    // OpenGL 4.5 core context without a window, for headless tools.
+    // Renderers draw into their own framebuffers, the surface itself is never rendered to.
+    class OffscreenContext
+    {
+        DISABLE_COPY(OffscreenContext);
+
+      public:
+        OffscreenContext() = default;
+        ~OffscreenContext();
+
+        bool Initialize();
+        bool MakeCurrent();
+        void DoneCurrent();
+
+        QOpenGLContext* GetContext() const { return mContext.get(); }
+
+      private:
+        std::unique_ptr<QOffscreenSurface> mSurface;
+        std::unique_ptr<QOpenGLContext> mContext;
+    };
+}
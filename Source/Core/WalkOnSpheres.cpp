@@ -0,0 +1,194 @@
+#include "WalkOnSpheres.h"
+
+#include "Core/Constants.h"
+#include "Util/Chronometer.h"
+#include "Util/Parallel.h"
+#include "Util/Util.h"
+
+#include <cmath>
+#include <numbers>
+
+namespace
+{
+    uint64_t SplitMix64(uint64_t& state)
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    float NextUniform(uint64_t& state)
+    {
+        return float(SplitMix64(state) >> 40) * (1.0f / float(1ull << 24));
+    }
+
+    // Reflects x into [min, max], the image of a point outside is its mirror across the nearest border
+    float Reflect(float x, float min, float max)
+    {
+        const float length = max - min;
+
+        if (length <= 0.0f)
+            return min;
+
+        float u = std::fmod(x - min, 2.0f * length);
+
+        if (u < 0.0f)
+            u += 2.0f * length;
+
+        return min + (u > length ? 2.0f * length - u : u);
+    }
+}
+
+void DiffusionCurveRenderer::WalkOnSpheres::Build()
+{
+    mPatches.clear();
+
+    std::vector<CurveSegment> segments;
+
+    const auto append = [&](BezierPtr bezier) {
+        const int patchIndex = int(mPatches.size());
+
+        mPatches.push_back({ bezier->GetLeftColors(), bezier->GetLeftColorPositions(), bezier->GetRightColors(), bezier->GetRightColorPositions() });
+
+        QVector2D previous = bezier->PositionAt(0.0f);
+
+        for (int i = 1; i <= NUMBER_OF_INTERVALS; ++i)
+        {
+            const float t = float(i) / NUMBER_OF_INTERVALS;
+            const QVector2D current = bezier->PositionAt(t);
+
+            segments.push_back({ previous, current, patchIndex, float(i - 1) / NUMBER_OF_INTERVALS, t });
+            previous = current;
+        }
+    };
+
+    for (const auto& curve : mCurveContainer->GetCurves())
+    {
+        if (const auto bezier = std::dynamic_pointer_cast<Bezier>(curve))
+        {
+            append(bezier);
+        }
+        else if (const auto spline = std::dynamic_pointer_cast<Spline>(curve))
+        {
+            for (const auto& patch : spline->GetBezierPatches())
+            {
+                append(patch);
+            }
+        }
+        else
+        {
+            DCR_EXIT_FAILURE("WalkOnSpheres::Build: Undefined curve type. Implement this branch!");
+        }
+    }
+
+    mBvh.Build(std::move(segments));
+
+    // Walks that leave the scene are mirrored back, which mimics the clamped borders of the diffusion framebuffer
+    const QRectF box = mCurveContainer->GetBoundingBox();
+    const qreal margin = 0.5 * std::max(box.width(), box.height()) + 1.0;
+    mBounds = box.adjusted(-margin, -margin, margin, margin);
+
+    mVersion = mCurveContainer->GetVersion();
+    mBuilt = true;
+
+    SetQueryPoints(mQueryPoints);
+}
+
+bool DiffusionCurveRenderer::WalkOnSpheres::IsOutdated() const
+{
+    return mBuilt == false || mCurveContainer->GetVersion() != mVersion;
+}
+
+void DiffusionCurveRenderer::WalkOnSpheres::SetQueryPoints(const QVector<QVector2D>& points)
+{
+    mQueryPoints = points;
+    mSums.assign(points.size(), QVector4D(0, 0, 0, 0));
+    mSampleCount = 0;
+}
+
+void DiffusionCurveRenderer::WalkOnSpheres::Refine(int walksPerPoint)
+{
+    if (mBvh.GetNumberOfSegments() == 0 || walksPerPoint <= 0)
+        return;
+
+    MEASURE_CALL_TIME(WALK_ON_SPHERES);
+
+    Parallel::For(int(mQueryPoints.size()), 1, [&](int begin, int end) { //
+        for (int i = begin; i < end; ++i)
+        {
+            // Seeded from the point and the pass, so estimates do not depend on the thread count
+            uint64_t state = (uint64_t(i) << 32) ^ uint64_t(mSampleCount);
+            SplitMix64(state);
+
+            QVector4D sum(0, 0, 0, 0);
+
+            for (int j = 0; j < walksPerPoint; ++j)
+                sum += Walk(mQueryPoints[i], state);
+
+            mSums[i] += sum;
+        }
+    });
+
+    mSampleCount += walksPerPoint;
+}
+
+QVector<QVector4D> DiffusionCurveRenderer::WalkOnSpheres::GetEstimates() const
+{
+    QVector<QVector4D> estimates(mQueryPoints.size(), QVector4D(0, 0, 0, 0));
+
+    if (mSampleCount == 0)
+        return estimates;
+
+    for (int i = 0; i < estimates.size(); ++i)
+        estimates[i] = mSums[i] / float(mSampleCount);
+
+    return estimates;
+}
+
+QVector4D DiffusionCurveRenderer::WalkOnSpheres::Walk(QVector2D position, uint64_t& state) const
+{
+    ClosestSegmentPoint closest;
+
+    for (int step = 0; step < mMaximumSteps; ++step)
+    {
+        position = Fold(position);
+
+        mBvh.FindClosest(position, closest);
+
+        if (closest.distance < mEpsilon)
+            break;
+
+        const float angle = 2.0f * std::numbers::pi_v<float> * NextUniform(state);
+        position += closest.distance * QVector2D(std::cos(angle), std::sin(angle));
+    }
+
+    // Out of steps, the nearest curve is the best guess
+    if (closest.distance >= mEpsilon)
+    {
+        position = Fold(position);
+        mBvh.FindClosest(position, closest);
+    }
+
+    return ColorAt(position, closest);
+}
+
+QVector4D DiffusionCurveRenderer::WalkOnSpheres::ColorAt(const QVector2D& position, const ClosestSegmentPoint& closest) const
+{
+    const CurveSegment& segment = mBvh.GetSegment(closest.segment);
+    const Patch& patch = mPatches[segment.patch];
+
+    // Same orientation as the strips in Color.geom, left colors are on the -normal side
+    const QVector2D direction = segment.end - segment.start;
+    const QVector2D normal(-direction.y(), direction.x());
+
+    if (QVector2D::dotProduct(position - closest.position, normal) < 0.0f)
+        return Util::InterpolateColor(patch.leftColors, patch.leftColorPositions, closest.t);
+    else
+        return Util::InterpolateColor(patch.rightColors, patch.rightColorPositions, closest.t);
+}
+
+QVector2D DiffusionCurveRenderer::WalkOnSpheres::Fold(const QVector2D& position) const
+{
+    return QVector2D(Reflect(position.x(), mBounds.left(), mBounds.right()), Reflect(position.y(), mBounds.top(), mBounds.bottom()));
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Core/CurveBvh.h"
+#include "Core/CurveContainer.h"
+#include "Util/Macros.h"
+
+#include <QRectF>
+#include <QVector4D>
+#include <QVector>
+#include <cstdint>
+#include <vector>
+
+namespace DiffusionCurveRenderer
+{
+    // Grid free Monte Carlo evaluation of the diffused colors at arbitrary points. Each walk jumps to a random
+    // point on the largest circle around the current position that does not cross a curve, until it lands
+    // within Epsilon of a curve and takes the color of the side it approached from. The mean over walks
+    // converges to the harmonic interpolant of the curve colors, so estimates get sharper with every Refine().
+    class WalkOnSpheres
+    {
+      public:
+        WalkOnSpheres() = default;
+
+        // Snapshots the curve geometry and colors, must be called again after the curves change
+        void Build();
+        bool IsOutdated() const;
+
+        // Resets the estimates
+        void SetQueryPoints(const QVector<QVector2D>& points);
+
+        // Adds walksPerPoint walks to every query point, points are processed in parallel
+        void Refine(int walksPerPoint);
+
+        QVector<QVector4D> GetEstimates() const;
+        int GetSampleCount() const { return mSampleCount; }
+
+      private:
+        struct Patch
+        {
+            QVector<QVector4D> leftColors;
+            QVector<float> leftColorPositions;
+            QVector<QVector4D> rightColors;
+            QVector<float> rightColorPositions;
+        };
+
+        QVector4D Walk(QVector2D position, uint64_t& state) const;
+        QVector4D ColorAt(const QVector2D& position, const ClosestSegmentPoint& closest) const;
+        QVector2D Fold(const QVector2D& position) const;
+
+        CurveBvh mBvh;
+        std::vector<Patch> mPatches;
+        QRectF mBounds;
+        uint64_t mVersion{ 0 };
+        bool mBuilt{ false };
+
+        QVector<QVector2D> mQueryPoints;
+        std::vector<QVector4D> mSums;
+        int mSampleCount{ 0 };
+
+        DEFINE_MEMBER(float, Epsilon, 0.25f);
+        DEFINE_MEMBER(int, MaximumSteps, 256);
+        DEFINE_MEMBER_PTR(CurveContainer, CurveContainer);
+    };
+}
@@ -14,8 +14,17 @@ DiffusionCurveRenderer::Window::Window(QWindow* parent)
     format.setSamples(8);
     setFormat(format);
 
+    mStartupTimer.start();
+
     connect(this, &QOpenGLWindow::frameSwapped, [=]()
-            { update(); });
+            {
+                if (mFirstFrameSwapped == false)
+                {
+                    mFirstFrameSwapped = true;
+                    LOG_INFO("Window::frameSwapped: Time to first frame is {} ms.", mStartupTimer.elapsed());
+                }
+
+                update(); });
 }
 
 void DiffusionCurveRenderer::Window::initializeGL()
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <QElapsedTimer>
 #include <QInputEvent>
 #include <QOpenGLExtraFunctions>
 #include <QOpenGLWindow>
@@ -40,5 +41,8 @@ namespace DiffusionCurveRenderer
       private:
         long long mPreviousTime;
         long long mCurrentTime;
+
+        QElapsedTimer mStartupTimer; // Time to first frame, from the creation of the window to the first swap
+        bool mFirstFrameSwapped{ false };
     };
 }
@@ -4,6 +4,7 @@
 #include "Util/Logger.h"
 
 #include <QObject>
+#include <algorithm>
 
 QVector2D DiffusionCurveRenderer::Bezier::PositionAt(float t) const
 {
@@ -42,8 +43,59 @@ QVector2D DiffusionCurveRenderer::Bezier::NormalAt(float t) const
     return QVector2D(-tangent.y(), tangent.x());
 }
 
+void DiffusionCurveRenderer::Bezier::EvaluateAt(const QVector<float>& parameters, QVector<QVector2D>& positions, QVector<QVector2D>* normals) const
+{
+    const int n = GetDegree();
+    const QVector<float> coefficients = GetCoefficients();
+    const QVector<float> derivativeCoefficients = GetDerivativeCoefficients();
+
+    // powers[i] = t^i and complementPowers[i] = (1 - t)^i
+    QVector<float> powers(n + 1);
+    QVector<float> complementPowers(n + 1);
+
+    positions.resize(parameters.size());
+
+    if (normals)
+        normals->resize(parameters.size());
+
+    for (int j = 0; j < parameters.size(); ++j)
+    {
+        const float t = parameters[j];
+
+        powers[0] = 1.0f;
+        complementPowers[0] = 1.0f;
+
+        for (int i = 1; i <= n; ++i)
+        {
+            powers[i] = powers[i - 1] * t;
+            complementPowers[i] = complementPowers[i - 1] * (1 - t);
+        }
+
+        QVector2D position(0, 0);
+
+        for (int i = 0; i <= n; ++i)
+            position += coefficients[i] * powers[i] * complementPowers[n - i] * mControlPoints[i]->position;
+
+        positions[j] = position;
+
+        if (normals == nullptr)
+            continue;
+
+        // Same orientation as TangentAt() and NormalAt()
+        QVector2D tangent(0, 0);
+
+        for (int i = 0; i <= n - 1; ++i)
+            tangent += derivativeCoefficients[i] * powers[i] * complementPowers[n - 1 - i] * (mControlPoints[i]->position - mControlPoints[i + 1]->position);
+
+        tangent.normalize();
+
+        (*normals)[j] = QVector2D(-tangent.y(), tangent.x());
+    }
+}
+
 void DiffusionCurveRenderer::Bezier::Update()
 {
+    ++mVersion;
     mControlPointsDirty = true;
     mLeftColorsDirty = true;
     mLeftColorPositionsDirty = true;
@@ -68,16 +120,11 @@ QVector2D DiffusionCurveRenderer::Bezier::GetControlPointPosition(int index) con
 
 DiffusionCurveRenderer::ControlPointPtr DiffusionCurveRenderer::Bezier::AddControlPoint(const QVector2D& position)
 {
-    if (mControlPoints.size() >= 32)
-    {
-        LOG_WARN("Bezier::AddControlPoint: ControlPoint could not be added because the total number of ControlPoints is 32.");
-        return nullptr;
-    }
-
     ControlPointPtr point = std::make_shared<ControlPoint>();
     point->position = position;
     mControlPoints << point;
     mControlPointsDirty = true;
+    ++mVersion;
     return point;
 }
 
@@ -243,8 +290,9 @@ int DiffusionCurveRenderer::Bezier::GetNumberOfBlurPoints() const
 
 void DiffusionCurveRenderer::Bezier::SortColorPoints()
 {
-    std::sort(mColorPoints.begin(), mColorPoints.end(), [](ColorPointPtr a, const ColorPointPtr b)
-              { return a->position < b->position; });
+    // Stable, points added at the same position keep their order
+    std::stable_sort(mColorPoints.begin(), mColorPoints.end(), [](ColorPointPtr a, const ColorPointPtr b)
+                     { return a->position < b->position; });
 }
 
 void DiffusionCurveRenderer::Bezier::SortBlurPoints()
@@ -281,23 +329,19 @@ QVector<float> DiffusionCurveRenderer::Bezier::GetDerivativeCoefficients() const
     return coefficients;
 }
 
-float DiffusionCurveRenderer::Bezier::Factorial(int n) const
+double DiffusionCurveRenderer::Bezier::Choose(int n, int k) const
 {
+    // Multiplicative, n! alone overflows a float from n = 35 on
     double result = 1.0;
 
-    for (int i = 1; i <= n; ++i)
+    for (int i = 1; i <= k; ++i)
     {
-        result *= float(i);
+        result *= double(n - k + i) / i;
     }
 
     return result;
 }
 
-float DiffusionCurveRenderer::Bezier::Choose(int n, int k) const
-{
-    return Factorial(n) / (Factorial(k) * Factorial(n - k));
-}
-
 int DiffusionCurveRenderer::Bezier::GetOrder() const
 {
     return mControlPoints.size();
@@ -317,12 +361,6 @@ void DiffusionCurveRenderer::Bezier::RemoveAllControlPoints()
 
 DiffusionCurveRenderer::ColorPointPtr DiffusionCurveRenderer::Bezier::AddColorPoint(ColorPointType type, const QVector4D& color, float position)
 {
-    if (mColorPoints.size() >= 16)
-    {
-        LOG_WARN("Bezier::AddColorPoint: ColorPoint could not be added because the total number of ColorPoints is 16.");
-        return nullptr;
-    }
-
     ColorPointPtr point = std::make_shared<ColorPoint>(type, color, position);
     mColorPoints << point;
     SortColorPoints();
@@ -331,6 +369,15 @@ DiffusionCurveRenderer::ColorPointPtr DiffusionCurveRenderer::Bezier::AddColorPo
     return point;
 }
 
+void DiffusionCurveRenderer::Bezier::AddColorPoints(const QVector<ColorPoint>& points)
+{
+    for (const auto& point : points)
+        mColorPoints << std::make_shared<ColorPoint>(point);
+
+    SortColorPoints();
+    Update();
+}
+
 bool DiffusionCurveRenderer::Bezier::RemoveColorPoint(ColorPointPtr point)
 {
     int index = -1;
@@ -357,12 +404,6 @@ bool DiffusionCurveRenderer::Bezier::RemoveColorPoint(ColorPointPtr point)
 
 DiffusionCurveRenderer::BlurPointPtr DiffusionCurveRenderer::Bezier::AddBlurPoint(float position, float strength)
 {
-    if (mBlurPoints.size() >= 16)
-    {
-        LOG_WARN("Bezier::AddBlurPoint: BlurPoint could not be added because the total number of BlurPoints is 16.");
-        return nullptr;
-    }
-
     BlurPointPtr point = std::make_shared<BlurPoint>(position, strength);
     mBlurPoints << point;
     SortBlurPoints();
@@ -506,7 +547,7 @@ QJsonObject DiffusionCurveRenderer::Bezier::ToJsonObject()
         QJsonObject object;
         object.insert("p", point->position);
         object.insert("s", point->strength);
-        colorPoints.append(object);
+        blurPoints.append(object);
     }
 
     QJsonObject object;
@@ -45,6 +45,13 @@ namespace DiffusionCurveRenderer
         ColorPointPtr FindColorPointAround(const QVector2D& test, float offset, float tolerance) override;
 
         // Bezier
+        // Positions, and unit normals if <normals> is not null, at every parameter. Bernstein coefficients and control
+        // points are looked up once for all parameters instead of once per PositionAt() and NormalAt() call.
+        void EvaluateAt(const QVector<float>& parameters, QVector<QVector2D>& positions, QVector<QVector2D>* normals = nullptr) const;
+
+        // Adds all points and sorts once, ties keep their order as if they were added one by one
+        void AddColorPoints(const QVector<ColorPoint>& points);
+
         QVector4D GetLeftColorAt(float t);
         QVector4D GetRightColorAt(float t);
 
@@ -83,8 +90,7 @@ namespace DiffusionCurveRenderer
       private:
         QVector<float> GetCoefficients() const;
         QVector<float> GetDerivativeCoefficients() const;
-        float Factorial(int n) const;
-        float Choose(int n, int k) const;
+        double Choose(int n, int k) const;
 
         QVector<ControlPointPtr> mControlPoints;
         QVector<ColorPointPtr> mColorPoints;
@@ -7,6 +7,7 @@
 #include <QVector2D>
 #include <QVector4D>
 #include <QVector>
+#include <cstdint>
 #include <memory>
 
 namespace DiffusionCurveRenderer
@@ -82,6 +83,9 @@ namespace DiffusionCurveRenderer
         DEFINE_MEMBER(float, ContourThickness, DEFAULT_CONTOUR_THICKNESS);
         DEFINE_MEMBER(float, DiffusionWidth, DEFAULT_DIFFUSION_WIDTH);
         DEFINE_MEMBER(float, DiffusionGap, DEFAULT_DIFFUSION_GAP);
+
+        // Incremented whenever the geometry of the curve changes
+        DEFINE_MEMBER_CONST(uint64_t, Version, 0);
     };
 
     using CurvePtr = std::shared_ptr<Curve>;
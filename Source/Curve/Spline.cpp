@@ -134,6 +134,8 @@ void DiffusionCurveRenderer::Spline::RemoveControlPoint(int index)
 
 void DiffusionCurveRenderer::Spline::Update()
 {
+    ++mVersion;
+
     if (mIsPointAddedOrRemoved)
     {
         SaveColorPoints();
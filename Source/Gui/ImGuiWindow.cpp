@@ -2,9 +2,12 @@
 
 #include "Core/CurveContainer.h"
 #include "Core/OrthographicCamera.h"
+#include "Core/WalkOnSpheres.h"
+#include "Renderer/DiffusionRenderer/Solvers/DiffusionSolverFactory.h"
 #include "Renderer/RendererManager.h"
 #include "Util/Chronometer.h"
 #include "Util/Logger.h"
+#include "Util/Tracer.h"
 
 #include <QFileDialog>
 #include <QtImGui.h>
@@ -25,6 +28,7 @@ void DiffusionCurveRenderer::ImGuiWindow::Draw()
     mSmoothIterations = mRendererManager->GetSmoothIterations();
     mFrambufferSize = mRendererManager->GetFramebufferSize();
     mFrambufferSizeIndex = std::log2(mFrambufferSize / 1024);
+    mDiffusionSolverIndex = DiffusionSolverFactory::GetTypes().indexOf(mRendererManager->GetDiffusionSolverType());
 
     ImGui::Begin("Controls", nullptr, ImGuiWindowFlags_MenuBar);
     DrawMenuBar();
@@ -42,6 +46,8 @@ void DiffusionCurveRenderer::ImGuiWindow::Draw()
     // Draw popups
     DrawAboutPopup();
     DrawShortcutsPopup();
+    DrawTiledExportPopup();
+    DrawTiledExportProgress();
 }
 
 void DiffusionCurveRenderer::ImGuiWindow::DrawWorkModes()
@@ -97,9 +103,15 @@ void DiffusionCurveRenderer::ImGuiWindow::DrawVectorizationViewOptions()
                 ImGui::RadioButton("Spline", &option, 1);
                 mVectorizationCurveType = VectorizationCurveType(option);
 
+                int tracer = static_cast<int>(mEdgeTracerType);
+                ImGui::Text("Choose edge tracer:");
+                ImGui::RadioButton("Sequential", &tracer, 0);
+                ImGui::RadioButton("Parallel (Components)", &tracer, 1);
+                mEdgeTracerType = EdgeTracerType(tracer);
+
                 if (ImGui::Button("Vectorize"))
                 {
-                    emit Vectorize(mVectorizationCurveType, mEdgeStackLayer);
+                    emit Vectorize(mVectorizationCurveType, mEdgeTracerType, mEdgeStackLayer);
                 }
             }
         }
@@ -132,6 +144,15 @@ void DiffusionCurveRenderer::ImGuiWindow::DrawVectorizationViewOptions()
         }
 
         ImGui::ProgressBar(mVectorizationProgress);
+
+        // The stacks are built on load, only the stages of a vectorization can be cancelled
+        if (mVectorizationStage >= VectorizationStage::EdgeTracer)
+        {
+            if (ImGui::Button("Cancel##Vectorization"))
+            {
+                emit CancelVectorization();
+            }
+        }
     }
 }
 
@@ -143,6 +164,7 @@ void DiffusionCurveRenderer::ImGuiWindow::DrawCurveEditingSettings()
     DrawCurveHeader();
     DrawRenderSettings();
     DrawStats();
+    DrawInspector();
 }
 
 void DiffusionCurveRenderer::ImGuiWindow::DrawMenuBar()
@@ -233,6 +255,11 @@ void DiffusionCurveRenderer::ImGuiWindow::DrawMenuBar()
                 }
             }
 
+            if (ImGui::MenuItem("Export Large Image...", nullptr, false, mTiledExportRunning == false))
+            {
+                mShowTiledExportPopup = true;
+            }
+
             if (ImGui::MenuItem("Export as JSON", "Ctrl+E"))
             {
                 QString path = QFileDialog::getSaveFileName(nullptr, "JSON File", "", "*.json");
@@ -331,6 +358,27 @@ void DiffusionCurveRenderer::ImGuiWindow::DrawMenuBar()
             ImGui::EndMenu();
         }
         
+        if (ImGui::BeginMenu("Profiling"))
+        {
+            if (ImGui::MenuItem("Record Trace", nullptr, Tracer::IsEnabled()))
+            {
+                emit TraceRecordingChanged(!Tracer::IsEnabled());
+            }
+
+            if (ImGui::MenuItem("Export Trace"))
+            {
+                QString path = QFileDialog::getSaveFileName(nullptr, "Chrome Trace File", "", "*.json");
+
+                if (path.isNull() == false)
+                {
+                    qDebug() << "ImGuiWindow::DrawMenuBar(Export Trace): Path is" << path;
+                    emit ExportTrace(path);
+                }
+            }
+
+            ImGui::EndMenu();
+        }
+
         if (ImGui::BeginMenu("Help"))
         {
             if (ImGui::MenuItem("Keyboard Shortcuts", "F1"))
@@ -444,7 +492,11 @@ void DiffusionCurveRenderer::ImGuiWindow::DrawCurveHeader()
             ImGui::Text("Color Point");
 
             ImGui::Text("Direction: %s", mSelectedColorPoint->type == ColorPointType::Left ? "Left" : "Right");
-            ImGui::SliderFloat("Position", &mSelectedColorPoint->position, 0.0f, 1.0f);
+
+            if (ImGui::SliderFloat("Position", &mSelectedColorPoint->position, 0.0f, 1.0f))
+            {
+                mSelectedCurve->Update();
+            }
 
             if (ImGui::ColorEdit4("Color", &mSelectedColorPoint->color[0]))
             {
@@ -483,6 +535,19 @@ void DiffusionCurveRenderer::ImGuiWindow::DrawRenderSettings()
         if (ImGui::SliderFloat("Global Diffusion Gap", &mGlobalDiffusionGap, 0.5f, 4.0f))
             mCurveContainer->SetGlobalDiffusionGap(mGlobalDiffusionGap);
 
+        const auto& solverTypes = DiffusionSolverFactory::GetTypes();
+
+        if (ImGui::BeginCombo("Diffusion Solver", DiffusionSolverFactory::GetName(solverTypes[mDiffusionSolverIndex])))
+        {
+            for (int i = 0; i < solverTypes.size(); ++i)
+            {
+                if (ImGui::Selectable(DiffusionSolverFactory::GetName(solverTypes[i]), i == mDiffusionSolverIndex))
+                    mRendererManager->SetDiffusionSolverType(solverTypes[i]);
+            }
+
+            ImGui::EndCombo();
+        }
+
         if (ImGui::Checkbox("Use Multisample Framebuffer", &mUseMultisampleFramebuffer))
             emit UseMultisampleFramebufferChanged(mUseMultisampleFramebuffer);
 
@@ -525,6 +590,64 @@ void DiffusionCurveRenderer::ImGuiWindow::DrawStats()
         ImGui::Text("Performance Timings:");
         for (const auto& ID : ALL_CHORONOMETER_IDs)
             ImGui::Text("  %s", Chronometer::Print(ID).c_str());
+
+        ImGui::Separator();
+        ImGui::Text("GPU Timings:");
+        for (const auto& name : Chronometer::GetNames())
+            if (name.starts_with(GPU_CHORONOMETER_PREFIX))
+                ImGui::Text("  %s", Chronometer::Print(name).c_str());
+    }
+}
+
+void DiffusionCurveRenderer::ImGuiWindow::DrawInspector()
+{
+    if (ImGui::CollapsingHeader("Inspector"))
+    {
+        ImGui::Checkbox("Inspect Color Under Cursor", &mShowInspector);
+
+        if (mShowInspector == false || mCamera == nullptr)
+            return;
+
+        if (mWalkOnSpheres == nullptr)
+        {
+            mWalkOnSpheres = new WalkOnSpheres;
+            mWalkOnSpheres->SetCurveContainer(mCurveContainer);
+        }
+
+        if (mWalkOnSpheres->IsOutdated())
+            mWalkOnSpheres->Build();
+
+        // Keep the last point while the cursor is over the controls
+        if (ImGui::GetIO().WantCaptureMouse == false)
+        {
+            const ImVec2 mouse = ImGui::GetIO().MousePos;
+            const QVector2D point = mCamera->CameraToWorld(mouse.x, mouse.y);
+
+            if (point != mInspectedPoint || mWalkOnSpheres->GetSampleCount() == 0)
+            {
+                mInspectedPoint = point;
+                mWalkOnSpheres->SetQueryPoints({ mInspectedPoint });
+            }
+        }
+
+        if (mWalkOnSpheres->GetSampleCount() < INSPECTOR_MAXIMUM_WALKS)
+            mWalkOnSpheres->Refine(INSPECTOR_WALKS_PER_FRAME);
+
+        if (mWalkOnSpheres->GetSampleCount() == 0)
+        {
+            ImGui::Text("No curves to inspect.");
+            return;
+        }
+
+        const QVector4D color = mWalkOnSpheres->GetEstimates().first();
+
+        ImGui::ColorButton("##InspectedColor", ImVec4(color.x(), color.y(), color.z(), color.w()), ImGuiColorEditFlags_AlphaPreview, ImVec2(40, 40));
+        ImGui::SameLine();
+        ImGui::BeginGroup();
+        ImGui::Text("Position: (%.1f, %.1f)", mInspectedPoint.x(), mInspectedPoint.y());
+        ImGui::Text("RGBA: (%.3f, %.3f, %.3f, %.3f)", color.x(), color.y(), color.z(), color.w());
+        ImGui::Text("Walks: %d", mWalkOnSpheres->GetSampleCount());
+        ImGui::EndGroup();
     }
 }
 
@@ -672,6 +795,79 @@ void DiffusionCurveRenderer::ImGuiWindow::DrawAboutPopup()
     }
 }
 
+void DiffusionCurveRenderer::ImGuiWindow::DrawTiledExportPopup()
+{
+    if (mShowTiledExportPopup)
+    {
+        ImGui::OpenPopup("Export Large Image");
+        mShowTiledExportPopup = false;
+    }
+
+    if (ImGui::BeginPopupModal("Export Large Image", nullptr, ImGuiWindowFlags_AlwaysAutoResize))
+    {
+        // The current view is exported, so the height follows from its aspect ratio
+        ImGui::InputInt("Width", &mTiledExportWidth, 1024, 4096);
+        mTiledExportWidth = qBound(256, mTiledExportWidth, 65536);
+
+        const int height = qMax(1, qRound(mTiledExportWidth * float(mCamera->GetHeight()) / mCamera->GetWidth()));
+        ImGui::Text("Height: %d", height);
+
+        ImGui::Combo("Format", &mTiledExportFormatIndex, TILED_EXPORT_FORMATS, 2);
+        ImGui::Combo("Tile Size", &mTiledExportTileSizeIndex, TILE_SIZES, 3);
+
+        const bool deepZoom = mTiledExportFormatIndex == 1;
+
+        if (deepZoom)
+            ImGui::TextDisabled("Writes a .dzi file and 256 pixel tiles for web viewers, unchanged tiles are reused.");
+        else
+            ImGui::TextDisabled("Diffusion is solved on the CPU, TIFF is recommended for large prints.");
+
+        if (ImGui::Button("Export", ImVec2(120, 0)))
+        {
+            QString path = deepZoom ? QFileDialog::getSaveFileName(nullptr, "Deep Zoom Image", "", "*.dzi") : QFileDialog::getSaveFileName(nullptr, "Image File", "", "*.tif *.tiff *.png");
+
+            if (path.isNull() == false)
+            {
+                qDebug() << "ImGuiWindow::DrawTiledExportPopup: Path is" << path;
+
+                const int tileSize = QString(TILE_SIZES[mTiledExportTileSizeIndex]).toInt();
+
+                if (deepZoom)
+                    emit ExportDeepZoom(path, mTiledExportWidth, height, tileSize);
+                else
+                    emit ExportTiled(path, mTiledExportWidth, height, tileSize);
+
+                ImGui::CloseCurrentPopup();
+            }
+        }
+
+        ImGui::SameLine();
+
+        if (ImGui::Button("Close", ImVec2(120, 0)))
+        {
+            ImGui::CloseCurrentPopup();
+        }
+
+        ImGui::EndPopup();
+    }
+}
+
+void DiffusionCurveRenderer::ImGuiWindow::DrawTiledExportProgress()
+{
+    if (mTiledExportRunning == false)
+        return;
+
+    ImGui::Begin("Exporting", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoCollapse);
+    ImGui::ProgressBar(mTiledExportProgress, ImVec2(240, 0));
+
+    if (ImGui::Button("Cancel"))
+    {
+        emit CancelTiledExport();
+    }
+
+    ImGui::End();
+}
+
 void DiffusionCurveRenderer::ImGuiWindow::DrawShortcutsPopup()
 {
     if (mShowShortcutsPopup)
@@ -13,6 +13,7 @@ namespace DiffusionCurveRenderer
     class CurveContainer;
     class RendererManager;
     class OrthographicCamera;
+    class WalkOnSpheres;
 
     class ImGuiWindow : public QObject
     {
@@ -33,6 +34,7 @@ namespace DiffusionCurveRenderer
         int GetEdgeStackLayer() const { return mEdgeStackLayer; }
 
         void SetVectorizationViewOption(VectorizationViewOption option);
+        VectorizationViewOption GetVectorizationViewOption() const { return mVectorizationViewOption; }
         void SetRenderMode(RenderMode mode, bool on);
         
         void AddRecentFile(const QString& path);
@@ -48,6 +50,9 @@ namespace DiffusionCurveRenderer
 
         void ImportXml(const QString& path);
         void SaveAsPng(const QString& path);
+        void ExportTiled(const QString& path, int width, int height, int tileSize);
+        void ExportDeepZoom(const QString& path, int width, int height, int tileSize);
+        void CancelTiledExport();
         void ImportJson(const QString& path);
         void ExportAsJson(const QString& path);
 
@@ -57,7 +62,8 @@ namespace DiffusionCurveRenderer
         void GaussianStackLayerChanged(int layer);
         void EdgeStackLayerChanged(int layer);
         void LoadImage(const QString& path);
-        void Vectorize(VectorizationCurveType curveType, int edgeLevel);
+        void Vectorize(VectorizationCurveType curveType, EdgeTracerType tracerType, int edgeLevel);
+        void CancelVectorization();
         void ShowColorPointHandlesChanged(bool value);
         
         // New signals for enhanced features
@@ -68,6 +74,10 @@ namespace DiffusionCurveRenderer
         void ResetView();
         void ThemeChanged(UITheme theme);
 
+        // Profiling
+        void TraceRecordingChanged(bool enabled);
+        void ExportTrace(const QString& path);
+
       private:
         void DrawWorkModes();
         void DrawVectorizationViewOptions();
@@ -78,9 +88,12 @@ namespace DiffusionCurveRenderer
         void DrawCurveHeader();
         void DrawRenderSettings();
         void DrawStats();
+        void DrawInspector();
         void DrawViewSettings();
         void DrawAboutPopup();
         void DrawShortcutsPopup();
+        void DrawTiledExportPopup();
+        void DrawTiledExportProgress();
         void SetGaussianStackLayer(int layer);
         void ApplyTheme(UITheme theme);
 
@@ -96,6 +109,7 @@ namespace DiffusionCurveRenderer
         int mFrambufferSize;
         int mFrambufferSizeIndex;
         bool mUseMultisampleFramebuffer{ false };
+        int mDiffusionSolverIndex{ 0 };
 
         WorkMode mWorkMode{ WorkMode::CurveEditing };
         VectorizationStage mVectorizationStage{ VectorizationStage::Initial };
@@ -111,6 +125,7 @@ namespace DiffusionCurveRenderer
         bool mShowColorPointHandles{ true };
 
         VectorizationCurveType mVectorizationCurveType{ VectorizationCurveType::Bezier };
+        EdgeTracerType mEdgeTracerType{ EdgeTracerType::Components };
         
         // New UI state
         UITheme mCurrentTheme{ UITheme::Dark };
@@ -119,9 +134,20 @@ namespace DiffusionCurveRenderer
         float mGridSpacing{ 50.0f };
         bool mShowAboutPopup{ false };
         bool mShowShortcutsPopup{ false };
+        bool mShowTiledExportPopup{ false };
+        int mTiledExportWidth{ 16384 };
+        int mTiledExportTileSizeIndex{ 1 };
+        int mTiledExportFormatIndex{ 0 };
         QStringList mRecentFiles;
         static constexpr int MAX_RECENT_FILES = 10;
 
+        // Color inspector, estimates the diffused color under the cursor independent of the framebuffer
+        WalkOnSpheres* mWalkOnSpheres{ nullptr };
+        bool mShowInspector{ false };
+        QVector2D mInspectedPoint;
+        static constexpr int INSPECTOR_WALKS_PER_FRAME = 64;
+        static constexpr int INSPECTOR_MAXIMUM_WALKS = 4096;
+
         DEFINE_MEMBER(float, VectorizationProgress, 0.0f); // [0,1]
         DEFINE_MEMBER(int, MaximumGaussianStackLayer, 10);
         DEFINE_MEMBER(int, MaximumEdgeStackLayer, 10);
@@ -130,7 +156,11 @@ namespace DiffusionCurveRenderer
         DEFINE_MEMBER_PTR(RendererManager, RendererManager);
         DEFINE_MEMBER_PTR(OrthographicCamera, Camera);
         DEFINE_MEMBER(bool, ImageLoaded, false);
+        DEFINE_MEMBER(bool, TiledExportRunning, false);
+        DEFINE_MEMBER(float, TiledExportProgress, 0.0f); // [0,1]
 
         static constexpr const char* FRAME_BUFFER_SIZES[3] = { "1024", "2048", "4096" };
+        static constexpr const char* TILE_SIZES[3] = { "1024", "2048", "4096" };
+        static constexpr const char* TILED_EXPORT_FORMATS[2] = { "Image", "Deep Zoom" };
     };
 }
\ No newline at end of file
@@ -1,7 +1,10 @@
+#include "Core/Constants.h"
 #include "Core/Controller.h"
 #include "Util/Logger.h"
+#include "Util/Tracer.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QImageReader>
 
 using namespace DiffusionCurveRenderer;
@@ -12,9 +15,44 @@ int main(int argc, char* argv[])
 
     qInstallMessageHandler(Logger::QtMessageOutputCallback);
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+
+    QCommandLineOption traceOption("trace", "Records a Chrome trace of the session and writes it to <file> on exit.", "file");
+    QCommandLineOption vectorizationMemoryOption("vectorization-memory",
+                                                 "Megabytes the Gaussian stack of the vectorization may keep, including the image.",
+                                                 "megabytes",
+                                                 QString::number(DEFAULT_GAUSSIAN_STACK_MEMORY_BUDGET >> 20));
+
+    parser.addOption(traceOption);
+    parser.addOption(vectorizationMemoryOption);
+    parser.process(app);
+
+    const QString tracePath = parser.value(traceOption);
+
+    if (tracePath.isEmpty() == false)
+    {
+        Tracer::SetEnabled(true);
+    }
+
     Controller controller;
 
+    bool valid = false;
+    const qulonglong megabytes = parser.value(vectorizationMemoryOption).toULongLong(&valid);
+
+    if (valid)
+        controller.SetVectorizationMemoryBudget(size_t(megabytes) << 20);
+    else
+        LOG_WARN("main: Invalid --vectorization-memory '{}', using the default.", parser.value(vectorizationMemoryOption).toStdString());
+
     controller.Run();
 
-    return app.exec();
+    const int result = app.exec();
+
+    if (tracePath.isEmpty() == false)
+    {
+        Tracer::Dump(tracePath.toStdString());
+    }
+
+    return result;
 }
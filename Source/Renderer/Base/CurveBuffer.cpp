@@ -0,0 +1,110 @@
+#include "CurveBuffer.h"
+
+#include "Util/Logger.h"
+
+#include <algorithm>
+
+DiffusionCurveRenderer::CurveBuffer::CurveBuffer()
+{
+    initializeOpenGLFunctions();
+
+    glGenBuffers(1, &mControlPointsBuffer);
+    glGenBuffers(1, &mBlurPointsBuffer);
+
+    // Buffers always have a data store, scenes without blur points still bind one
+    Upload(mControlPointsBuffer, mControlPointsCapacity, mControlPoints);
+    Upload(mBlurPointsBuffer, mBlurPointsCapacity, mBlurPoints);
+}
+
+DiffusionCurveRenderer::CurveBuffer::~CurveBuffer()
+{
+    glDeleteBuffers(1, &mControlPointsBuffer);
+    glDeleteBuffers(1, &mBlurPointsBuffer);
+}
+
+void DiffusionCurveRenderer::CurveBuffer::Update(const QList<CurvePtr>& curves)
+{
+    mPatches.clear();
+    mControlPoints.clear();
+    mBlurPoints.clear();
+
+    for (const auto& curve : curves)
+    {
+        if (const auto bezier = std::dynamic_pointer_cast<Bezier>(curve))
+        {
+            Append(bezier);
+        }
+        else if (const auto spline = std::dynamic_pointer_cast<Spline>(curve))
+        {
+            for (const auto& patch : spline->GetBezierPatches())
+                Append(patch);
+        }
+        else
+        {
+            DCR_EXIT_FAILURE("CurveBuffer::Update: Undefined curve type. Implement this branch!");
+        }
+    }
+
+    // Unchanged scenes, the usual case while navigating, upload nothing
+    if (mControlPoints != mUploadedControlPoints)
+    {
+        Upload(mControlPointsBuffer, mControlPointsCapacity, mControlPoints);
+        std::swap(mControlPoints, mUploadedControlPoints);
+    }
+
+    if (mBlurPoints != mUploadedBlurPoints)
+    {
+        Upload(mBlurPointsBuffer, mBlurPointsCapacity, mBlurPoints);
+        std::swap(mBlurPoints, mUploadedBlurPoints);
+    }
+}
+
+void DiffusionCurveRenderer::CurveBuffer::Bind()
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CONTROL_POINTS_BINDING, mControlPointsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BLUR_POINTS_BINDING, mBlurPointsBuffer);
+}
+
+void DiffusionCurveRenderer::CurveBuffer::Release()
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CONTROL_POINTS_BINDING, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BLUR_POINTS_BINDING, 0);
+}
+
+void DiffusionCurveRenderer::CurveBuffer::Append(const BezierPtr& patch)
+{
+    Patch range;
+    range.controlPointsOffset = mControlPoints.size();
+    range.controlPointsCount = patch->GetNumberOfControlPoints();
+    range.blurPointsOffset = mBlurPoints.size();
+    range.blurPointsCount = patch->GetNumberOfBlurPoints();
+
+    mControlPoints << patch->GetControlPointPositions();
+
+    const auto& positions = patch->GetBlurPointPositions();
+    const auto& strengths = patch->GetBlurPointStrengths();
+
+    for (int i = 0; i < positions.size(); ++i)
+        mBlurPoints << QVector2D(positions[i], strengths[i]);
+
+    mPatches << range;
+}
+
+void DiffusionCurveRenderer::CurveBuffer::Upload(GLuint buffer, GLsizeiptr& capacity, const QVector<QVector2D>& data)
+{
+    const GLsizeiptr size = data.size() * sizeof(QVector2D);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+
+    // Grows geometrically, adding curves one by one does not reallocate every frame
+    if (capacity < size || capacity == 0)
+    {
+        capacity = std::max<GLsizeiptr>(2 * capacity, std::max<GLsizeiptr>(size, sizeof(QVector2D)));
+        glBufferData(GL_SHADER_STORAGE_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    if (size > 0)
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data.constData());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Curve/Spline.h"
+
+#include <QOpenGLExtraFunctions>
+#include <QVector2D>
+#include <QVector>
+
+namespace DiffusionCurveRenderer
+{
+    // Control points and blur points of the Bezier patches of a list of curves, packed into two shader storage
+    // buffers. Patches are numbered in the order the curves are drawn, GetPatch(i) gives the ranges the shaders read
+    // for the i-th one. A buffer is uploaded again only if its contents have changed since the last Update().
+    class CurveBuffer : protected QOpenGLExtraFunctions
+    {
+      public:
+        struct Patch
+        {
+            int controlPointsOffset;
+            int controlPointsCount;
+            int blurPointsOffset;
+            int blurPointsCount;
+        };
+
+        CurveBuffer();
+        ~CurveBuffer();
+
+        void Update(const QList<CurvePtr>& curves);
+
+        void Bind();
+        void Release();
+
+        const Patch& GetPatch(int index) const { return mPatches[index]; }
+
+        // Must match the layout bindings of the shaders
+        static constexpr GLuint CONTROL_POINTS_BINDING = 0;
+        static constexpr GLuint BLUR_POINTS_BINDING = 1; // (position, strength) pairs
+
+      private:
+        void Append(const BezierPtr& patch);
+        void Upload(GLuint buffer, GLsizeiptr& capacity, const QVector<QVector2D>& data);
+
+        QVector<Patch> mPatches;
+
+        QVector<QVector2D> mControlPoints;
+        QVector<QVector2D> mBlurPoints;
+        QVector<QVector2D> mUploadedControlPoints;
+        QVector<QVector2D> mUploadedBlurPoints;
+
+        GLuint mControlPointsBuffer{ 0 };
+        GLuint mBlurPointsBuffer{ 0 };
+        GLsizeiptr mControlPointsCapacity{ 0 };
+        GLsizeiptr mBlurPointsCapacity{ 0 };
+    };
+}
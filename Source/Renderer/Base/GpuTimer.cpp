@@ -0,0 +1,155 @@
+#include "GpuTimer.h"
+
+#include "Util/Chronometer.h"
+#include "Util/Logger.h"
+#include "Util/Tracer.h"
+
+DiffusionCurveRenderer::GpuTimer::GpuTimer()
+{
+    initializeOpenGLFunctions();
+
+    DCR_ASSERT(INSTANCE == nullptr);
+    INSTANCE = this;
+}
+
+DiffusionCurveRenderer::GpuTimer::~GpuTimer()
+{
+    for (auto& frame : mFrames)
+    {
+        if (frame.queries.empty() == false)
+        {
+            glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+        }
+    }
+
+    INSTANCE = nullptr;
+}
+
+void DiffusionCurveRenderer::GpuTimer::BeginFrame()
+{
+    mCurrentFrame = (mCurrentFrame + 1) % FRAME_LATENCY;
+
+    // This slot was filled FRAME_LATENCY frames ago, its results are most likely available by now
+    Frame& frame = mFrames[mCurrentFrame];
+    Collect(frame);
+
+    frame.scopes.clear();
+    frame.numberOfUsedQueries = 0;
+    frame.lastIssuedQuery = 0;
+    frame.isCalibrated = Tracer::IsEnabled();
+
+    if (frame.isCalibrated)
+    {
+        glGetInteger64v(GL_TIMESTAMP, &frame.gpuReference);
+        frame.cpuReference = Clock::now();
+    }
+}
+
+int DiffusionCurveRenderer::GpuTimer::Begin(ScopeId id)
+{
+    Frame& frame = mFrames[mCurrentFrame];
+
+    Scope scope;
+    scope.id = id;
+    scope.begin = AcquireQuery();
+    scope.end = AcquireQuery();
+
+    glQueryCounter(scope.begin, GL_TIMESTAMP);
+    frame.lastIssuedQuery = scope.begin;
+
+    frame.scopes.push_back(scope);
+
+    return static_cast<int>(frame.scopes.size()) - 1;
+}
+
+void DiffusionCurveRenderer::GpuTimer::End(int scope)
+{
+    Frame& frame = mFrames[mCurrentFrame];
+
+    DCR_ASSERT(0 <= scope && scope < static_cast<int>(frame.scopes.size()));
+
+    glQueryCounter(frame.scopes[scope].end, GL_TIMESTAMP);
+    frame.lastIssuedQuery = frame.scopes[scope].end;
+    frame.scopes[scope].ended = true;
+}
+
+GLuint DiffusionCurveRenderer::GpuTimer::AcquireQuery()
+{
+    Frame& frame = mFrames[mCurrentFrame];
+
+    if (frame.numberOfUsedQueries == static_cast<int>(frame.queries.size()))
+    {
+        GLuint query = 0;
+        glGenQueries(1, &query);
+        frame.queries.push_back(query);
+    }
+
+    return frame.queries[frame.numberOfUsedQueries++];
+}
+
+void DiffusionCurveRenderer::GpuTimer::Collect(Frame& frame)
+{
+    if (frame.scopes.empty())
+    {
+        return;
+    }
+
+    // Queries complete in submission order, so the last one issued tells whether the whole frame is ready
+    GLint available = 0;
+    glGetQueryObjectiv(frame.lastIssuedQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+
+    if (available == 0)
+    {
+        LOG_DEBUG("GpuTimer::Collect: GPU timings of a frame are dropped because they are not available yet.");
+        return;
+    }
+
+    for (const auto& scope : frame.scopes)
+    {
+        // Its end query was never issued, reading it would fail
+        if (scope.ended == false)
+        {
+            continue;
+        }
+
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(scope.begin, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(scope.end, GL_QUERY_RESULT, &end);
+
+        const auto nanoseconds = std::chrono::nanoseconds(end > begin ? end - begin : 0);
+        const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(nanoseconds);
+
+        Chronometer::Record(scope.id, duration);
+
+        if (frame.isCalibrated)
+        {
+            const auto offset = std::chrono::nanoseconds(static_cast<GLint64>(begin) - frame.gpuReference);
+            const auto cpuBegin = frame.cpuReference + std::chrono::duration_cast<Clock::duration>(offset);
+            Tracer::AddScope(scope.id, Tracer::GPU_TRACK_ID, cpuBegin, duration);
+        }
+    }
+}
+
+DiffusionCurveRenderer::GpuChronometer::GpuChronometer(ScopeId id)
+{
+    if (GpuTimer* timer = GpuTimer::GetInstance())
+    {
+        mScope = timer->Begin(id);
+    }
+}
+
+DiffusionCurveRenderer::GpuChronometer::GpuChronometer(const std::string& name)
+    : GpuChronometer(Chronometer::Intern(name))
+{
+}
+
+DiffusionCurveRenderer::GpuChronometer::~GpuChronometer()
+{
+    if (GpuTimer* timer = GpuTimer::GetInstance(); timer && 0 <= mScope)
+    {
+        timer->End(mScope);
+    }
+}
+
+DiffusionCurveRenderer::GpuTimer* DiffusionCurveRenderer::GpuTimer::INSTANCE = nullptr;
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Util/Chronometer.h"
+#include "Util/Macros.h"
+
+#include <QOpenGLFunctions_4_5_Core>
+#include <array>
+#include <format>
+#include <string>
+#include <vector>
+
+namespace DiffusionCurveRenderer
+{
+    // Measures GPU execution time of render passes with GL_TIMESTAMP queries.
+    // Results are read back a few frames later, never stalling the pipeline, and
+    // reported through Chronometer so they show up next to the CPU timings.
+    class GpuTimer : protected QOpenGLFunctions_4_5_Core
+    {
+        DISABLE_COPY(GpuTimer);
+
+      public:
+        GpuTimer();
+        ~GpuTimer();
+
+        // Must be called once per frame before any scope is measured
+        void BeginFrame();
+
+        int Begin(ScopeId id);
+        void End(int scope);
+
+        static GpuTimer* GetInstance() { return INSTANCE; }
+
+      private:
+        struct Scope
+        {
+            ScopeId id;
+            GLuint begin;
+            GLuint end;
+            bool ended{ false };
+        };
+
+        struct Frame
+        {
+            std::vector<Scope> scopes;
+            std::vector<GLuint> queries;
+            int numberOfUsedQueries{ 0 };
+
+            // Query of the latest glQueryCounter() call. Scopes nest, so the end of an outer scope is issued after
+            // the end of the last scope that was begun.
+            GLuint lastIssuedQuery{ 0 };
+
+            // GPU and CPU clocks sampled together, used to place GPU scopes on the trace timeline
+            bool isCalibrated{ false };
+            GLint64 gpuReference{ 0 };
+            Clock::time_point cpuReference;
+        };
+
+        GLuint AcquireQuery();
+        void Collect(Frame& frame);
+
+        // Number of frames a query may stay in flight before its frame slot is reused
+        static constexpr int FRAME_LATENCY = 4;
+
+        std::array<Frame, FRAME_LATENCY> mFrames;
+        int mCurrentFrame{ 0 };
+
+        static GpuTimer* INSTANCE;
+    };
+
+    class GpuChronometer
+    {
+      public:
+        GpuChronometer(ScopeId id);
+        GpuChronometer(const std::string& name);
+        ~GpuChronometer();
+
+      private:
+        int mScope{ -1 };
+    };
+}
+
+#define MEASURE_GPU_TIME(NAME)                                                                                                       \
+    static const DiffusionCurveRenderer::ScopeId GPU_CHORONOMETER_ID__##NAME = DiffusionCurveRenderer::Chronometer::Intern(NAME); \
+    DiffusionCurveRenderer::GpuChronometer GPU_CHORONOMETER__##NAME = DiffusionCurveRenderer::GpuChronometer(GPU_CHORONOMETER_ID__##NAME)
+
+#define MEASURE_GPU_TIME_WITH_ARGS(NAME, FORMAT, ...) \
+    DiffusionCurveRenderer::GpuChronometer GPU_CHORONOMETER__##NAME = DiffusionCurveRenderer::GpuChronometer(std::format(FORMAT, __VA_ARGS__))
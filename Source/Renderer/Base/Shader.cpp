@@ -3,6 +3,7 @@
 #include "Util/Util.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QFile>
 
 DiffusionCurveRenderer::Shader::Shader(const QString& name)
@@ -17,12 +18,17 @@ void DiffusionCurveRenderer::Shader::Initialize()
 
     initializeOpenGLFunctions();
 
+    QElapsedTimer timer;
+    timer.start();
+
     mProgram = QSharedPointer<QOpenGLShaderProgram>(new QOpenGLShaderProgram);
 
+    // Cacheable shaders are compiled at link time, unless Qt finds a program binary for the same sources and
+    // GL_VENDOR/GL_RENDERER/GL_VERSION in its disk cache. Set QT_DISABLE_SHADER_DISK_CACHE=1 to always compile.
     for (const auto [shaderType, path] : mPaths)
     {
         const auto bytes = Util::GetBytes(path);
-        if (!mProgram->addShaderFromSourceCode(shaderType, bytes))
+        if (!mProgram->addCacheableShaderFromSourceCode(shaderType, bytes))
         {
             DCR_EXIT_FAILURE("Shader::Initialize: '{}' could not be loaded.", GetShaderTypeString(shaderType).toStdString());
         }
@@ -38,7 +44,7 @@ void DiffusionCurveRenderer::Shader::Initialize()
         DCR_EXIT_FAILURE("Shader::Initialize: Could not bind shader program.");
     }
 
-    LOG_INFO("Shader::Initialize: '{}' has been initialized.", mName.toStdString());
+    LOG_INFO("Shader::Initialize: '{}' has been initialized in {} ms.", mName.toStdString(), timer.elapsed());
 }
 
 bool DiffusionCurveRenderer::Shader::Bind()
@@ -1,6 +1,7 @@
 #include "ContourRenderer.h"
 
 #include "Core/Constants.h"
+#include "Renderer/Base/GpuTimer.h"
 #include "Util/Chronometer.h"
 
 void DiffusionCurveRenderer::ContourRenderer::Initialize()
@@ -14,11 +15,14 @@ void DiffusionCurveRenderer::ContourRenderer::Initialize()
     mBezierShader->Initialize();
 
     mInterval = new Interval(0, 1, NUMBER_OF_INTERVALS);
+    mCurveBuffer = new CurveBuffer;
+    mSelectedCurveBuffer = new CurveBuffer;
 }
 
 void DiffusionCurveRenderer::ContourRenderer::Render(QOpenGLFramebufferObject* target)
 {
     MEASURE_CALL_TIME(CONTOUR_RENDERER);
+    MEASURE_GPU_TIME(GPU_CONTOUR_RENDERER);
 
     if (target == nullptr)
     {
@@ -35,16 +39,20 @@ void DiffusionCurveRenderer::ContourRenderer::Render(QOpenGLFramebufferObject* t
     mBezierShader->SetUniformValue("projection", mCamera->GetProjectionMatrix());
     mBezierShader->SetUniformValue("delta", mInterval->GetDelta());
 
-    mInterval->Bind();
-
     const auto& curves = mCurveContainer->GetCurves();
+    mCurveBuffer->Update(curves);
+    int patchIndex = 0;
+
+    mCurveBuffer->Bind();
+    mInterval->Bind();
 
     for (const auto& curve : curves)
     {
-        RenderCurveInner(curve);
+        RenderCurveInner(curve, mCurveBuffer, patchIndex);
     }
 
     mInterval->Release();
+    mCurveBuffer->Release();
     mBezierShader->Release();
 }
 
@@ -65,21 +73,31 @@ void DiffusionCurveRenderer::ContourRenderer::RenderCurve(CurvePtr curve, QOpenG
     mBezierShader->SetUniformValue("projection", mCamera->GetProjectionMatrix());
     mBezierShader->SetUniformValue("delta", mInterval->GetDelta());
 
+    mSelectedCurveBuffer->Update({ curve });
+    int patchIndex = 0;
+
+    mSelectedCurveBuffer->Bind();
     mInterval->Bind();
-    RenderCurveInner(curve);
+    RenderCurveInner(curve, mSelectedCurveBuffer, patchIndex);
     mInterval->Release();
+    mSelectedCurveBuffer->Release();
 
     mBezierShader->Release();
 }
 
-void DiffusionCurveRenderer::ContourRenderer::RenderCurveInner(CurvePtr curve)
+void DiffusionCurveRenderer::ContourRenderer::RenderCurveInner(CurvePtr curve, CurveBuffer* curveBuffer, int& patchIndex)
 {
+    const auto setPatch = [this, curveBuffer, &patchIndex]() {
+        const auto& patch = curveBuffer->GetPatch(patchIndex++);
+        mBezierShader->SetUniformValue("controlPointsOffset", patch.controlPointsOffset);
+        mBezierShader->SetUniformValue("controlPointsCount", patch.controlPointsCount);
+    };
+
     if (const auto bezier = std::dynamic_pointer_cast<Bezier>(curve))
     {
         mBezierShader->SetUniformValue("thickness", bezier->GetContourThickness());
         mBezierShader->SetUniformValue("color", bezier->GetContourColor());
-        mBezierShader->SetUniformValue("numberOfControlPoints", static_cast<int>(bezier->GetNumberOfControlPoints()));
-        mBezierShader->SetUniformValueArray("controlPoints", bezier->GetControlPointPositions());
+        setPatch();
         mInterval->Render();
     }
     else if (const auto spline = std::dynamic_pointer_cast<Spline>(curve))
@@ -87,12 +105,9 @@ void DiffusionCurveRenderer::ContourRenderer::RenderCurveInner(CurvePtr curve)
         mBezierShader->SetUniformValue("thickness", spline->GetContourThickness());
         mBezierShader->SetUniformValue("color", spline->GetContourColor());
 
-        const auto patches = spline->GetBezierPatches();
-
-        for (const auto& bezier : patches)
+        for (int i = 0; i < spline->GetBezierPatches().size(); ++i)
         {
-            mBezierShader->SetUniformValue("numberOfControlPoints", static_cast<int>(bezier->GetNumberOfControlPoints()));
-            mBezierShader->SetUniformValueArray("controlPoints", bezier->GetControlPointPositions());
+            setPatch();
             mInterval->Render();
         }
     }
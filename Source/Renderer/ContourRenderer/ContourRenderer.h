@@ -4,6 +4,7 @@
 #include "Core/CurveContainer.h"
 #include "Core/OrthographicCamera.h"
 #include "Curve/Spline.h"
+#include "Renderer/Base/CurveBuffer.h"
 #include "Renderer/Base/Interval.h"
 #include "Renderer/Base/Shader.h"
 
@@ -24,10 +25,12 @@ namespace DiffusionCurveRenderer
         void RenderCurve(CurvePtr curve, QOpenGLFramebufferObject* target = nullptr);
 
       private:
-        void RenderCurveInner(CurvePtr curve);
+        void RenderCurveInner(CurvePtr curve, CurveBuffer* curveBuffer, int& patchIndex);
 
         Shader* mBezierShader;
         Interval* mInterval;
+        CurveBuffer* mCurveBuffer;
+        CurveBuffer* mSelectedCurveBuffer; // RenderCurve() draws a single curve, it would evict the scene from mCurveBuffer
 
         DEFINE_MEMBER_PTR(OrthographicCamera, Camera);
         DEFINE_MEMBER_PTR(CurveContainer, CurveContainer);
@@ -27,6 +27,8 @@ namespace DiffusionCurveRenderer
 
         GLuint GetHandle() const { return mFramebuffer; }
         GLuint GetTexture() const { return mTexture; }
+        int GetWidth() const { return mWidth; }
+        int GetHeight() const { return mHeight; }
 
       private:
         GLuint mFramebuffer{ 0 };
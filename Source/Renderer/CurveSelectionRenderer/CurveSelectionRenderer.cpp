@@ -1,6 +1,7 @@
 #include "CurveSelectionRenderer.h"
 
 #include "Core/Constants.h"
+#include "Renderer/Base/GpuTimer.h"
 #include "Util/Chronometer.h"
 
 DiffusionCurveRenderer::CurveSelectionRenderer::CurveSelectionRenderer()
@@ -14,23 +15,38 @@ DiffusionCurveRenderer::CurveSelectionRenderer::CurveSelectionRenderer()
     mCurveSelectionShader->Initialize();
 
     mInterval = new Interval(0, 1, NUMBER_OF_INTERVALS);
+    mCurveBuffer = new CurveBuffer;
 
     mFramebuffer = std::make_shared<CurveSelectionFramebuffer>(INITIAL_WIDTH, INITIAL_HEIGHT);
 }
 
-void DiffusionCurveRenderer::CurveSelectionRenderer::Render()
+bool DiffusionCurveRenderer::CurveSelectionRenderer::IsCached(const QPoint& point)
+{
+    if (mIsRenderedRegionValid == false || mRenderedRegion.contains(point) == false)
+    {
+        return false;
+    }
+
+    return mRenderedSceneVersion == mCurveContainer->GetVersion() &&        //
+           mRenderedProjectionMatrix == mCamera->GetProjectionMatrix() && //
+           mRenderedCurveSelectionWidth == mCurveSelectionWidth;
+}
+
+void DiffusionCurveRenderer::CurveSelectionRenderer::Render(const QRect& region)
 {
     MEASURE_CALL_TIME(CURVE_SELECTION_RENDERER);
+    MEASURE_GPU_TIME(GPU_CURVE_SELECTION_RENDERER);
 
     const auto& curves = mCurveContainer->GetCurves();
 
-    if (curves.isEmpty())
-    {
-        return;
-    }
-
-    mFramebuffer->Clear();
     mFramebuffer->Bind();
+    glViewport(0, 0, mFramebuffer->GetWidth(), mFramebuffer->GetHeight());
+
+    // Only the pixels around the query point are cleared and rasterized
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(region.x(), region.y(), region.width(), region.height());
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT);
 
     mCurveSelectionShader->Bind();
     mCurveSelectionShader->SetUniformValue("projection", mCamera->GetProjectionMatrix());
@@ -38,6 +54,16 @@ void DiffusionCurveRenderer::CurveSelectionRenderer::Render()
     mCurveSelectionShader->SetUniformValue("delta", mInterval->GetDelta());
     mCurveSelectionShader->SetUniformValue("thickness", mCurveSelectionWidth);
 
+    mCurveBuffer->Update(curves);
+    int patchIndex = 0;
+
+    const auto setPatch = [this, &patchIndex]() {
+        const auto& patch = mCurveBuffer->GetPatch(patchIndex++);
+        mCurveSelectionShader->SetUniformValue("controlPointsOffset", patch.controlPointsOffset);
+        mCurveSelectionShader->SetUniformValue("controlPointsCount", patch.controlPointsCount);
+    };
+
+    mCurveBuffer->Bind();
     mInterval->Bind();
 
     for (int index = 0; index < curves.size(); ++index)
@@ -49,20 +75,16 @@ void DiffusionCurveRenderer::CurveSelectionRenderer::Render()
         if (const auto bezier = std::dynamic_pointer_cast<Bezier>(curve))
         {
             mCurveSelectionShader->SetUniformValue("curveType", 0);
-            mCurveSelectionShader->SetUniformValue("numberOfControlPoints", static_cast<int>(bezier->GetNumberOfControlPoints()));
-            mCurveSelectionShader->SetUniformValueArray("controlPoints", bezier->GetControlPointPositions());
+            setPatch();
             mInterval->Render();
         }
         else if (const auto spline = std::dynamic_pointer_cast<Spline>(curve))
         {
             mCurveSelectionShader->SetUniformValue("curveType", 1);
 
-            const auto patches = spline->GetBezierPatches();
-
-            for (const auto& bezier : patches)
+            for (int i = 0; i < spline->GetBezierPatches().size(); ++i)
             {
-                mCurveSelectionShader->SetUniformValue("numberOfControlPoints", static_cast<int>(bezier->GetNumberOfControlPoints()));
-                mCurveSelectionShader->SetUniformValueArray("controlPoints", bezier->GetControlPointPositions());
+                setPatch();
                 mInterval->Render();
             }
         }
@@ -73,18 +95,44 @@ void DiffusionCurveRenderer::CurveSelectionRenderer::Render()
     }
 
     mInterval->Release();
+    mCurveBuffer->Release();
     mCurveSelectionShader->Release();
+
+    glDisable(GL_SCISSOR_TEST);
+
+    mIsRenderedRegionValid = true;
+    mRenderedRegion = region;
+    mRenderedSceneVersion = mCurveContainer->GetVersion();
+    mRenderedProjectionMatrix = mCamera->GetProjectionMatrix();
+    mRenderedCurveSelectionWidth = mCurveSelectionWidth;
 }
 
 DiffusionCurveRenderer::CurveQueryInfo DiffusionCurveRenderer::CurveSelectionRenderer::Query(const QPoint& queryPoint)
 {
+    if (mCurveContainer->GetCurves().isEmpty())
+    {
+        return CurveQueryInfo{ 0, 0, 0, 0 };
+    }
+
     // Scale query point by device pixel ratio for high DPI displays
     float pixelRatio = mCamera->GetPixelRatio();
     QPoint scaledPoint(queryPoint.x() * pixelRatio, queryPoint.y() * pixelRatio);
+
+    // Same pixel CurveSelectionFramebuffer::Query reads back
+    const QPoint framebufferPoint(scaledPoint.x(), mFramebuffer->GetHeight() - scaledPoint.y());
+
+    if (IsCached(framebufferPoint) == false)
+    {
+        QRect region(0, 0, CURVE_SELECTION_REGION_SIZE, CURVE_SELECTION_REGION_SIZE);
+        region.moveCenter(framebufferPoint);
+        Render(region.intersected(QRect(0, 0, mFramebuffer->GetWidth(), mFramebuffer->GetHeight())));
+    }
+
     return mFramebuffer->Query(scaledPoint);
 }
 
 void DiffusionCurveRenderer::CurveSelectionRenderer::Resize(int width, int height)
 {
     mFramebuffer = std::make_shared<CurveSelectionFramebuffer>(width, height);
+    mIsRenderedRegionValid = false;
 }
@@ -4,12 +4,14 @@
 #include "Core/CurveContainer.h"
 #include "Core/OrthographicCamera.h"
 #include "Curve/Spline.h"
+#include "Renderer/Base/CurveBuffer.h"
 #include "Renderer/Base/Interval.h"
 #include "Renderer/Base/Shader.h"
 #include "Renderer/CurveSelectionRenderer/CurveSelectionFramebuffer.h"
 
 #include <QOpenGLExtraFunctions>
 #include <QOpenGLFramebufferObject>
+#include <QRect>
 
 namespace DiffusionCurveRenderer
 {
@@ -18,17 +20,28 @@ namespace DiffusionCurveRenderer
       public:
         CurveSelectionRenderer();
 
-        void Render();
+        // Re-renders the ID buffer around the query point only if the scene or the camera changed since the last query
         CurveQueryInfo Query(const QPoint& queryPoint);
 
         void Resize(int width, int height);
 
       private:
+        bool IsCached(const QPoint& point);
+        void Render(const QRect& region);
+
         Shader* mCurveSelectionShader;
         Interval* mInterval;
+        CurveBuffer* mCurveBuffer;
 
         CurveSelectionFramebufferPtr mFramebuffer{ nullptr };
 
+        // State of the last render, the ID buffer is valid only inside mRenderedRegion (in framebuffer coordinates)
+        bool mIsRenderedRegionValid{ false };
+        QRect mRenderedRegion;
+        uint64_t mRenderedSceneVersion{ 0 };
+        QMatrix4x4 mRenderedProjectionMatrix;
+        float mRenderedCurveSelectionWidth{ 0.0f };
+
         DEFINE_MEMBER_PTR(OrthographicCamera, Camera);
         DEFINE_MEMBER_PTR(CurveContainer, CurveContainer);
 
@@ -1,9 +1,8 @@
 #include "DiffusionRenderer.h"
 
 #include "Core/Constants.h"
-#include "Renderer/DiffusionRenderer/Renderers/ColorRenderer.h"
-#include "Renderer/DiffusionRenderer/Renderers/DownsampleRenderer.h"
-#include "Renderer/DiffusionRenderer/Renderers/UpsampleRenderer.h"
+#include "Renderer/DiffusionRenderer/Renderers/BlurRenderer.h"
+#include "Renderer/DiffusionRenderer/Solvers/DiffusionSolverFactory.h"
 #include "Util/Chronometer.h"
 
 void DiffusionCurveRenderer::DiffusionRenderer::Initialize()
@@ -17,24 +16,29 @@ void DiffusionCurveRenderer::DiffusionRenderer::Initialize()
     mBlitter->AddPath(QOpenGLShader::Fragment, ":/Resources/Shaders/Blit.frag");
     mBlitter->Initialize();
 
-    mColorRenderer = new ColorRenderer;
-    mColorRenderer->SetCamera(mCamera);
-    mColorRenderer->SetCurveContainer(mCurveContainer);
-
-    mDownsampleRenderer = new DownsampleRenderer;
-    mUpsampleRenderer = new UpsampleRenderer;
+    for (const auto type : DiffusionSolverFactory::GetTypes())
+    {
+        DiffusionSolver* solver = DiffusionSolverFactory::Create(type);
+        mSolvers[type] = solver;
 
-    mFramebufferFormat.setAttachment(QOpenGLFramebufferObject::NoAttachment);
-    mFramebufferFormat.setSamples(0);
+        solver->SetCamera(mCamera);
+        solver->SetCurveContainer(mCurveContainer);
+        solver->Initialize();
+    }
 
-    SetFramebufferSize(DEFAULT_FRAMEBUFFER_SIZE);
+    mBlurRenderer = new BlurRenderer;
+    mBlurRenderer->SetCamera(mCamera);
+    mBlurRenderer->SetCurveContainer(mCurveContainer);
 }
 
 void DiffusionCurveRenderer::DiffusionRenderer::Render(QOpenGLFramebufferObject* target)
 {
-    mColorRenderer->Render(mFramebuffer.get());
-    mDownsampleRenderer->Downsample(mFramebuffer.get());
-    mUpsampleRenderer->Upsample(mDownsampleRenderer->GetFramebuffers());
+    DiffusionSolver* solver = GetSolver();
+
+    solver->Solve();
+
+    // Blur is a post pass on the result, every solver gets it
+    const bool blur = mBlurRenderer->Prepare(solver->GetResultTexture());
 
     if (target == nullptr)
     {
@@ -48,32 +52,51 @@ void DiffusionCurveRenderer::DiffusionRenderer::Render(QOpenGLFramebufferObject*
         glViewport(0, 0, target->width(), target->height());
     }
 
+    if (blur)
+    {
+        mBlurRenderer->Composite();
+        return;
+    }
+
     mBlitter->Bind();
-    mBlitter->SetSampler("sourceTexture", 0, mUpsampleRenderer->GetResult()->texture());
+    mBlitter->SetSampler("sourceTexture", 0, solver->GetResultTexture());
     mQuad->Render();
     mBlitter->Release();
 }
 
 void DiffusionCurveRenderer::DiffusionRenderer::SetFramebufferSize(int size)
 {
-    mFramebuffer = std::make_unique<QOpenGLFramebufferObject>(size, size, mFramebufferFormat);
+    for (const auto& [type, solver] : mSolvers)
+        solver->SetFramebufferSize(size);
 
-    mColorRenderer->SetFramebufferSize(size);
-    mDownsampleRenderer->SetFramebufferSize(size);
-    mUpsampleRenderer->SetFramebufferSize(size);
+    mBlurRenderer->SetFramebufferSize(size);
 }
 
 void DiffusionCurveRenderer::DiffusionRenderer::SetSmoothIterations(int smoothIterations)
 {
-    mUpsampleRenderer->SetSmoothIterations(smoothIterations);
+    for (const auto& [type, solver] : mSolvers)
+        solver->SetSmoothIterations(smoothIterations);
+
+    mBlurRenderer->SetSmoothIterations(smoothIterations);
 }
 
 void DiffusionCurveRenderer::DiffusionRenderer::SetUseMultisampleFramebuffer(bool val)
 {
-    mColorRenderer->SetUseMultisampleFramebuffer(val);
+    for (const auto& [type, solver] : mSolvers)
+        solver->SetUseMultisampleFramebuffer(val);
 }
 
 int DiffusionCurveRenderer::DiffusionRenderer::GetSmoothIterations() const
 {
-    return mUpsampleRenderer->GetSmoothIterations();
+    return GetSolver()->GetSmoothIterations();
+}
+
+DiffusionCurveRenderer::DiffusionSolver* DiffusionCurveRenderer::DiffusionRenderer::GetSolver() const
+{
+    return GetSolver(mSolverType);
+}
+
+DiffusionCurveRenderer::DiffusionSolver* DiffusionCurveRenderer::DiffusionRenderer::GetSolver(DiffusionSolverType type) const
+{
+    return mSolvers.at(type);
 }
@@ -2,9 +2,9 @@
 
 #include "Core/CurveContainer.h"
 #include "Core/OrthographicCamera.h"
-#include "Renderer/Base/MultisampleFramebuffer.h"
 #include "Renderer/Base/Quad.h"
 #include "Renderer/Base/Shader.h"
+#include "Structs/Enums.h"
 
 #include <QOpenGLExtraFunctions>
 #include <QOpenGLFramebufferObject>
@@ -12,9 +12,8 @@
 
 namespace DiffusionCurveRenderer
 {
-    class ColorRenderer;
-    class DownsampleRenderer;
-    class UpsampleRenderer;
+    class DiffusionSolver;
+    class BlurRenderer;
 
     class DiffusionRenderer : protected QOpenGLExtraFunctions
     {
@@ -30,18 +29,19 @@ namespace DiffusionCurveRenderer
         void SetSmoothIterations(int smoothIterations);
         void SetUseMultisampleFramebuffer(bool val);
 
+        DiffusionSolver* GetSolver() const;
+        DiffusionSolver* GetSolver(DiffusionSolverType type) const;
+
       private:
-        ColorRenderer* mColorRenderer;
-        DownsampleRenderer* mDownsampleRenderer;
-        UpsampleRenderer* mUpsampleRenderer;
+        std::map<DiffusionSolverType, DiffusionSolver*> mSolvers;
+        BlurRenderer* mBlurRenderer;
 
         Shader* mBlitter;
         Quad* mQuad;
 
-        QOpenGLFramebufferObjectFormat mFramebufferFormat;
-        std::unique_ptr<QOpenGLFramebufferObject> mFramebuffer{ nullptr };
+        DEFINE_MEMBER(DiffusionSolverType, SolverType, DiffusionSolverType::Gpu);
 
         DEFINE_MEMBER_PTR(OrthographicCamera, Camera);
         DEFINE_MEMBER_PTR(CurveContainer, CurveContainer);
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,233 @@
+#include "BlurRenderer.h"
+
+#include "Renderer/Base/GpuTimer.h"
+#include "Renderer/DiffusionRenderer/Renderers/DownsampleRenderer.h"
+#include "Renderer/DiffusionRenderer/Renderers/UpsampleRenderer.h"
+#include "Util/Chronometer.h"
+
+#include <algorithm>
+
+DiffusionCurveRenderer::BlurRenderer::BlurRenderer()
+{
+    initializeOpenGLFunctions();
+
+    mInterval = new Interval(0, 1, NUMBER_OF_INTERVALS);
+    mQuad = new Quad;
+    mCurveBuffer = new CurveBuffer;
+
+    mBlurMapShader = new Shader("Blur Map Shader");
+    mBlurMapShader->AddPath(QOpenGLShader::Vertex, ":/Resources/Shaders/Bezier.vert");
+    mBlurMapShader->AddPath(QOpenGLShader::Geometry, ":/Resources/Shaders/Blur.geom");
+    mBlurMapShader->AddPath(QOpenGLShader::Fragment, ":/Resources/Shaders/Color.frag");
+    mBlurMapShader->Initialize();
+
+    mBlitShader = new Shader("Blit Shader");
+    mBlitShader->AddPath(QOpenGLShader::Vertex, ":/Resources/Shaders/Quad.vert");
+    mBlitShader->AddPath(QOpenGLShader::Fragment, ":/Resources/Shaders/Blit.frag");
+    mBlitShader->Initialize();
+
+    mCompositeShader = new Shader("Blur Shader");
+    mCompositeShader->AddPath(QOpenGLShader::Vertex, ":/Resources/Shaders/Quad.vert");
+    mCompositeShader->AddPath(QOpenGLShader::Fragment, ":/Resources/Shaders/Blur.frag");
+    mCompositeShader->Initialize();
+
+    mFramebufferFormat.setAttachment(QOpenGLFramebufferObject::NoAttachment);
+    mFramebufferFormat.setSamples(0);
+    mFramebufferFormat.setMipmap(false);
+    mFramebufferFormat.setTextureTarget(GL_TEXTURE_2D);
+    mFramebufferFormat.setInternalTextureFormat(GL_RGBA8);
+
+    // 8 bits would quantize the radius to MAXIMUM_BLUR_STRENGTH / 255 and round small radii to zero.
+    // Not a single channel, the diffusion passes read alpha to tell constraints from empty pixels.
+    mBlurMapFramebufferFormat = mFramebufferFormat;
+    mBlurMapFramebufferFormat.setInternalTextureFormat(GL_RGBA16F);
+
+    // Trilinear, the composite pass blends the two levels around the blur radius of each pixel
+    glGenSamplers(1, &mPyramidSampler);
+    glSamplerParameteri(mPyramidSampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glSamplerParameteri(mPyramidSampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glSamplerParameteri(mPyramidSampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(mPyramidSampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+bool DiffusionCurveRenderer::BlurRenderer::Prepare(GLuint colorTexture)
+{
+    const QVector2D texelsPerUnit = GetTexelsPerUnit();
+
+    // Below a tenth of a texel the composite would read level 0 anyway
+    if (GetMaximumStrength() * std::max(texelsPerUnit.x(), texelsPerUnit.y()) < 0.1f)
+        return false;
+
+    MEASURE_CALL_TIME(BLUR_RENDERER);
+    MEASURE_GPU_TIME(GPU_BLUR_RENDERER);
+
+    if (mAllocatedSize != mFramebufferSize)
+        Allocate(mFramebufferSize);
+
+    // Blur strengths are diffused by the same passes as the colors
+    RenderBlurMap();
+    mBlurDownsampleRenderer->Downsample(mBlurMapFramebuffer.get());
+    mBlurUpsampleRenderer->SetSmoothIterations(mSmoothIterations);
+    mBlurUpsampleRenderer->Upsample(mBlurDownsampleRenderer->GetFramebuffers());
+
+    BuildPyramid(colorTexture);
+
+    return true;
+}
+
+void DiffusionCurveRenderer::BlurRenderer::Composite()
+{
+    mCompositeShader->Bind();
+    mCompositeShader->SetSampler("colorTexture", 0, mPyramidTexture);
+    mCompositeShader->SetSampler("blurTexture", 1, mBlurUpsampleRenderer->GetResult()->texture());
+    mCompositeShader->SetUniformValue("maximumStrength", MAXIMUM_BLUR_STRENGTH);
+    mCompositeShader->SetUniformValue("texelsPerUnit", GetTexelsPerUnit());
+
+    glBindSampler(0, mPyramidSampler);
+    mQuad->Render();
+    glBindSampler(0, 0);
+
+    mCompositeShader->Release();
+}
+
+void DiffusionCurveRenderer::BlurRenderer::RenderBlurMap()
+{
+    mBlurMapFramebuffer->bind();
+    glViewport(0, 0, mBlurMapFramebuffer->width(), mBlurMapFramebuffer->height());
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    mBlurMapShader->Bind();
+    mBlurMapShader->SetUniformValue("projection", mCamera->GetProjectionMatrix());
+    mBlurMapShader->SetUniformValue("delta", mInterval->GetDelta());
+    mBlurMapShader->SetUniformValue("maximumStrength", MAXIMUM_BLUR_STRENGTH);
+
+    const auto& curves = mCurveContainer->GetCurves();
+    mCurveBuffer->Update(curves);
+    int patchIndex = 0;
+
+    mCurveBuffer->Bind();
+    mInterval->Bind();
+
+    // Every curve is a constraint, curves without blur keep their surroundings sharp
+    for (const auto& curve : curves)
+    {
+        mBlurMapShader->SetUniformValue("diffusionWidth", curve->GetDiffusionWidth());
+        mBlurMapShader->SetUniformValue("diffusionGap", curve->GetDiffusionGap());
+
+        if (const auto bezier = std::dynamic_pointer_cast<Bezier>(curve))
+        {
+            SetUniforms(patchIndex++);
+            mInterval->Render();
+        }
+        else if (const auto spline = std::dynamic_pointer_cast<Spline>(curve))
+        {
+            for (int i = 0; i < spline->GetBezierPatches().size(); ++i)
+            {
+                SetUniforms(patchIndex++);
+                mInterval->Render();
+            }
+        }
+        else
+        {
+            DCR_EXIT_FAILURE("BlurRenderer::RenderBlurMap: Undefined curve type. Implement this branch!");
+        }
+    }
+
+    mInterval->Release();
+    mCurveBuffer->Release();
+    mBlurMapShader->Release();
+    mBlurMapFramebuffer->release();
+}
+
+void DiffusionCurveRenderer::BlurRenderer::BuildPyramid(GLuint colorTexture)
+{
+    // DownsampleRenderer reads from a framebuffer, the solvers only expose their result texture
+    mColorFramebuffer->bind();
+    glViewport(0, 0, mColorFramebuffer->width(), mColorFramebuffer->height());
+
+    mBlitShader->Bind();
+    mBlitShader->SetSampler("sourceTexture", 0, colorTexture);
+    mQuad->Render();
+    mBlitShader->Release();
+    mColorFramebuffer->release();
+
+    mColorDownsampleRenderer->Downsample(mColorFramebuffer.get());
+
+    // One texture with the levels as mipmaps, so a single trilinear lookup blends two levels
+    const auto& levels = mColorDownsampleRenderer->GetFramebuffers();
+
+    for (int i = 0; i < levels.size(); ++i)
+    {
+        glCopyImageSubData(levels[i]->texture(), GL_TEXTURE_2D, 0, 0, 0, 0, //
+                           mPyramidTexture, GL_TEXTURE_2D, i, 0, 0, 0,
+                           levels[i]->width(), levels[i]->height(), 1);
+    }
+}
+
+void DiffusionCurveRenderer::BlurRenderer::SetUniforms(int patchIndex)
+{
+    const auto& patch = mCurveBuffer->GetPatch(patchIndex);
+
+    mBlurMapShader->SetUniformValue("controlPointsOffset", patch.controlPointsOffset);
+    mBlurMapShader->SetUniformValue("controlPointsCount", patch.controlPointsCount);
+    mBlurMapShader->SetUniformValue("blurPointsOffset", patch.blurPointsOffset);
+    mBlurMapShader->SetUniformValue("blurPointsCount", patch.blurPointsCount);
+}
+
+void DiffusionCurveRenderer::BlurRenderer::Allocate(int size)
+{
+    mBlurMapFramebuffer = std::make_unique<QOpenGLFramebufferObject>(size, size, mBlurMapFramebufferFormat);
+    mColorFramebuffer = std::make_unique<QOpenGLFramebufferObject>(size, size, mFramebufferFormat);
+
+    if (mBlurDownsampleRenderer == nullptr)
+    {
+        mBlurDownsampleRenderer = new DownsampleRenderer(GL_RGBA16F);
+        mBlurUpsampleRenderer = new UpsampleRenderer(GL_RGBA16F);
+        mColorDownsampleRenderer = new DownsampleRenderer;
+    }
+
+    mBlurDownsampleRenderer->SetFramebufferSize(size);
+    mBlurUpsampleRenderer->SetFramebufferSize(size);
+    mColorDownsampleRenderer->SetFramebufferSize(size);
+
+    // Immutable storage, texture storage cannot be resized
+    if (mPyramidTexture != 0)
+        glDeleteTextures(1, &mPyramidTexture);
+
+    glGenTextures(1, &mPyramidTexture);
+    glBindTexture(GL_TEXTURE_2D, mPyramidTexture);
+    glTexStorage2D(GL_TEXTURE_2D, mColorDownsampleRenderer->GetFramebuffers().size(), GL_RGBA8, size, size);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    mAllocatedSize = size;
+}
+
+float DiffusionCurveRenderer::BlurRenderer::GetMaximumStrength() const
+{
+    float maximum = 0.0f;
+
+    const auto update = [&maximum](const BezierPtr& bezier) {
+        for (const auto& point : bezier->GetBlurPoints())
+            maximum = std::max(maximum, point->strength);
+    };
+
+    for (const auto& curve : mCurveContainer->GetCurves())
+    {
+        if (const auto bezier = std::dynamic_pointer_cast<Bezier>(curve))
+            update(bezier);
+        else if (const auto spline = std::dynamic_pointer_cast<Spline>(curve))
+            for (const auto& patch : spline->GetBezierPatches())
+                update(patch);
+    }
+
+    return std::min(maximum, MAXIMUM_BLUR_STRENGTH);
+}
+
+QVector2D DiffusionCurveRenderer::BlurRenderer::GetTexelsPerUnit() const
+{
+    // The square framebuffer is stretched over the view of the camera
+    const float zoom = mCamera->GetZoom();
+
+    return QVector2D(mFramebufferSize / (mCamera->GetWidth() * zoom), mFramebufferSize / (mCamera->GetHeight() * zoom));
+}
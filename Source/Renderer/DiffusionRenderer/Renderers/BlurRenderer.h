@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Core/Constants.h"
+#include "Core/CurveContainer.h"
+#include "Core/OrthographicCamera.h"
+#include "Renderer/Base/CurveBuffer.h"
+#include "Renderer/Base/Interval.h"
+#include "Renderer/Base/Quad.h"
+#include "Renderer/Base/Shader.h"
+#include "Util/Macros.h"
+
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QVector2D>
+#include <memory>
+
+namespace DiffusionCurveRenderer
+{
+    class DownsampleRenderer;
+    class UpsampleRenderer;
+
+    // Blurs the diffused colors where the blur points of the curves ask for it. Blur strengths are interpolated along
+    // the curves and diffused like colors into a blur map. The colors are filtered into a pyramid and every pixel
+    // reads the level matching its blur radius, so the cost per pixel does not depend on the radius.
+    class BlurRenderer : protected QOpenGLExtraFunctions
+    {
+      public:
+        BlurRenderer();
+
+        // Builds the blur map and the pyramid of colorTexture, a FramebufferSize square texture.
+        // Returns false if no curve is blurred noticeably, Composite() is not needed then.
+        bool Prepare(GLuint colorTexture);
+
+        // Draws the blurred colors of the last Prepare() into the bound framebuffer
+        void Composite();
+
+        DEFINE_MEMBER(int, FramebufferSize, DEFAULT_FRAMEBUFFER_SIZE);
+        DEFINE_MEMBER(int, SmoothIterations, DEFAULT_SMOOTH_ITERATIONS);
+
+        DEFINE_MEMBER_PTR(OrthographicCamera, Camera);
+        DEFINE_MEMBER_PTR(CurveContainer, CurveContainer);
+
+      private:
+        void RenderBlurMap();
+        void BuildPyramid(GLuint colorTexture);
+        void SetUniforms(int patchIndex);
+        void Allocate(int size);
+
+        float GetMaximumStrength() const;
+        QVector2D GetTexelsPerUnit() const;
+
+        Interval* mInterval;
+        Quad* mQuad;
+        CurveBuffer* mCurveBuffer;
+
+        Shader* mBlurMapShader;
+        Shader* mBlitShader;
+        Shader* mCompositeShader;
+
+        // Created on first use, scenes without blur do not pay for them
+        DownsampleRenderer* mBlurDownsampleRenderer{ nullptr };
+        UpsampleRenderer* mBlurUpsampleRenderer{ nullptr };
+        DownsampleRenderer* mColorDownsampleRenderer{ nullptr };
+
+        QOpenGLFramebufferObjectFormat mFramebufferFormat;
+        QOpenGLFramebufferObjectFormat mBlurMapFramebufferFormat;
+        std::unique_ptr<QOpenGLFramebufferObject> mBlurMapFramebuffer{ nullptr };
+        std::unique_ptr<QOpenGLFramebufferObject> mColorFramebuffer{ nullptr };
+
+        GLuint mPyramidTexture{ 0 }; // Levels of the color pyramid as mipmaps
+        GLuint mPyramidSampler{ 0 };
+
+        int mAllocatedSize{ 0 };
+    };
+}
@@ -1,5 +1,7 @@
 #include "ColorRenderer.h"
 
+#include "Renderer/Base/GpuTimer.h"
+#include "Renderer/DiffusionRenderer/Renderers/GradientAtlas.h"
 #include "Util/Chronometer.h"
 
 DiffusionCurveRenderer::ColorRenderer::ColorRenderer()
@@ -14,6 +16,9 @@ DiffusionCurveRenderer::ColorRenderer::ColorRenderer()
     mColorShader->AddPath(QOpenGLShader::Fragment, ":/Resources/Shaders/Color.frag");
     mColorShader->Initialize();
 
+    mGradientAtlas = new GradientAtlas;
+    mCurveBuffer = new CurveBuffer;
+
     mMultisampleFramebufferFormat.setAttachment(QOpenGLFramebufferObject::NoAttachment);
     mMultisampleFramebufferFormat.setSamples(8);
 
@@ -23,6 +28,7 @@ DiffusionCurveRenderer::ColorRenderer::ColorRenderer()
 void DiffusionCurveRenderer::ColorRenderer::Render(QOpenGLFramebufferObject* target)
 {
     MEASURE_CALL_TIME(COLOR_RENDERER);
+    MEASURE_GPU_TIME(GPU_COLOR_RENDERER);
 
     if (mUseMultisampleFramebuffer)
     {
@@ -42,14 +48,23 @@ void DiffusionCurveRenderer::ColorRenderer::RenderPrivate(QOpenGLFramebufferObje
     glClearColor(0, 0, 0, 0);
     glClear(GL_COLOR_BUFFER_BIT);
 
+    const auto& curves = mCurveContainer->GetCurves();
+
+    // Patches are visited in the same order as in GradientAtlas::Update and CurveBuffer::Update
+    mGradientAtlas->Update(curves);
+    mCurveBuffer->Update(curves);
+    int patchIndex = 0;
+
     mColorShader->Bind();
     mColorShader->SetUniformValue("projection", mCamera->GetProjectionMatrix());
     mColorShader->SetUniformValue("delta", mInterval->GetDelta());
+    mColorShader->SetSampler("gradientAtlas", 0, mGradientAtlas->GetTexture());
+    mColorShader->SetUniformValue("gradientWidth", GradientAtlas::WIDTH);
+    glBindSampler(0, mGradientAtlas->GetSampler());
 
+    mCurveBuffer->Bind();
     mInterval->Bind();
 
-    const auto& curves = mCurveContainer->GetCurves();
-
     for (const auto& curve : curves)
     {
         if (const auto bezier = std::dynamic_pointer_cast<Bezier>(curve))
@@ -57,7 +72,7 @@ void DiffusionCurveRenderer::ColorRenderer::RenderPrivate(QOpenGLFramebufferObje
             mColorShader->SetUniformValue("diffusionWidth", curve->GetDiffusionWidth());
             mColorShader->SetUniformValue("diffusionGap", curve->GetDiffusionGap());
 
-            SetUniforms(bezier);
+            SetUniforms(patchIndex++);
 
             mInterval->Render();
         }
@@ -66,11 +81,9 @@ void DiffusionCurveRenderer::ColorRenderer::RenderPrivate(QOpenGLFramebufferObje
             mColorShader->SetUniformValue("diffusionWidth", spline->GetDiffusionWidth());
             mColorShader->SetUniformValue("diffusionGap", spline->GetDiffusionGap());
 
-            const auto patches = spline->GetBezierPatches();
-
-            for (const auto& bezier : patches)
+            for (int i = 0; i < spline->GetBezierPatches().size(); ++i)
             {
-                SetUniforms(bezier);
+                SetUniforms(patchIndex++);
 
                 mInterval->Render();
             }
@@ -82,20 +95,21 @@ void DiffusionCurveRenderer::ColorRenderer::RenderPrivate(QOpenGLFramebufferObje
     }
 
     mInterval->Release();
+    mCurveBuffer->Release();
+    glBindSampler(0, 0);
     mColorShader->Release();
     target->release();
 }
 
-void DiffusionCurveRenderer::ColorRenderer::SetUniforms(BezierPtr curve)
+void DiffusionCurveRenderer::ColorRenderer::SetUniforms(int patchIndex)
 {
-    mColorShader->SetUniformValueArray("controlPoints", curve->GetControlPointPositions());
-    mColorShader->SetUniformValue("controlPointsCount", curve->GetNumberOfControlPoints());
-    mColorShader->SetUniformValueArray("leftColors", curve->GetLeftColors());
-    mColorShader->SetUniformValueFloatArray("leftColorPositions", curve->GetLeftColorPositions());
-    mColorShader->SetUniformValue("leftColorsCount", curve->GetNumberOfLeftColors());
-    mColorShader->SetUniformValueArray("rightColors", curve->GetRightColors());
-    mColorShader->SetUniformValueFloatArray("rightColorPositions", curve->GetRightColorPositions());
-    mColorShader->SetUniformValue("rightColorsCount", curve->GetNumberOfRightColors());
+    const auto& patch = mCurveBuffer->GetPatch(patchIndex);
+
+    // The i-th patch owns rows 2i and 2i + 1 of the gradient atlas
+    mColorShader->SetUniformValue("controlPointsOffset", patch.controlPointsOffset);
+    mColorShader->SetUniformValue("controlPointsCount", patch.controlPointsCount);
+    mColorShader->SetUniformValue("leftGradient", 2 * patchIndex);
+    mColorShader->SetUniformValue("rightGradient", 2 * patchIndex + 1);
 }
 
 void DiffusionCurveRenderer::ColorRenderer::SetFramebufferSize(int size)
@@ -2,6 +2,7 @@
 
 #include "Core/CurveContainer.h"
 #include "Core/OrthographicCamera.h"
+#include "Renderer/Base/CurveBuffer.h"
 #include "Renderer/Base/Interval.h"
 #include "Renderer/Base/Shader.h"
 
@@ -11,6 +12,8 @@
 
 namespace DiffusionCurveRenderer
 {
+    class GradientAtlas;
+
     class ColorRenderer : protected QOpenGLExtraFunctions
     {
       public:
@@ -22,11 +25,13 @@ namespace DiffusionCurveRenderer
 
       private:
         void RenderPrivate(QOpenGLFramebufferObject* target);
-        void SetUniforms(BezierPtr curve);
+        void SetUniforms(int patchIndex);
         void BlitFramebuffer(QOpenGLFramebufferObject* source, QOpenGLFramebufferObject* target);
 
         Interval* mInterval;
         Shader* mColorShader;
+        GradientAtlas* mGradientAtlas;
+        CurveBuffer* mCurveBuffer;
 
         DEFINE_MEMBER(bool, UseMultisampleFramebuffer, false);
 
@@ -1,9 +1,10 @@
 #include "DownsampleRenderer.h"
 
 #include "Core/Constants.h"
+#include "Renderer/Base/GpuTimer.h"
 #include "Util/Chronometer.h"
 
-DiffusionCurveRenderer::DownsampleRenderer::DownsampleRenderer()
+DiffusionCurveRenderer::DownsampleRenderer::DownsampleRenderer(GLenum internalFormat)
 {
     initializeOpenGLFunctions();
 
@@ -18,7 +19,7 @@ DiffusionCurveRenderer::DownsampleRenderer::DownsampleRenderer()
     mFramebufferFormat.setSamples(0);
     mFramebufferFormat.setMipmap(false);
     mFramebufferFormat.setTextureTarget(GL_TEXTURE_2D);
-    mFramebufferFormat.setInternalTextureFormat(GL_RGBA8);
+    mFramebufferFormat.setInternalTextureFormat(internalFormat);
 
     SetFramebufferSize(DEFAULT_FRAMEBUFFER_SIZE);
 }
@@ -26,6 +27,7 @@ DiffusionCurveRenderer::DownsampleRenderer::DownsampleRenderer()
 void DiffusionCurveRenderer::DownsampleRenderer::Downsample(QOpenGLFramebufferObject* source)
 {
     MEASURE_CALL_TIME(DOWNSAMPLE_RENDERER);
+    MEASURE_GPU_TIME(GPU_DOWNSAMPLE_RENDERER);
 
     BlitSourceFramebuffer(source);
 
@@ -13,7 +13,8 @@ namespace DiffusionCurveRenderer
     class DownsampleRenderer : protected QOpenGLExtraFunctions
     {
       public:
-        DownsampleRenderer();
+        // Levels are GL_RGBA8 like the framebuffers of the solvers, other passes may ask for more precision
+        explicit DownsampleRenderer(GLenum internalFormat = GL_RGBA8);
 
         void Downsample(QOpenGLFramebufferObject* source);
 
@@ -0,0 +1,113 @@
+#include "GradientAtlas.h"
+
+#include "Util/Util.h"
+
+#include <algorithm>
+#include <bit>
+
+DiffusionCurveRenderer::GradientAtlas::GradientAtlas()
+{
+    initializeOpenGLFunctions();
+
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &mMaximumSize);
+
+    // Linear along a row interpolates between the baked texels, rows are fetched at their centers
+    glGenSamplers(1, &mSampler);
+    glSamplerParameteri(mSampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glSamplerParameteri(mSampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glSamplerParameteri(mSampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(mSampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    mTexels.resize(WIDTH);
+}
+
+DiffusionCurveRenderer::GradientAtlas::~GradientAtlas()
+{
+    glDeleteTextures(1, &mTexture);
+    glDeleteSamplers(1, &mSampler);
+}
+
+void DiffusionCurveRenderer::GradientAtlas::Update(const QList<CurvePtr>& curves)
+{
+    mRows.clear();
+
+    for (const auto& curve : curves)
+    {
+        if (const auto bezier = std::dynamic_pointer_cast<Bezier>(curve))
+        {
+            Append(bezier);
+        }
+        else if (const auto spline = std::dynamic_pointer_cast<Spline>(curve))
+        {
+            for (const auto& patch : spline->GetBezierPatches())
+                Append(patch);
+        }
+        else
+        {
+            DCR_EXIT_FAILURE("GradientAtlas::Update: Undefined curve type. Implement this branch!");
+        }
+    }
+
+    // A new texture has undefined contents, every row is baked
+    const bool allocated = mRows.size() > mHeight * mColumns;
+
+    if (allocated)
+        Allocate(mRows.size());
+
+    // Rows past the end keep their old contents, no curve samples them
+    mBakedRows.resize(std::max(mBakedRows.size(), mRows.size()));
+
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+    for (int i = 0; i < mRows.size(); ++i)
+    {
+        if (!allocated && mRows[i] == mBakedRows[i])
+            continue;
+
+        Bake(i);
+        mBakedRows[i] = mRows[i];
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void DiffusionCurveRenderer::GradientAtlas::Append(const BezierPtr& patch)
+{
+    mRows.push_back({ patch->GetLeftColors(), patch->GetLeftColorPositions() });
+    mRows.push_back({ patch->GetRightColors(), patch->GetRightColorPositions() });
+}
+
+void DiffusionCurveRenderer::GradientAtlas::Allocate(int rows)
+{
+    // Grows in powers of two so that adding curves one by one does not reallocate every frame
+    mHeight = std::min(static_cast<int>(std::bit_ceil(static_cast<unsigned>(rows))), mMaximumSize);
+    mColumns = (rows + mHeight - 1) / mHeight;
+
+    if (mColumns * WIDTH > mMaximumSize)
+    {
+        DCR_EXIT_FAILURE("GradientAtlas::Allocate: {} gradients do not fit into a texture.", rows);
+    }
+
+    // Immutable storage, texture storage cannot be resized
+    if (mTexture != 0)
+        glDeleteTextures(1, &mTexture);
+
+    glGenTextures(1, &mTexture);
+    glBindTexture(GL_TEXTURE_2D, mTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, mColumns * WIDTH, mHeight);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void DiffusionCurveRenderer::GradientAtlas::Bake(int row)
+{
+    const Row& gradient = mRows[row];
+
+    // Sides without color points bake transparent texels, they do not constrain the diffusion
+    for (int i = 0; i < WIDTH; ++i)
+        mTexels[i] = Util::InterpolateColor(gradient.colors, gradient.positions, i / float(WIDTH - 1));
+
+    const int column = row / mHeight;
+    glTexSubImage2D(GL_TEXTURE_2D, 0, column * WIDTH, row % mHeight, WIDTH, 1, GL_RGBA, GL_FLOAT, mTexels.constData());
+}
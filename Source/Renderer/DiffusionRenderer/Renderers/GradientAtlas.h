@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Core/CurveContainer.h"
+
+#include <QOpenGLExtraFunctions>
+#include <QVector4D>
+#include <QVector>
+
+namespace DiffusionCurveRenderer
+{
+    // Color gradients of the curves baked into a float texture, one row per side of every Bezier patch.
+    // Rows are assigned in the order the curves are drawn: patch i owns row 2i (left) and 2i + 1 (right). Rows wrap
+    // into further WIDTH texel columns once the height reaches GL_MAX_TEXTURE_SIZE, Color.geom resolves that from
+    // the texture size. A row is baked again only if the color stops of its side have changed since the last Update().
+    class GradientAtlas : protected QOpenGLExtraFunctions
+    {
+      public:
+        GradientAtlas();
+        ~GradientAtlas();
+
+        void Update(const QList<CurvePtr>& curves);
+
+        GLuint GetTexture() const { return mTexture; }
+        GLuint GetSampler() const { return mSampler; }
+
+        static constexpr int WIDTH = 256; // Texels per gradient, the first one is t = 0 and the last one is t = 1
+
+      private:
+        struct Row
+        {
+            QVector<QVector4D> colors;
+            QVector<float> positions;
+
+            bool operator==(const Row&) const = default;
+        };
+
+        void Append(const BezierPtr& patch);
+        void Allocate(int rows);
+        void Bake(int row);
+
+        QVector<Row> mRows;
+        QVector<Row> mBakedRows; // Contents of the texture
+        QVector<QVector4D> mTexels;
+
+        GLuint mTexture{ 0 };
+        GLuint mSampler{ 0 };
+        int mHeight{ 0 };
+        int mColumns{ 0 };
+        int mMaximumSize{ 0 };
+    };
+}
@@ -1,11 +1,12 @@
 #include "UpsampleRenderer.h"
 
 #include "Core/Constants.h"
+#include "Renderer/Base/GpuTimer.h"
 #include "Util/Chronometer.h"
 
 #include <QImage>
 
-DiffusionCurveRenderer::UpsampleRenderer::UpsampleRenderer()
+DiffusionCurveRenderer::UpsampleRenderer::UpsampleRenderer(GLenum internalFormat)
 {
     initializeOpenGLFunctions();
 
@@ -25,7 +26,7 @@ DiffusionCurveRenderer::UpsampleRenderer::UpsampleRenderer()
     mFramebufferFormat.setSamples(0);
     mFramebufferFormat.setMipmap(false);
     mFramebufferFormat.setTextureTarget(GL_TEXTURE_2D);
-    mFramebufferFormat.setInternalTextureFormat(GL_RGBA8);
+    mFramebufferFormat.setInternalTextureFormat(internalFormat);
 
     SetFramebufferSize(DEFAULT_FRAMEBUFFER_SIZE);
 }
@@ -33,6 +34,7 @@ DiffusionCurveRenderer::UpsampleRenderer::UpsampleRenderer()
 void DiffusionCurveRenderer::UpsampleRenderer::Upsample(QVector<QOpenGLFramebufferObject*> downsamples)
 {
     MEASURE_CALL_TIME(UPSAMPLE_RENDERER);
+    MEASURE_GPU_TIME(GPU_UPSAMPLE_RENDERER);
 
     BlitSourceFramebuffer(downsamples.last());
 
@@ -44,16 +46,22 @@ void DiffusionCurveRenderer::UpsampleRenderer::Upsample(QVector<QOpenGLFramebuff
 
 void DiffusionCurveRenderer::UpsampleRenderer::Upsample(QOpenGLFramebufferObject* target, QOpenGLFramebufferObject* temporary, QOpenGLFramebufferObject* source, QOpenGLFramebufferObject* constraint)
 {
-    target->bind();
-    glViewport(0, 0, target->width(), target->height());
-    glClearColor(0, 0, 0, 0);
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    mUpsampleShader->Bind();
-    mUpsampleShader->SetSampler("colorSourceTexture", 0, source->textures().at(0));
-    mUpsampleShader->SetSampler("colorTargetTexture", 1, constraint->textures().at(0));
-    mQuad->Render();
-    mUpsampleShader->Release();
+    { // Upsample pass
+        MEASURE_GPU_TIME_WITH_ARGS(GPU_UPSAMPLE_LEVEL, "{}Upsample {:>4}px", GPU_CHORONOMETER_PREFIX, target->width());
+
+        target->bind();
+        glViewport(0, 0, target->width(), target->height());
+        glClearColor(0, 0, 0, 0);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        mUpsampleShader->Bind();
+        mUpsampleShader->SetSampler("colorSourceTexture", 0, source->textures().at(0));
+        mUpsampleShader->SetSampler("colorTargetTexture", 1, constraint->textures().at(0));
+        mQuad->Render();
+        mUpsampleShader->Release();
+    }
+
+    MEASURE_GPU_TIME_WITH_ARGS(GPU_JACOBI_LEVEL, "{}Jacobi {:>4}px", GPU_CHORONOMETER_PREFIX, target->width());
 
     for (int j = 0; j < mSmoothIterations; j++)
     {
@@ -13,7 +13,8 @@ namespace DiffusionCurveRenderer
     class UpsampleRenderer : protected QOpenGLExtraFunctions
     {
       public:
-        UpsampleRenderer();
+        // Levels are GL_RGBA8 like the framebuffers of the solvers, other passes may ask for more precision
+        explicit UpsampleRenderer(GLenum internalFormat = GL_RGBA8);
 
         void Upsample(QVector<QOpenGLFramebufferObject*> downsamples);
 
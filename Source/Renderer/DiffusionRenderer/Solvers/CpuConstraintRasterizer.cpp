@@ -0,0 +1,279 @@
+#include "CpuConstraintRasterizer.h"
+
+#include "Core/Constants.h"
+#include "Util/Chronometer.h"
+#include "Util/Parallel.h"
+#include "Util/Util.h"
+
+#include <algorithm>
+#include <cmath>
+
+void DiffusionCurveRenderer::CpuConstraintRasterizer::Rasterize(cv::Mat& target)
+{
+    MEASURE_CALL_TIME(CPU_CONSTRAINT_RASTERIZER);
+
+    DCR_ASSERT(target.type() == CV_32FC4 && target.rows == target.cols);
+
+    const int size = target.rows;
+    const QMatrix4x4 projection = mCamera->GetProjectionMatrix();
+
+    // Curves cache their uniform arrays lazily, so they are only touched from this thread
+    CollectPatches();
+
+    const int trianglesPerPatch = NUMBER_OF_INTERVALS * TRIANGLES_PER_INTERVAL;
+
+    mTriangles.resize(size_t(mPatches.size()) * trianglesPerPatch);
+
+    Parallel::For(int(mPatches.size()), 16, [&](int begin, int end) { //
+        for (int i = begin; i < end; ++i)
+        {
+            BuildTriangles(mPatches[i], projection, size, &mTriangles[size_t(i) * trianglesPerPatch]);
+        }
+    });
+
+    // Bin triangles by rows, in submission order so that overlapping strips resolve like on the GPU
+    const int numberOfBins = (size + BIN_HEIGHT - 1) / BIN_HEIGHT;
+
+    mBins.resize(numberOfBins);
+
+    for (auto& bin : mBins)
+    {
+        bin.clear();
+    }
+
+    for (int i = 0; i < int(mTriangles.size()); ++i)
+    {
+        const Vertex* vertices = mTriangles[i].vertices;
+
+        const float minY = std::min({ vertices[0].y, vertices[1].y, vertices[2].y });
+        const float maxY = std::max({ vertices[0].y, vertices[1].y, vertices[2].y });
+
+        if (std::isfinite(minY) == false || std::isfinite(maxY) == false)
+            continue;
+
+        const int rowBegin = std::max(0, int(std::ceil(minY - 0.5f)));
+        const int rowEnd = std::min(size - 1, int(std::floor(maxY - 0.5f)));
+
+        for (int bin = rowBegin / BIN_HEIGHT; bin <= rowEnd / BIN_HEIGHT && rowBegin <= rowEnd; ++bin)
+        {
+            mBins[bin].push_back(i);
+        }
+    }
+
+    Parallel::For(numberOfBins, 1, [&](int begin, int end) { //
+        for (int bin = begin; bin < end; ++bin)
+        {
+            const int rowBegin = bin * BIN_HEIGHT;
+            const int rowEnd = std::min(size, rowBegin + BIN_HEIGHT);
+
+            for (const int index : mBins[bin])
+            {
+                FillTriangle(mTriangles[index], target, rowBegin, rowEnd);
+            }
+        }
+    });
+}
+
+void DiffusionCurveRenderer::CpuConstraintRasterizer::CollectPatches()
+{
+    mPatches.clear();
+
+    const auto append = [this](BezierPtr bezier, float diffusionWidth, float diffusionGap) {
+        Patch patch;
+        patch.controlPoints = bezier->GetControlPointPositions();
+        patch.leftColors = bezier->GetLeftColors();
+        patch.leftColorPositions = bezier->GetLeftColorPositions();
+        patch.rightColors = bezier->GetRightColors();
+        patch.rightColorPositions = bezier->GetRightColorPositions();
+        patch.diffusionWidth = diffusionWidth;
+        patch.diffusionGap = diffusionGap;
+        mPatches.push_back(patch);
+    };
+
+    for (const auto& curve : mCurveContainer->GetCurves())
+    {
+        if (const auto bezier = std::dynamic_pointer_cast<Bezier>(curve))
+        {
+            append(bezier, curve->GetDiffusionWidth(), curve->GetDiffusionGap());
+        }
+        else if (const auto spline = std::dynamic_pointer_cast<Spline>(curve))
+        {
+            for (const auto& patch : spline->GetBezierPatches())
+            {
+                append(patch, spline->GetDiffusionWidth(), spline->GetDiffusionGap());
+            }
+        }
+        else
+        {
+            DCR_EXIT_FAILURE("CpuConstraintRasterizer::CollectPatches: Undefined curve type. Implement this branch!");
+        }
+    }
+}
+
+void DiffusionCurveRenderer::CpuConstraintRasterizer::BuildTriangles(const Patch& patch, const QMatrix4x4& projection, float size, Triangle* triangles) const
+{
+    const float delta = 1.0f / NUMBER_OF_INTERVALS;
+
+    const auto toVertex = [&](const QVector2D& position, const QVector4D& color) {
+        const QVector3D ndc = projection.map(QVector3D(position, 0));
+
+        Vertex vertex;
+        vertex.x = 0.5f * (ndc.x() + 1.0f) * size;
+        vertex.y = 0.5f * (ndc.y() + 1.0f) * size;
+
+        for (int k = 0; k < 4; ++k)
+            vertex.color[k] = color[k];
+
+        return vertex;
+    };
+
+    // Same primitives as Color.geom, one quad per side and interval
+    for (int i = 0; i < NUMBER_OF_INTERVALS; ++i)
+    {
+        const float t0 = float(i) / NUMBER_OF_INTERVALS;
+        const float t1 = t0 + delta;
+
+        const QVector2D v0 = ValueAt(patch.controlPoints, t0);
+        const QVector2D v1 = ValueAt(patch.controlPoints, t1);
+
+        const QVector2D n0 = NormalAt(patch.controlPoints, t0);
+        const QVector2D n1 = NormalAt(patch.controlPoints, t1);
+
+        const QVector4D l0 = Util::InterpolateColor(patch.leftColors, patch.leftColorPositions, t0);
+        const QVector4D l1 = Util::InterpolateColor(patch.leftColors, patch.leftColorPositions, t1);
+
+        const QVector4D r0 = Util::InterpolateColor(patch.rightColors, patch.rightColorPositions, t0);
+        const QVector4D r1 = Util::InterpolateColor(patch.rightColors, patch.rightColorPositions, t1);
+
+        const float gap = 0.5f * patch.diffusionGap;
+        const float width = patch.diffusionWidth;
+
+        const Vertex left[4] = {
+            toVertex(v0 - gap * n0, l0),
+            toVertex(v0 - gap * n0 - width * n0, l0),
+            toVertex(v1 - gap * n1, l1),
+            toVertex(v1 - gap * n1 - width * n1, l1),
+        };
+
+        const Vertex right[4] = {
+            toVertex(v0 + gap * n0, r0),
+            toVertex(v0 + gap * n0 + width * n0, r0),
+            toVertex(v1 + gap * n1, r1),
+            toVertex(v1 + gap * n1 + width * n1, r1),
+        };
+
+        Triangle* quad = triangles + i * TRIANGLES_PER_INTERVAL;
+
+        quad[0] = { { left[0], left[1], left[2] } };
+        quad[1] = { { left[2], left[1], left[3] } };
+        quad[2] = { { right[0], right[1], right[2] } };
+        quad[3] = { { right[2], right[1], right[3] } };
+    }
+}
+
+void DiffusionCurveRenderer::CpuConstraintRasterizer::FillTriangle(const Triangle& triangle, cv::Mat& target, int rowBegin, int rowEnd) const
+{
+    const Vertex* a = &triangle.vertices[0];
+    const Vertex* b = &triangle.vertices[1];
+    const Vertex* c = &triangle.vertices[2];
+
+    float area = (b->x - a->x) * (c->y - a->y) - (b->y - a->y) * (c->x - a->x);
+
+    if (area == 0.0f || std::isfinite(area) == false)
+        return;
+
+    // Counter-clockwise from here on, the interior is left of every edge
+    if (area < 0.0f)
+    {
+        std::swap(b, c);
+        area = -area;
+    }
+
+    const float minX = std::min({ a->x, b->x, c->x });
+    const float maxX = std::max({ a->x, b->x, c->x });
+    const float minY = std::min({ a->y, b->y, c->y });
+    const float maxY = std::max({ a->y, b->y, c->y });
+
+    const int x0 = std::max(0, int(std::ceil(minX - 0.5f)));
+    const int x1 = std::min(target.cols - 1, int(std::floor(maxX - 0.5f)));
+    const int y0 = std::max(rowBegin, int(std::ceil(minY - 0.5f)));
+    const int y1 = std::min(rowEnd - 1, int(std::floor(maxY - 0.5f)));
+
+    // Top-left fill convention, pixels on a shared edge are drawn by exactly one triangle
+    const auto isInclusive = [](const Vertex* from, const Vertex* to) {
+        const float dx = to->x - from->x;
+        const float dy = to->y - from->y;
+        return dy < 0.0f || (dy == 0.0f && dx < 0.0f);
+    };
+
+    const auto edge = [](const Vertex* from, const Vertex* to, float x, float y) { //
+        return (to->x - from->x) * (y - from->y) - (to->y - from->y) * (x - from->x);
+    };
+
+    const bool inclusive0 = isInclusive(b, c);
+    const bool inclusive1 = isInclusive(c, a);
+    const bool inclusive2 = isInclusive(a, b);
+
+    const float inverseArea = 1.0f / area;
+
+    for (int y = y0; y <= y1; ++y)
+    {
+        float* row = target.ptr<float>(y);
+        const float py = y + 0.5f;
+
+        for (int x = x0; x <= x1; ++x)
+        {
+            const float px = x + 0.5f;
+
+            const float w0 = edge(b, c, px, py);
+            const float w1 = edge(c, a, px, py);
+            const float w2 = edge(a, b, px, py);
+
+            const bool inside = (w0 > 0.0f || (w0 == 0.0f && inclusive0)) && //
+                                (w1 > 0.0f || (w1 == 0.0f && inclusive1)) && //
+                                (w2 > 0.0f || (w2 == 0.0f && inclusive2));
+
+            if (inside == false)
+                continue;
+
+            for (int k = 0; k < 4; ++k)
+            {
+                row[4 * x + k] = (w0 * a->color[k] + w1 * b->color[k] + w2 * c->color[k]) * inverseArea;
+            }
+        }
+    }
+}
+
+QVector2D DiffusionCurveRenderer::CpuConstraintRasterizer::ValueAt(const QVector<QVector2D>& controlPoints, float t)
+{
+    const int degree = controlPoints.size() - 1;
+
+    QVector2D value(0, 0);
+    float choose = 1.0f;
+
+    for (int i = 0; i <= degree; ++i)
+    {
+        value += choose * std::pow(t, float(i)) * std::pow(1.0f - t, float(degree - i)) * controlPoints[i];
+        choose = choose * (degree - i) / (i + 1);
+    }
+
+    return value;
+}
+
+QVector2D DiffusionCurveRenderer::CpuConstraintRasterizer::NormalAt(const QVector<QVector2D>& controlPoints, float t)
+{
+    const int degree = controlPoints.size() - 1;
+
+    QVector2D tangent(0, 0);
+    float choose = 1.0f;
+
+    for (int i = 0; i <= degree - 1; ++i)
+    {
+        tangent += degree * choose * std::pow(t, float(i)) * std::pow(1.0f - t, float(degree - 1 - i)) * (controlPoints[i + 1] - controlPoints[i]);
+        choose = choose * (degree - 1 - i) / (i + 1);
+    }
+
+    tangent.normalize();
+
+    return QVector2D(-tangent.y(), tangent.x());
+}
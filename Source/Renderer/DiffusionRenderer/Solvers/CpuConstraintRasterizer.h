@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Core/CurveContainer.h"
+#include "Core/OrthographicCamera.h"
+#include "Util/Macros.h"
+
+#include <QVector>
+#include <opencv2/core/mat.hpp>
+#include <vector>
+
+namespace DiffusionCurveRenderer
+{
+    // Software version of ColorRenderer. Builds the same left and right color strips as Color.geom
+    // and fills them with pixel center sampling, later primitives overwrite earlier ones like in OpenGL.
+    class CpuConstraintRasterizer
+    {
+      public:
+        CpuConstraintRasterizer() = default;
+
+        // Target is a square CV_32FC4 image, first row is the bottom row like in OpenGL
+        void Rasterize(cv::Mat& target);
+
+      private:
+        struct Patch
+        {
+            QVector<QVector2D> controlPoints;
+            QVector<QVector4D> leftColors;
+            QVector<float> leftColorPositions;
+            QVector<QVector4D> rightColors;
+            QVector<float> rightColorPositions;
+            float diffusionWidth;
+            float diffusionGap;
+        };
+
+        struct Vertex
+        {
+            float x;
+            float y;
+            float color[4];
+        };
+
+        struct Triangle
+        {
+            Vertex vertices[3];
+        };
+
+        void CollectPatches();
+        void BuildTriangles(const Patch& patch, const QMatrix4x4& projection, float size, Triangle* triangles) const;
+        void FillTriangle(const Triangle& triangle, cv::Mat& target, int rowBegin, int rowEnd) const;
+
+        static QVector2D ValueAt(const QVector<QVector2D>& controlPoints, float t);
+        static QVector2D NormalAt(const QVector<QVector2D>& controlPoints, float t);
+
+        QVector<Patch> mPatches;
+        std::vector<Triangle> mTriangles;
+        std::vector<std::vector<int>> mBins;
+
+        static constexpr int TRIANGLES_PER_INTERVAL = 4;
+        static constexpr int BIN_HEIGHT = 32;
+
+        DEFINE_MEMBER_PTR(OrthographicCamera, Camera);
+        DEFINE_MEMBER_PTR(CurveContainer, CurveContainer);
+    };
+}
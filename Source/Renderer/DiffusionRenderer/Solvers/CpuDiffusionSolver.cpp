@@ -0,0 +1,307 @@
+#include "CpuDiffusionSolver.h"
+
+#include "Util/Chronometer.h"
+#include "Util/Parallel.h"
+
+#include <algorithm>
+#include <opencv2/core.hpp>
+
+namespace
+{
+    // Weighted 1-2-1 sum of three rows. Pixels whose alpha is not above the threshold do not contribute.
+    // Writes premultiplied RGBA sums and total weights, the horizontal pass divides them out.
+    void VerticalPass(const float* up, const float* center, const float* down, float* sums, float* weights, int width, float threshold)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const float mu = up[4 * x + 3] > threshold ? 1.0f : 0.0f;
+            const float mc = center[4 * x + 3] > threshold ? 2.0f : 0.0f;
+            const float md = down[4 * x + 3] > threshold ? 1.0f : 0.0f;
+
+            weights[x] = mu + mc + md;
+
+            for (int k = 0; k < 4; ++k)
+            {
+                sums[4 * x + k] = mu * up[4 * x + k] + mc * center[4 * x + k] + md * down[4 * x + k];
+            }
+        }
+    }
+
+    // Repeats the pixel at 'from' at 'to', same as GL_CLAMP_TO_EDGE
+    void ClampPixel(float* sums, float* weights, int from, int to)
+    {
+        weights[to] = weights[from];
+
+        for (int k = 0; k < 4; ++k)
+        {
+            sums[4 * to + k] = sums[4 * from + k];
+        }
+    }
+}
+
+DiffusionCurveRenderer::CpuDiffusionSolver::~CpuDiffusionSolver()
+{
+    if (mResultTexture && QOpenGLContext::currentContext())
+    {
+        glDeleteTextures(1, &mResultTexture);
+    }
+}
+
+void DiffusionCurveRenderer::CpuDiffusionSolver::Initialize()
+{
+    initializeOpenGLFunctions();
+
+    mInitialized = true;
+}
+
+void DiffusionCurveRenderer::CpuDiffusionSolver::Solve()
+{
+    MEASURE_CALL_TIME(CPU_DIFFUSION_SOLVER);
+
+    if (mAllocatedSize != mFramebufferSize)
+        Allocate(mFramebufferSize);
+
+    mConstraints[0].setTo(cv::Scalar::all(0));
+
+    mRasterizer.SetCamera(mCamera);
+    mRasterizer.SetCurveContainer(mCurveContainer);
+    mRasterizer.Rasterize(mConstraints[0]);
+
+    if (mBoundary.empty() == false)
+        ApplyBoundary(mConstraints[0]);
+
+    for (int i = 1; i < int(mConstraints.size()); ++i)
+    {
+        Downsample(mConstraints[i - 1], mConstraints[i]);
+    }
+
+    mConstraints.back().copyTo(mTargets.back());
+
+    // UpsampleRenderer reads its result from the target after the last odd pass,
+    // so an odd number of iterations behaves like one less
+    const int iterations = mSmoothIterations - mSmoothIterations % 2;
+
+    for (int i = int(mTargets.size()) - 2; i >= 0; --i)
+    {
+        Upsample(mTargets[i + 1], mConstraints[i], mTargets[i]);
+
+        for (int j = 0; j < iterations; ++j)
+        {
+            if (j % 2 == 0)
+                Jacobi(mTargets[i], mConstraints[i], mTemporaries[i]);
+            else
+                Jacobi(mTemporaries[i], mConstraints[i], mTargets[i]);
+        }
+    }
+
+    mLastSolveStats.levels = int(mTargets.size()) - 1;
+    mLastSolveStats.iterations = mLastSolveStats.levels * iterations;
+
+    mResultTextureDirty = true;
+}
+
+GLuint DiffusionCurveRenderer::CpuDiffusionSolver::GetResultTexture()
+{
+    DCR_ASSERT(mInitialized);
+
+    if (mResultTexture == 0)
+    {
+        glGenTextures(1, &mResultTexture);
+        glBindTexture(GL_TEXTURE_2D, mResultTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    if (mResultTextureDirty && mTargets.empty() == false)
+    {
+        const cv::Mat& result = mTargets.front();
+
+        // Rows are already in OpenGL order and tightly packed
+        glBindTexture(GL_TEXTURE_2D, mResultTexture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, result.cols, result.rows, 0, GL_RGBA, GL_FLOAT, result.ptr());
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        mResultTextureDirty = false;
+    }
+
+    return mResultTexture;
+}
+
+cv::Mat DiffusionCurveRenderer::CpuDiffusionSolver::GetResultImage()
+{
+    if (mTargets.empty())
+        return cv::Mat();
+
+    cv::Mat image;
+    cv::flip(mTargets.front(), image, 0);
+
+    return image;
+}
+
+cv::Mat DiffusionCurveRenderer::CpuDiffusionSolver::GetConstraintImage()
+{
+    if (mConstraints.empty())
+        return cv::Mat();
+
+    cv::Mat image;
+    cv::flip(mConstraints.front(), image, 0);
+
+    return image;
+}
+
+void DiffusionCurveRenderer::CpuDiffusionSolver::Allocate(int size)
+{
+    mConstraints.clear();
+    mTargets.clear();
+    mTemporaries.clear();
+
+    mAllocatedSize = size;
+
+    // Same pyramid as DownsampleRenderer and UpsampleRenderer
+    while (size > 2)
+    {
+        mConstraints.emplace_back(size, size, CV_32FC4);
+        mTargets.emplace_back(size, size, CV_32FC4);
+        mTemporaries.emplace_back(size, size, CV_32FC4);
+        size /= 2;
+    }
+}
+
+void DiffusionCurveRenderer::CpuDiffusionSolver::ApplyBoundary(cv::Mat& constraint) const
+{
+    DCR_ASSERT(mBoundary.size() == constraint.size() && mBoundary.type() == CV_32FC4);
+
+    const int height = constraint.rows;
+
+    Parallel::For(height, ROWS_PER_BAND, [&](int begin, int end) {
+        for (int y = begin; y < end; ++y)
+        {
+            // Boundary is top-down, constraints are in OpenGL row order
+            const float* boundary = mBoundary.ptr<float>(height - 1 - y);
+            float* fixed = constraint.ptr<float>(y);
+
+            for (int x = 0; x < constraint.cols; ++x)
+            {
+                if (fixed[4 * x + 3] > 0.1f || boundary[4 * x + 3] <= 0.1f)
+                    continue;
+
+                for (int k = 0; k < 4; ++k)
+                {
+                    fixed[4 * x + k] = boundary[4 * x + k];
+                }
+            }
+        }
+    });
+}
+
+void DiffusionCurveRenderer::CpuDiffusionSolver::Downsample(const cv::Mat& source, cv::Mat& target)
+{
+    const int width = source.cols;
+    const int height = source.rows;
+
+    // Downsample.frag samples the 3x3 block around texel (2x + 1, 2y + 1) with nearest filtering
+    Parallel::For(target.rows, ROWS_PER_BAND, [&](int begin, int end) {
+        std::vector<float> sums(4 * (width + 1));
+        std::vector<float> weights(width + 1);
+
+        for (int y = begin; y < end; ++y)
+        {
+            const float* up = source.ptr<float>(2 * y);
+            const float* center = source.ptr<float>(2 * y + 1);
+            const float* down = source.ptr<float>(std::min(2 * y + 2, height - 1));
+
+            VerticalPass(up, center, down, sums.data(), weights.data(), width, 0.1f);
+            ClampPixel(sums.data(), weights.data(), width - 1, width);
+
+            float* out = target.ptr<float>(y);
+
+            for (int x = 0; x < target.cols; ++x)
+            {
+                const int l = 2 * x;
+                const int c = 2 * x + 1;
+                const int r = 2 * x + 2;
+
+                const float weight = weights[l] + 2.0f * weights[c] + weights[r];
+                const float inverseWeight = weight > 0.0f ? 1.0f / weight : 0.0f;
+
+                for (int k = 0; k < 4; ++k)
+                {
+                    out[4 * x + k] = (sums[4 * l + k] + 2.0f * sums[4 * c + k] + sums[4 * r + k]) * inverseWeight;
+                }
+            }
+        }
+    });
+}
+
+void DiffusionCurveRenderer::CpuDiffusionSolver::Upsample(const cv::Mat& source, const cv::Mat& constraint, cv::Mat& target)
+{
+    Parallel::For(target.rows, ROWS_PER_BAND, [&](int begin, int end) {
+        for (int y = begin; y < end; ++y)
+        {
+            const float* coarse = source.ptr<float>(y / 2);
+            const float* fixed = constraint.ptr<float>(y);
+            float* out = target.ptr<float>(y);
+
+            for (int x = 0; x < target.cols; ++x)
+            {
+                const bool constrained = fixed[4 * x + 3] > 0.1f;
+
+                for (int k = 0; k < 4; ++k)
+                {
+                    out[4 * x + k] = constrained ? fixed[4 * x + k] : coarse[4 * (x / 2) + k];
+                }
+            }
+        }
+    });
+}
+
+void DiffusionCurveRenderer::CpuDiffusionSolver::Jacobi(const cv::Mat& source, const cv::Mat& constraint, cv::Mat& target)
+{
+    const int width = source.cols;
+    const int height = source.rows;
+
+    Parallel::For(height, ROWS_PER_BAND, [&](int begin, int end) {
+        // One pixel of padding on both sides keeps the horizontal pass free of edge checks
+        std::vector<float> paddedSums(4 * (width + 2));
+        std::vector<float> paddedWeights(width + 2);
+
+        float* sums = paddedSums.data();
+        float* weights = paddedWeights.data();
+
+        for (int y = begin; y < end; ++y)
+        {
+            const float* up = source.ptr<float>(std::min(y + 1, height - 1));
+            const float* center = source.ptr<float>(y);
+            const float* down = source.ptr<float>(std::max(y - 1, 0));
+
+            VerticalPass(up, center, down, sums + 4, weights + 1, width, 0.0f);
+            ClampPixel(sums, weights, 1, 0);
+            ClampPixel(sums, weights, width, width + 1);
+
+            const float* fixed = constraint.ptr<float>(y);
+            float* out = target.ptr<float>(y);
+
+            for (int x = 0; x < width; ++x)
+            {
+                const float weight = weights[x] + 2.0f * weights[x + 1] + weights[x + 2];
+                const float inverseWeight = weight > 0.0f ? 1.0f / weight : 0.0f;
+                const bool constrained = fixed[4 * x + 3] > 0.1f;
+
+                for (int k = 0; k < 4; ++k)
+                {
+                    const float sum = sums[4 * x + k] + 2.0f * sums[4 * (x + 1) + k] + sums[4 * (x + 2) + k];
+
+                    // Jacobi.frag writes white where no neighbor has been reached yet
+                    const float smoothed = weight > 0.0f ? sum * inverseWeight : 1.0f;
+
+                    out[4 * x + k] = constrained ? fixed[4 * x + k] : smoothed;
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Renderer/DiffusionRenderer/Solvers/CpuConstraintRasterizer.h"
+#include "Renderer/DiffusionRenderer/Solvers/DiffusionSolver.h"
+
+#include <QOpenGLExtraFunctions>
+#include <vector>
+
+namespace DiffusionCurveRenderer
+{
+    // Multithreaded software version of the GPU pipeline, for machines without a usable GPU.
+    // Mirrors Downsample.frag, Upsample.frag and Jacobi.frag on CV_32FC4 images kept in OpenGL row order.
+    // Images are processed in bands of rows on the Parallel pool, row kernels are written to auto-vectorize.
+    // OpenGL is only used when the result is requested as a texture.
+    class CpuDiffusionSolver : public DiffusionSolver, protected QOpenGLExtraFunctions
+    {
+      public:
+        CpuDiffusionSolver() = default;
+        ~CpuDiffusionSolver();
+
+        void Initialize() override;
+        void Solve() override;
+
+        GLuint GetResultTexture() override;
+        cv::Mat GetResultImage() override;
+        cv::Mat GetConstraintImage() override;
+
+        // Extra fixed values for the following solves as a top-down CV_32FC4 image of FramebufferSize, pass an empty
+        // image to remove them. Opaque pixels act like the curve strips unless a strip already covers them.
+        void SetBoundary(const cv::Mat& boundary) { mBoundary = boundary; }
+
+      protected:
+        void Allocate(int size);
+        void ApplyBoundary(cv::Mat& constraint) const;
+
+        static void Downsample(const cv::Mat& source, cv::Mat& target);
+        static void Upsample(const cv::Mat& source, const cv::Mat& constraint, cv::Mat& target);
+        static void Jacobi(const cv::Mat& source, const cv::Mat& constraint, cv::Mat& target);
+
+        CpuConstraintRasterizer mRasterizer;
+
+        std::vector<cv::Mat> mConstraints;
+        std::vector<cv::Mat> mTargets;
+        std::vector<cv::Mat> mTemporaries;
+        cv::Mat mBoundary;
+
+        GLuint mResultTexture{ 0 };
+        bool mResultTextureDirty{ true };
+        bool mInitialized{ false };
+
+        int mAllocatedSize{ 0 };
+
+        static constexpr int ROWS_PER_BAND = 16;
+    };
+}
@@ -0,0 +1,42 @@
+#include "DiffusionSolver.h"
+
+#include <cmath>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+double DiffusionCurveRenderer::DiffusionSolver::ComputeResidual(const cv::Mat& result, const cv::Mat& constraints)
+{
+    DCR_ASSERT(result.type() == CV_32FC4 && constraints.type() == CV_32FC4 && result.size() == constraints.size());
+
+    // Same 3x3 weights, alpha masks and clamped borders as Jacobi.frag
+    const cv::Mat kernel = (cv::Mat_<float>(3, 3) << 1, 2, 1, 2, 4, 2, 1, 2, 1);
+
+    std::vector<cv::Mat> resultChannels;
+    std::vector<cv::Mat> constraintChannels;
+    cv::split(result, resultChannels);
+    cv::split(constraints, constraintChannels);
+
+    cv::Mat reached = resultChannels[3] > 0.0f;
+    cv::Mat unconstrained = constraintChannels[3] <= 0.1f;
+    reached.convertTo(reached, CV_32F, 1.0 / 255.0);
+
+    cv::Mat weights;
+    cv::filter2D(reached, weights, CV_32F, kernel, cv::Point(-1, -1), 0, cv::BORDER_REPLICATE);
+
+    double sumOfSquares = 0.0;
+
+    for (int k = 0; k < 4; ++k)
+    {
+        cv::Mat sums;
+        cv::filter2D(resultChannels[k].mul(reached), sums, CV_32F, kernel, cv::Point(-1, -1), 0, cv::BORDER_REPLICATE);
+
+        cv::Mat difference = resultChannels[k] - sums / cv::max(weights, 1e-6f);
+        difference.setTo(0, ~unconstrained);
+
+        sumOfSquares += difference.dot(difference);
+    }
+
+    const int count = cv::countNonZero(unconstrained);
+
+    return count > 0 ? std::sqrt(sumOfSquares / (4.0 * count)) : 0.0;
+}
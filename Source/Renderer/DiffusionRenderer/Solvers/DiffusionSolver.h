@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Core/Constants.h"
+#include "Core/CurveContainer.h"
+#include "Core/OrthographicCamera.h"
+#include "Util/Macros.h"
+
+#include <QOpenGLContext>
+#include <opencv2/core/mat.hpp>
+
+namespace DiffusionCurveRenderer
+{
+    struct SolveStats
+    {
+        int levels{ 0 };     // Pyramid levels that were smoothed
+        int iterations{ 0 }; // Smoothing passes summed over all levels
+    };
+
+    // Rasterizes the color strips of the curves into a square framebuffer and diffuses them into the empty space.
+    // Settings are plain members and are picked up by the next Solve().
+    class DiffusionSolver
+    {
+        DISABLE_COPY(DiffusionSolver);
+
+      public:
+        DiffusionSolver() = default;
+        virtual ~DiffusionSolver() = default;
+
+        // Requires a current OpenGL context
+        virtual void Initialize() = 0;
+
+        virtual void Solve() = 0;
+
+        // Result of the last Solve() as a FramebufferSize x FramebufferSize texture, requires a current OpenGL context
+        virtual GLuint GetResultTexture() = 0;
+
+        // Result of the last Solve() as CV_32FC4 RGBA in [0, 1], first row is the top row
+        virtual cv::Mat GetResultImage() = 0;
+
+        // Rasterized color strips of the last Solve(), same layout as GetResultImage()
+        virtual cv::Mat GetConstraintImage() = 0;
+
+        // Blocks until the last Solve() has completed, for wall clock measurements
+        virtual void Finish() {}
+
+        // RMS change one more smoothing pass would make to the unconstrained pixels of result
+        static double ComputeResidual(const cv::Mat& result, const cv::Mat& constraints);
+
+        DEFINE_MEMBER(int, FramebufferSize, DEFAULT_FRAMEBUFFER_SIZE);
+        DEFINE_MEMBER(int, SmoothIterations, DEFAULT_SMOOTH_ITERATIONS);
+        DEFINE_MEMBER(bool, UseMultisampleFramebuffer, false);
+        DEFINE_MEMBER_CONST(SolveStats, LastSolveStats);
+
+        DEFINE_MEMBER_PTR(OrthographicCamera, Camera);
+        DEFINE_MEMBER_PTR(CurveContainer, CurveContainer);
+    };
+}
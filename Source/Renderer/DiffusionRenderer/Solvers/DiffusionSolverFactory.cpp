@@ -0,0 +1,57 @@
+#include "DiffusionSolverFactory.h"
+
+#include "Renderer/DiffusionRenderer/Solvers/CpuDiffusionSolver.h"
+#include "Renderer/DiffusionRenderer/Solvers/GpuDiffusionSolver.h"
+#include "Renderer/DiffusionRenderer/Solvers/PcgDiffusionSolver.h"
+#include "Util/Logger.h"
+
+DiffusionCurveRenderer::DiffusionSolver* DiffusionCurveRenderer::DiffusionSolverFactory::Create(DiffusionSolverType type)
+{
+    switch (type)
+    {
+    case DiffusionSolverType::Gpu:
+        return new GpuDiffusionSolver;
+    case DiffusionSolverType::Cpu:
+        return new CpuDiffusionSolver;
+    case DiffusionSolverType::Pcg:
+        return new PcgDiffusionSolver;
+    }
+
+    DCR_EXIT_FAILURE("DiffusionSolverFactory::Create: Undefined solver type. Implement this branch!");
+}
+
+const QVector<DiffusionCurveRenderer::DiffusionSolverType>& DiffusionCurveRenderer::DiffusionSolverFactory::GetTypes()
+{
+    static const QVector<DiffusionSolverType> TYPES = { DiffusionSolverType::Gpu, DiffusionSolverType::Cpu, DiffusionSolverType::Pcg };
+
+    return TYPES;
+}
+
+const char* DiffusionCurveRenderer::DiffusionSolverFactory::GetName(DiffusionSolverType type)
+{
+    switch (type)
+    {
+    case DiffusionSolverType::Gpu:
+        return "GPU";
+    case DiffusionSolverType::Cpu:
+        return "CPU";
+    case DiffusionSolverType::Pcg:
+        return "PCG";
+    }
+
+    return "Unknown";
+}
+
+bool DiffusionCurveRenderer::DiffusionSolverFactory::FromName(const QString& name, DiffusionSolverType& type)
+{
+    for (const auto candidate : GetTypes())
+    {
+        if (name.compare(GetName(candidate), Qt::CaseInsensitive) == 0)
+        {
+            type = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
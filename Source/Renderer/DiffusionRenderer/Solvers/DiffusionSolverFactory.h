@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Renderer/DiffusionRenderer/Solvers/DiffusionSolver.h"
+#include "Structs/Enums.h"
+
+#include <QString>
+#include <QVector>
+
+namespace DiffusionCurveRenderer
+{
+    // Single place that knows every solver, new backends only need an enum value and a case here
+    class DiffusionSolverFactory
+    {
+      public:
+        DiffusionSolverFactory() = delete;
+
+        static DiffusionSolver* Create(DiffusionSolverType type);
+
+        static const QVector<DiffusionSolverType>& GetTypes();
+        static const char* GetName(DiffusionSolverType type);
+
+        // Case insensitive lookup by GetName(), returns false for unknown names
+        static bool FromName(const QString& name, DiffusionSolverType& type);
+    };
+}
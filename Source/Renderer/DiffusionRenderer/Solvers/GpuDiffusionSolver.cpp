@@ -0,0 +1,86 @@
+#include "GpuDiffusionSolver.h"
+
+#include "Renderer/DiffusionRenderer/Renderers/ColorRenderer.h"
+#include "Renderer/DiffusionRenderer/Renderers/DownsampleRenderer.h"
+#include "Renderer/DiffusionRenderer/Renderers/UpsampleRenderer.h"
+
+#include <opencv2/core.hpp>
+
+void DiffusionCurveRenderer::GpuDiffusionSolver::Initialize()
+{
+    initializeOpenGLFunctions();
+
+    mColorRenderer = new ColorRenderer;
+    mColorRenderer->SetCamera(mCamera);
+    mColorRenderer->SetCurveContainer(mCurveContainer);
+
+    mDownsampleRenderer = new DownsampleRenderer;
+    mUpsampleRenderer = new UpsampleRenderer;
+
+    mFramebufferFormat.setAttachment(QOpenGLFramebufferObject::NoAttachment);
+    mFramebufferFormat.setSamples(0);
+
+    Allocate(mFramebufferSize);
+}
+
+void DiffusionCurveRenderer::GpuDiffusionSolver::Solve()
+{
+    if (mAllocatedSize != mFramebufferSize)
+        Allocate(mFramebufferSize);
+
+    mColorRenderer->SetUseMultisampleFramebuffer(mUseMultisampleFramebuffer);
+    mUpsampleRenderer->SetSmoothIterations(mSmoothIterations);
+
+    mColorRenderer->Render(mFramebuffer.get());
+    mDownsampleRenderer->Downsample(mFramebuffer.get());
+    mUpsampleRenderer->Upsample(mDownsampleRenderer->GetFramebuffers());
+
+    mLastSolveStats.levels = mDownsampleRenderer->GetFramebuffers().size() - 1;
+    mLastSolveStats.iterations = mLastSolveStats.levels * mSmoothIterations;
+}
+
+GLuint DiffusionCurveRenderer::GpuDiffusionSolver::GetResultTexture()
+{
+    return mUpsampleRenderer->GetResult()->texture();
+}
+
+cv::Mat DiffusionCurveRenderer::GpuDiffusionSolver::GetResultImage()
+{
+    return ReadImage(mUpsampleRenderer->GetResult());
+}
+
+cv::Mat DiffusionCurveRenderer::GpuDiffusionSolver::GetConstraintImage()
+{
+    return ReadImage(mFramebuffer.get());
+}
+
+void DiffusionCurveRenderer::GpuDiffusionSolver::Finish()
+{
+    glFinish();
+}
+
+cv::Mat DiffusionCurveRenderer::GpuDiffusionSolver::ReadImage(QOpenGLFramebufferObject* framebuffer)
+{
+    cv::Mat image(framebuffer->height(), framebuffer->width(), CV_32FC4);
+
+    framebuffer->bind();
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, framebuffer->width(), framebuffer->height(), GL_RGBA, GL_FLOAT, image.ptr());
+    framebuffer->release();
+
+    // OpenGL rows start at the bottom
+    cv::flip(image, image, 0);
+
+    return image;
+}
+
+void DiffusionCurveRenderer::GpuDiffusionSolver::Allocate(int size)
+{
+    mFramebuffer = std::make_unique<QOpenGLFramebufferObject>(size, size, mFramebufferFormat);
+
+    mColorRenderer->SetFramebufferSize(size);
+    mDownsampleRenderer->SetFramebufferSize(size);
+    mUpsampleRenderer->SetFramebufferSize(size);
+
+    mAllocatedSize = size;
+}
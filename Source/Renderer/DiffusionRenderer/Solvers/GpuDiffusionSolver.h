@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Renderer/DiffusionRenderer/Solvers/DiffusionSolver.h"
+
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+#include <memory>
+
+namespace DiffusionCurveRenderer
+{
+    class ColorRenderer;
+    class DownsampleRenderer;
+    class UpsampleRenderer;
+
+    // Original OpenGL pipeline: ColorRenderer -> DownsampleRenderer -> UpsampleRenderer with Jacobi smoothing
+    class GpuDiffusionSolver : public DiffusionSolver, protected QOpenGLExtraFunctions
+    {
+      public:
+        GpuDiffusionSolver() = default;
+
+        void Initialize() override;
+        void Solve() override;
+
+        GLuint GetResultTexture() override;
+        cv::Mat GetResultImage() override;
+        cv::Mat GetConstraintImage() override;
+
+        void Finish() override;
+
+      private:
+        void Allocate(int size);
+        cv::Mat ReadImage(QOpenGLFramebufferObject* framebuffer);
+
+        ColorRenderer* mColorRenderer;
+        DownsampleRenderer* mDownsampleRenderer;
+        UpsampleRenderer* mUpsampleRenderer;
+
+        QOpenGLFramebufferObjectFormat mFramebufferFormat;
+        std::unique_ptr<QOpenGLFramebufferObject> mFramebuffer{ nullptr };
+
+        int mAllocatedSize{ 0 };
+    };
+}
@@ -0,0 +1,151 @@
+#include "PcgDiffusionSolver.h"
+
+#include "Util/Chronometer.h"
+#include "Util/Parallel.h"
+
+#include <cmath>
+#include <numbers>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+void DiffusionCurveRenderer::PcgDiffusionSolver::Solve()
+{
+    CpuDiffusionSolver::Solve();
+
+    MEASURE_CALL_TIME(PCG_DIFFUSION_SOLVER);
+
+    cv::Mat& result = mTargets.front();
+    const cv::Mat& constraint = mConstraints.front();
+
+    std::vector<cv::Mat> channels;
+    std::vector<cv::Mat> constraintChannels;
+    cv::split(result, channels);
+    cv::split(constraint, constraintChannels);
+
+    // Same threshold as the shaders, everything else is an unknown
+    cv::Mat unknowns;
+    cv::threshold(constraintChannels[3], unknowns, 0.1, 1.0, cv::THRESH_BINARY_INV);
+
+    const int numberOfUnknowns = cv::countNonZero(unknowns);
+
+    if (numberOfUnknowns == 0 || numberOfUnknowns == int(unknowns.total()))
+        return; // Nothing to diffuse into, or nothing to diffuse from
+
+    if (mInverseEigenvalues.rows != result.rows)
+        UpdateEigenvalues(result.rows);
+
+    int iterations[4] = { 0, 0, 0, 0 };
+
+    // Channels are independent systems with the same matrix
+    Parallel::For(4, 1, [&](int begin, int end) {
+        for (int k = begin; k < end; ++k)
+        {
+            const cv::Mat fixed = constraintChannels[k].mul(1.0f - unknowns);
+            iterations[k] = SolveChannel(channels[k], fixed, unknowns);
+        }
+    });
+
+    cv::merge(channels, result);
+
+    mLastSolveStats.iterations += std::max({ iterations[0], iterations[1], iterations[2], iterations[3] });
+}
+
+int DiffusionCurveRenderer::PcgDiffusionSolver::SolveChannel(cv::Mat& channel, const cv::Mat& fixed, const cv::Mat& unknowns) const
+{
+    // Unknowns are the free pixels of x, constrained pixels hold their fixed values and never change
+    cv::Mat x = channel.mul(unknowns) + fixed;
+
+    cv::Mat r;
+    ApplyOperator(x, unknowns, r);
+    r = -r;
+
+    const double initialNorm = std::sqrt(r.dot(r));
+
+    if (initialNorm == 0.0)
+        return 0;
+
+    cv::Mat z;
+    ApplyPreconditioner(r, unknowns, z);
+
+    cv::Mat p = z.clone();
+    cv::Mat q;
+
+    double rz = r.dot(z);
+    int iteration = 0;
+
+    while (iteration < mMaximumIterations)
+    {
+        ++iteration;
+
+        ApplyOperator(p, unknowns, q);
+
+        const double pq = p.dot(q);
+
+        if (pq <= 0.0)
+            break;
+
+        const double alpha = rz / pq;
+
+        cv::scaleAdd(p, alpha, x, x);
+        cv::scaleAdd(q, -alpha, r, r);
+
+        if (std::sqrt(r.dot(r)) <= mTolerance * initialNorm)
+            break;
+
+        ApplyPreconditioner(r, unknowns, z);
+
+        const double rzNext = r.dot(z);
+        const double beta = rzNext / rz;
+        rz = rzNext;
+
+        cv::scaleAdd(p, beta, z, p);
+    }
+
+    channel = x;
+
+    return iteration;
+}
+
+void DiffusionCurveRenderer::PcgDiffusionSolver::ApplyOperator(const cv::Mat& source, const cv::Mat& unknowns, cv::Mat& target) const
+{
+    // 16 u - (1 2 1) x (1 2 1) * u, the Jacobi.frag weights. Replicated borders are the clamped texture reads
+    // and make the stencil a Neumann operator that the DCT-II diagonalizes.
+    static const cv::Mat kernel = (cv::Mat_<float>(3, 3) << -1, -2, -1, -2, 12, -2, -1, -2, -1);
+
+    cv::filter2D(source, target, CV_32F, kernel, cv::Point(-1, -1), 0, cv::BORDER_REPLICATE);
+    target = target.mul(unknowns);
+}
+
+void DiffusionCurveRenderer::PcgDiffusionSolver::ApplyPreconditioner(const cv::Mat& source, const cv::Mat& unknowns, cv::Mat& target) const
+{
+    cv::Mat spectrum;
+    cv::dct(source, spectrum);
+    spectrum = spectrum.mul(mInverseEigenvalues);
+    cv::dct(spectrum, target, cv::DCT_INVERSE);
+    target = target.mul(unknowns);
+}
+
+void DiffusionCurveRenderer::PcgDiffusionSolver::UpdateEigenvalues(int size)
+{
+    // Eigenvalues of the stencil for the cosine modes, screened a little so the constant mode stays invertible
+    const float screening = std::numbers::pi_v<float> * std::numbers::pi_v<float> / (float(size) * size);
+
+    std::vector<float> factors(size);
+
+    for (int i = 0; i < size; ++i)
+    {
+        factors[i] = 2.0f + 2.0f * std::cos(std::numbers::pi_v<float> * i / size);
+    }
+
+    mInverseEigenvalues.create(size, size, CV_32F);
+
+    for (int y = 0; y < size; ++y)
+    {
+        float* row = mInverseEigenvalues.ptr<float>(y);
+
+        for (int x = 0; x < size; ++x)
+        {
+            row[x] = 1.0f / (16.0f - factors[x] * factors[y] + screening);
+        }
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Renderer/DiffusionRenderer/Solvers/CpuDiffusionSolver.h"
+
+namespace DiffusionCurveRenderer
+{
+    // Converged software solve for offline exports. The pyramid result of CpuDiffusionSolver is used as the
+    // initial guess and refined with conjugate gradients on the Jacobi.frag stencil, the rasterized strips
+    // act as Dirichlet constraints. The preconditioner inverts the same stencil on the unconstrained grid
+    // with a pair of DCTs, which is exact away from the constraints, so only a few dozen iterations are needed.
+    class PcgDiffusionSolver : public CpuDiffusionSolver
+    {
+      public:
+        PcgDiffusionSolver() = default;
+
+        void Solve() override;
+
+      private:
+        // Returns the number of iterations, channel is solved in place
+        int SolveChannel(cv::Mat& channel, const cv::Mat& fixed, const cv::Mat& unknowns) const;
+
+        void ApplyOperator(const cv::Mat& source, const cv::Mat& unknowns, cv::Mat& target) const;
+        void ApplyPreconditioner(const cv::Mat& source, const cv::Mat& unknowns, cv::Mat& target) const;
+
+        void UpdateEigenvalues(int size);
+
+        cv::Mat mInverseEigenvalues;
+
+        DEFINE_MEMBER(int, MaximumIterations, 100);
+        DEFINE_MEMBER(float, Tolerance, 1e-4f); // Relative to the initial residual
+    };
+}
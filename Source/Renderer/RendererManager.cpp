@@ -1,10 +1,12 @@
 #include "RendererManager.h"
 
 #include "Core/Constants.h"
+#include "Renderer/Base/GpuTimer.h"
 #include "Renderer/BitmapRenderer/BitmapRenderer.h"
 #include "Renderer/ContourRenderer/ContourRenderer.h"
 #include "Renderer/DiffusionRenderer/DiffusionRenderer.h"
 #include "Util/Chronometer.h"
+#include "Util/Logger.h"
 
 #include <QImage>
 
@@ -12,6 +14,8 @@ void DiffusionCurveRenderer::RendererManager::Initialize()
 {
     initializeOpenGLFunctions();
 
+    mGpuTimer = new GpuTimer;
+
     mContourRenderer = new ContourRenderer;
     mContourRenderer->SetCamera(mCamera);
     mContourRenderer->SetCurveContainer(mCurveContainer);
@@ -37,6 +41,11 @@ void DiffusionCurveRenderer::RendererManager::Resize(int width, int height)
     mCurveSelectionRenderer->Resize(width, height);
 }
 
+void DiffusionCurveRenderer::RendererManager::BeginFrame()
+{
+    mGpuTimer->BeginFrame();
+}
+
 void DiffusionCurveRenderer::RendererManager::Clear()
 {
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -55,17 +64,12 @@ void DiffusionCurveRenderer::RendererManager::RenderContours()
     mContourRenderer->Render();
 }
 
-void DiffusionCurveRenderer::RendererManager::RenderForCurveSelection()
-{
-    mCurveSelectionRenderer->Render();
-}
-
 void DiffusionCurveRenderer::RendererManager::RenderCurve(CurvePtr curve)
 {
     mContourRenderer->RenderCurve(curve);
 }
 
-void DiffusionCurveRenderer::RendererManager::Save(const QString& path, RenderModes renderModes)
+bool DiffusionCurveRenderer::RendererManager::Save(const QString& path, RenderModes renderModes)
 {
     mSaveFramebuffer = std::make_unique<QOpenGLFramebufferObject>(mCamera->GetWidth(), mCamera->GetHeight());
 
@@ -81,7 +85,13 @@ void DiffusionCurveRenderer::RendererManager::Save(const QString& path, RenderMo
     if (renderModes.testAnyFlag(RenderMode::Contour))
         mContourRenderer->Render(mSaveFramebuffer.get());
 
-    mSaveFramebuffer->toImage().save(path);
+    if (mSaveFramebuffer->toImage().save(path) == false)
+    {
+        LOG_WARN("RendererManager::Save: Could not write '{}'.", path.toStdString());
+        return false;
+    }
+
+    return true;
 }
 
 void DiffusionCurveRenderer::RendererManager::SetFramebufferSize(int size)
@@ -100,6 +110,16 @@ void DiffusionCurveRenderer::RendererManager::SetUseMultisampleFramebuffer(bool
     mDiffusionRenderer->SetUseMultisampleFramebuffer(val);
 }
 
+void DiffusionCurveRenderer::RendererManager::SetDiffusionSolverType(DiffusionSolverType type)
+{
+    mDiffusionRenderer->SetSolverType(type);
+}
+
+DiffusionCurveRenderer::DiffusionSolverType DiffusionCurveRenderer::RendererManager::GetDiffusionSolverType() const
+{
+    return mDiffusionRenderer->GetSolverType();
+}
+
 int DiffusionCurveRenderer::RendererManager::GetSmoothIterations() const
 {
     return mDiffusionRenderer->GetSmoothIterations();
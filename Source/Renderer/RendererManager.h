@@ -19,6 +19,7 @@ namespace DiffusionCurveRenderer
     class ContourRenderer;
     class DiffusionRenderer;
     class BitmapRenderer;
+    class GpuTimer;
 
     class RendererManager : protected QOpenGLExtraFunctions
     {
@@ -28,22 +29,28 @@ namespace DiffusionCurveRenderer
         void Initialize();
         void Resize(int width, int height);
 
+        // Advances the GPU timer ring, call once per frame
+        void BeginFrame();
+
         void Clear();
         void RenderDiffusion();
         void RenderContours();
-        void RenderForCurveSelection();
         void RenderCurve(CurvePtr curve);
 
-        void Save(const QString& path, RenderModes renderModes);
+        // Returns false if the image could not be written, e.g. for an unsupported extension or a missing directory
+        bool Save(const QString& path, RenderModes renderModes);
 
         BitmapRenderer* GetBitmapRenderer() { return mBitmapRenderer; }
+        DiffusionRenderer* GetDiffusionRenderer() { return mDiffusionRenderer; }
 
         void SetFramebufferSize(int size);
         void SetSmoothIterations(int smoothIterations);
         void SetUseMultisampleFramebuffer(bool val);
         void SetBackgroundColor(const QVector4D& color) { mBackgroundColor = color; }
+        void SetDiffusionSolverType(DiffusionSolverType type);
 
         int GetSmoothIterations() const;
+        DiffusionSolverType GetDiffusionSolverType() const;
         int GetFramebufferSize() const { return mFramebufferSize; };
         const QVector4D& GetBackgroundColor() const { return mBackgroundColor; }
 
@@ -54,6 +61,7 @@ namespace DiffusionCurveRenderer
         DiffusionRenderer* mDiffusionRenderer;
         CurveSelectionRenderer* mCurveSelectionRenderer;
         BitmapRenderer* mBitmapRenderer;
+        GpuTimer* mGpuTimer;
 
         int mFramebufferSize{ DEFAULT_FRAMEBUFFER_SIZE };
         QVector4D mBackgroundColor{ 1.0f, 1.0f, 1.0f, 1.0f };
@@ -0,0 +1,504 @@
+#include "DeepZoomExporter.h"
+
+#include "Curve/Spline.h"
+#include "Util/Chronometer.h"
+#include "Util/Logger.h"
+#include "Util/Parallel.h"
+
+#include <QByteArrayView>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QXmlStreamWriter>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <opencv2/imgproc.hpp>
+
+void DiffusionCurveRenderer::DeepZoomExporter::Initialize()
+{
+    mTileRenderer.SetCurveContainer(mCurveContainer);
+    mTileRenderer.Initialize();
+}
+
+bool DiffusionCurveRenderer::DeepZoomExporter::Start(const QString& path, int width, int height, RenderModes renderModes)
+{
+    if (IsRunning())
+    {
+        LOG_WARN("DeepZoomExporter::Start: An export is already running.");
+        return false;
+    }
+
+    const int core = mWindowSize - 2 * mWindowOverlap;
+
+    // Windows keep whole tiles and a tile reaches one pixel into its neighbors
+    if (mWindowSize < 2 * TILE_SIZE || (mWindowSize & (mWindowSize - 1)) != 0 || mWindowOverlap < TILE_OVERLAP || core < mWindowSize / 2 || core % TILE_SIZE != 0)
+    {
+        LOG_WARN("DeepZoomExporter::Start: Window size must be a power of two of at least {} and the window size minus twice the overlap a multiple of {}.", 2 * TILE_SIZE, TILE_SIZE);
+        return false;
+    }
+
+    if (width <= 0 || height <= 0)
+    {
+        LOG_WARN("DeepZoomExporter::Start: Invalid image size {}x{}.", width, height);
+        return false;
+    }
+
+    const QFileInfo info(path);
+
+    mDescriptorPath = path;
+    mTileDirectory = QDir(info.absolutePath()).filePath(info.completeBaseName() + "_files");
+    mWidth = width;
+    mHeight = height;
+    mMaxLevel = int(std::ceil(std::log2(std::max(width, height))));
+
+    ReadManifest();
+
+    for (int level = 0; level <= mMaxLevel; ++level)
+    {
+        if (QDir().mkpath(QDir(mTileDirectory).filePath(QString::number(level))) == false)
+        {
+            LOG_WARN("DeepZoomExporter::Start: Could not create the tile directory '{}'.", mTileDirectory.toStdString());
+            return false;
+        }
+    }
+
+    if (WriteDescriptor() == false)
+        return false;
+
+    // Same view as the window, scaled to the output width
+    const float pixelSize = mCamera->GetWidth() * mCamera->GetZoom() / width;
+    mView = QRectF(mCamera->GetLeft(), mCamera->GetTop(), width * pixelSize, height * pixelSize);
+    mRenderModes = renderModes;
+
+    mTileRenderer.SetCurveContainer(mCurveContainer);
+    mTileRenderer.SetWindowSize(mWindowSize);
+    mTileRenderer.SetSmoothIterations(mSmoothIterations);
+    mTileRenderer.SetSolverType(mSolverType);
+    mTileRenderer.Begin(mView, renderModes);
+
+    PlanWindows();
+
+    mNextWindow = 0;
+    mReusedWindows = 0;
+    mCancelRequested = false;
+    mLastExportSucceeded = false;
+
+    // Only levels split into several windows take their borders from the coarse solve
+    const bool needsBoundary = renderModes.testAnyFlag(RenderMode::Diffusion) && mWindows.first().writesLowerLevels == false;
+    mState = needsBoundary ? State::CoarseSolve : State::Windows;
+
+    LOG_INFO("DeepZoomExporter::Start: Exporting {}x{} pixels in {} levels and {} windows to '{}'.", width, height, mMaxLevel + 1, mWindows.size(), path.toStdString());
+
+    return true;
+}
+
+bool DiffusionCurveRenderer::DeepZoomExporter::Step()
+{
+    if (mState == State::Idle)
+        return false;
+
+    if (mCancelRequested)
+    {
+        LOG_INFO("DeepZoomExporter::Step: Export cancelled.");
+        Finish(false);
+        return false;
+    }
+
+    MEASURE_CALL_TIME(DEEP_ZOOM_EXPORTER);
+
+    if (mState == State::CoarseSolve)
+    {
+        mTileRenderer.SolveCoarse();
+        mState = State::Windows;
+        return true;
+    }
+
+    // Reused windows cost a hash only, so keep going until one is rendered
+    while (mNextWindow < mWindows.size())
+    {
+        const Window& window = mWindows[mNextWindow++];
+        const QString key = GetWindowKey(window);
+        const QByteArray hash = HashWindow(window);
+
+        if (mHashes.value(key) == hash && TilesExist(window))
+        {
+            ++mReusedWindows;
+            continue;
+        }
+
+        // Tiles of a window that fails halfway must not be reused
+        mHashes.remove(key);
+
+        if (RenderWindow(window) == false)
+        {
+            Finish(false);
+            return false;
+        }
+
+        mHashes.insert(key, hash);
+        break;
+    }
+
+    if (mNextWindow == mWindows.size())
+    {
+        Finish(true);
+        return false;
+    }
+
+    return true;
+}
+
+void DiffusionCurveRenderer::DeepZoomExporter::Cancel()
+{
+    mCancelRequested = true;
+}
+
+float DiffusionCurveRenderer::DeepZoomExporter::GetProgress() const
+{
+    if (mState == State::Idle)
+        return mLastExportSucceeded ? 1.0f : 0.0f;
+
+    // The coarse solve costs about as much as one window
+    const int windows = mWindows.size();
+    const int done = mNextWindow + (mState == State::Windows ? 1 : 0);
+
+    return float(done) / float(windows + 1);
+}
+
+void DiffusionCurveRenderer::DeepZoomExporter::PlanWindows()
+{
+    mWindows.clear();
+
+    for (int level = mMaxLevel; level >= 0; --level)
+    {
+        const int width = GetLevelWidth(level);
+        const int height = GetLevelHeight(level);
+
+        if (width <= mWindowSize && height <= mWindowSize)
+        {
+            mWindows.push_back(Window{ level, 0, 0, width, height, 0, 0, true });
+            break;
+        }
+
+        const int columns = mTileRenderer.GetWindowCount(width, mWindowOverlap);
+        const int rows = mTileRenderer.GetWindowCount(height, mWindowOverlap);
+
+        for (int row = 0; row < rows; ++row)
+        {
+            for (int column = 0; column < columns; ++column)
+            {
+                Window window;
+                window.level = level;
+                window.writesLowerLevels = false;
+
+                mTileRenderer.GetWindowRange(column, width, mWindowOverlap, window.x0, window.x1, window.windowX);
+                mTileRenderer.GetWindowRange(row, height, mWindowOverlap, window.y0, window.y1, window.windowY);
+
+                mWindows.push_back(window);
+            }
+        }
+    }
+}
+
+bool DiffusionCurveRenderer::DeepZoomExporter::RenderWindow(const Window& window)
+{
+    const int width = GetLevelWidth(window.level);
+    const int height = GetLevelHeight(window.level);
+
+    const cv::Mat image = mTileRenderer.RenderWindow(width, height, window.windowX, window.windowY);
+
+    if (WriteTiles(image, window.level, window.x0, window.y0, window.x1, window.y1, window.windowX, window.windowY) == false)
+        return false;
+
+    if (window.writesLowerLevels == false)
+        return true;
+
+    // Each level is half of the one above, like the viewers expect
+    cv::Mat current = image(cv::Rect(0, 0, width, height));
+
+    for (int level = window.level - 1; level >= 0; --level)
+    {
+        cv::Mat next;
+        cv::resize(current, next, cv::Size(GetLevelWidth(level), GetLevelHeight(level)), 0, 0, cv::INTER_AREA);
+
+        if (WriteTiles(next, level, 0, 0, next.cols, next.rows, 0, 0) == false)
+            return false;
+
+        current = next;
+    }
+
+    return true;
+}
+
+QByteArray DiffusionCurveRenderer::DeepZoomExporter::HashWindow(const Window& window) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    const auto add = [&hash](const auto& value) { //
+        hash.addData(QByteArrayView(reinterpret_cast<const char*>(&value), sizeof(value)));
+    };
+
+    const int width = GetLevelWidth(window.level);
+    const int height = GetLevelHeight(window.level);
+
+    add(mWindowSize);
+    add(mWindowOverlap);
+    add(mSmoothIterations);
+    add(mSolverType);
+    add(int(mRenderModes.toInt()));
+    add(mWidth);
+    add(mHeight);
+    add(window.level);
+    add(window.windowX);
+    add(window.windowY);
+    add(window.writesLowerLevels);
+    add(mView.left());
+    add(mView.top());
+    add(mView.width());
+    add(mView.height());
+
+    const auto addBezier = [&add](const BezierPtr& bezier) {
+        for (const auto& point : bezier->GetColorPoints())
+        {
+            add(point->type);
+            add(point->position);
+            add(point->color);
+        }
+
+        // Blur points are left out, TileRenderer does not apply them
+    };
+
+    QVector<int> indices;
+    const QVector<CurvePtr> curves = mTileRenderer.GetCurvesInWindow(width, height, window.windowX, window.windowY, &indices);
+
+    // Curves far from the window only reach it through the coarse borders below.
+    // Later curves are drawn over earlier ones, so the index is part of the input.
+    for (int i = 0; i < curves.size(); ++i)
+    {
+        const CurvePtr& curve = curves[i];
+
+        add(indices[i]);
+        add(curve->GetContourColor());
+        add(curve->GetContourThickness());
+        add(curve->GetDiffusionWidth());
+        add(curve->GetDiffusionGap());
+
+        for (const auto& point : curve->GetControlPoints())
+            add(point->position);
+
+        if (SplinePtr spline = std::dynamic_pointer_cast<Spline>(curve))
+        {
+            for (const auto& patch : spline->GetBezierPatches())
+                addBezier(patch);
+        }
+        else if (BezierPtr bezier = std::dynamic_pointer_cast<Bezier>(curve))
+        {
+            addBezier(bezier);
+        }
+    }
+
+    const cv::Mat footprint = mTileRenderer.GetCoarseFootprint(width, height, window.windowX, window.windowY);
+
+    for (int row = 0; row < footprint.rows; ++row)
+        hash.addData(QByteArrayView(footprint.ptr<char>(row), footprint.cols * footprint.elemSize()));
+
+    return hash.result().toHex();
+}
+
+bool DiffusionCurveRenderer::DeepZoomExporter::TilesExist(const Window& window) const
+{
+    const auto exist = [this](int level, int x0, int y0, int x1, int y1) {
+        int firstColumn, lastColumn, firstRow, lastRow;
+        GetTileSpan(x0, x1, firstColumn, lastColumn);
+        GetTileSpan(y0, y1, firstRow, lastRow);
+
+        const QDir directory(QDir(mTileDirectory).filePath(QString::number(level)));
+
+        for (int row = firstRow; row <= lastRow; ++row)
+            for (int column = firstColumn; column <= lastColumn; ++column)
+                if (QFileInfo::exists(directory.filePath(QString("%1_%2.png").arg(column).arg(row))) == false)
+                    return false;
+
+        return true;
+    };
+
+    if (exist(window.level, window.x0, window.y0, window.x1, window.y1) == false)
+        return false;
+
+    if (window.writesLowerLevels)
+    {
+        for (int level = window.level - 1; level >= 0; --level)
+            if (exist(level, 0, 0, GetLevelWidth(level), GetLevelHeight(level)) == false)
+                return false;
+    }
+
+    return true;
+}
+
+bool DiffusionCurveRenderer::DeepZoomExporter::WriteTiles(const cv::Mat& image, int level, int x0, int y0, int x1, int y1, int originX, int originY) const
+{
+    const int width = GetLevelWidth(level);
+    const int height = GetLevelHeight(level);
+
+    int firstColumn, lastColumn, firstRow, lastRow;
+    GetTileSpan(x0, x1, firstColumn, lastColumn);
+    GetTileSpan(y0, y1, firstRow, lastRow);
+
+    const int columns = lastColumn - firstColumn + 1;
+    const int tiles = columns * (lastRow - firstRow + 1);
+
+    const QDir directory(QDir(mTileDirectory).filePath(QString::number(level)));
+
+    std::atomic_int failures{ 0 };
+
+    // PNG encoding dominates, tiles are independent
+    Parallel::For(tiles, 1, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i)
+        {
+            const int column = firstColumn + i % columns;
+            const int row = firstRow + i / columns;
+
+            // Tiles reach TILE_OVERLAP pixels into their neighbors
+            const int left = std::max(column * TILE_SIZE - TILE_OVERLAP, 0);
+            const int top = std::max(row * TILE_SIZE - TILE_OVERLAP, 0);
+            const int right = std::min((column + 1) * TILE_SIZE + TILE_OVERLAP, width);
+            const int bottom = std::min((row + 1) * TILE_SIZE + TILE_OVERLAP, height);
+
+            const uchar* data = image.ptr<uchar>(top - originY) + 4 * (left - originX);
+            const QImage tile(data, right - left, bottom - top, image.step, QImage::Format_RGBA8888);
+
+            if (tile.save(directory.filePath(QString("%1_%2.png").arg(column).arg(row)), "PNG") == false)
+                ++failures;
+        }
+    });
+
+    if (failures > 0)
+    {
+        LOG_WARN("DeepZoomExporter::WriteTiles: Could not write {} tiles of level {}.", failures.load(), level);
+        return false;
+    }
+
+    return true;
+}
+
+bool DiffusionCurveRenderer::DeepZoomExporter::WriteDescriptor() const
+{
+    QFile file(mDescriptorPath);
+
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate) == false)
+    {
+        LOG_WARN("DeepZoomExporter::WriteDescriptor: Could not open '{}' for writing.", mDescriptorPath.toStdString());
+        return false;
+    }
+
+    QXmlStreamWriter writer(&file);
+    writer.setAutoFormatting(true);
+    writer.writeStartDocument();
+    writer.writeStartElement("Image");
+    writer.writeDefaultNamespace("http://schemas.microsoft.com/deepzoom/2008");
+    writer.writeAttribute("TileSize", QString::number(TILE_SIZE));
+    writer.writeAttribute("Overlap", QString::number(TILE_OVERLAP));
+    writer.writeAttribute("Format", "png");
+    writer.writeStartElement("Size");
+    writer.writeAttribute("Width", QString::number(mWidth));
+    writer.writeAttribute("Height", QString::number(mHeight));
+    writer.writeEndElement();
+    writer.writeEndElement();
+    writer.writeEndDocument();
+
+    return writer.hasError() == false;
+}
+
+void DiffusionCurveRenderer::DeepZoomExporter::ReadManifest()
+{
+    mHashes.clear();
+
+    QFile file(QDir(mTileDirectory).filePath("manifest.json"));
+
+    if (file.open(QIODevice::ReadOnly) == false)
+        return;
+
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+
+    // Tiles of another size would be left over in the level directories
+    if (root.value("width").toInt() != mWidth || root.value("height").toInt() != mHeight || root.value("tile_size").toInt() != TILE_SIZE || root.value("overlap").toInt() != TILE_OVERLAP)
+    {
+        LOG_INFO("DeepZoomExporter::ReadManifest: Image size has changed, removing the tiles in '{}'.", mTileDirectory.toStdString());
+        file.close();
+        QDir(mTileDirectory).removeRecursively();
+        return;
+    }
+
+    const QJsonObject windows = root.value("windows").toObject();
+
+    for (auto it = windows.begin(); it != windows.end(); ++it)
+        mHashes.insert(it.key(), it.value().toString().toLatin1());
+}
+
+void DiffusionCurveRenderer::DeepZoomExporter::WriteManifest() const
+{
+    QJsonObject windows;
+
+    for (auto it = mHashes.begin(); it != mHashes.end(); ++it)
+        windows.insert(it.key(), QString::fromLatin1(it.value()));
+
+    QJsonObject root;
+    root.insert("width", mWidth);
+    root.insert("height", mHeight);
+    root.insert("tile_size", TILE_SIZE);
+    root.insert("overlap", TILE_OVERLAP);
+    root.insert("windows", windows);
+
+    QFile file(QDir(mTileDirectory).filePath("manifest.json"));
+
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate) == false)
+    {
+        LOG_WARN("DeepZoomExporter::WriteManifest: Could not write the manifest, the next export renders all windows.");
+        return;
+    }
+
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+}
+
+void DiffusionCurveRenderer::DeepZoomExporter::Finish(bool success)
+{
+    // Finished windows are valid after a cancel as well
+    WriteManifest();
+
+    mTileRenderer.End();
+    mWindows.clear();
+
+    mLastExportSucceeded = success;
+    mState = State::Idle;
+
+    if (success)
+        LOG_INFO("DeepZoomExporter::Finish: Export finished, {} unchanged windows were reused.", mReusedWindows);
+}
+
+int DiffusionCurveRenderer::DeepZoomExporter::GetLevelWidth(int level) const
+{
+    const int shift = mMaxLevel - level;
+    return int((qint64(mWidth) + (qint64(1) << shift) - 1) >> shift);
+}
+
+int DiffusionCurveRenderer::DeepZoomExporter::GetLevelHeight(int level) const
+{
+    const int shift = mMaxLevel - level;
+    return int((qint64(mHeight) + (qint64(1) << shift) - 1) >> shift);
+}
+
+QString DiffusionCurveRenderer::DeepZoomExporter::GetWindowKey(const Window& window) const
+{
+    return QString("%1/%2_%3").arg(window.level).arg(window.windowX).arg(window.windowY);
+}
+
+void DiffusionCurveRenderer::DeepZoomExporter::GetTileSpan(int begin, int end, int& first, int& last)
+{
+    first = begin / TILE_SIZE;
+    last = (end - 1) / TILE_SIZE;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Core/Constants.h"
+#include "Core/CurveContainer.h"
+#include "Core/OrthographicCamera.h"
+#include "Renderer/TiledExporter/TileRenderer.h"
+#include "Structs/Enums.h"
+#include "Util/Macros.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <atomic>
+#include <opencv2/core/mat.hpp>
+
+namespace DiffusionCurveRenderer
+{
+    // Exports the view of the camera as a Deep Zoom image for web viewers such as OpenSeadragon: a .dzi descriptor
+    // and 256 pixel PNG tiles with one pixel overlap in <name>_files/<level>/<column>_<row>.png.
+    // Levels larger than the window are rendered from the curves at their own resolution with TileRenderer, the
+    // largest level that fits in one window is rendered once and halved for the levels below it.
+    // The input hash of every window is kept in <name>_files/manifest.json. Exporting the same view again only
+    // renders the windows whose curves, coarse borders or settings have changed.
+    // Windows are solved one after the other: the CPU solver already splits each window into row bands over the whole
+    // thread pool, Parallel::For cannot be nested, and contours are read back from the single OpenGL context.
+    class DeepZoomExporter
+    {
+        DISABLE_COPY(DeepZoomExporter);
+
+      public:
+        DeepZoomExporter() = default;
+
+        // Optional, requires a current OpenGL context. Without it contours are not exported.
+        void Initialize();
+
+        // Exports the view of Camera at width x height pixels, path is the .dzi file
+        bool Start(const QString& path, int width, int height, RenderModes renderModes);
+
+        // Does the next unit of work, the coarse solve or one window. Returns true while the export is running.
+        bool Step();
+
+        // May be called from any thread, the next Step() stops the export and keeps the finished tiles
+        void Cancel();
+
+        bool IsRunning() const { return mState != State::Idle; }
+        float GetProgress() const; // [0,1]
+
+        DEFINE_MEMBER(int, WindowSize, 2048); // Power of two
+        DEFINE_MEMBER(int, WindowOverlap, 128);
+        DEFINE_MEMBER(int, SmoothIterations, DEFAULT_SMOOTH_ITERATIONS);
+        DEFINE_MEMBER(DiffusionSolverType, SolverType, DiffusionSolverType::Cpu);
+        DEFINE_MEMBER_CONST(bool, LastExportSucceeded, false);
+
+        DEFINE_MEMBER_PTR(OrthographicCamera, Camera);
+        DEFINE_MEMBER_PTR(CurveContainer, CurveContainer);
+
+      private:
+        enum class State
+        {
+            Idle,
+            CoarseSolve,
+            Windows
+        };
+
+        struct Window
+        {
+            int level;
+            int x0, y0, x1, y1;     // Level pixels whose tiles are written
+            int windowX, windowY;   // Top left corner of the rendered window
+            bool writesLowerLevels; // Lower levels are halved from this one
+        };
+
+        void PlanWindows();
+        bool RenderWindow(const Window& window);
+        QByteArray HashWindow(const Window& window) const;
+        bool TilesExist(const Window& window) const;
+        bool WriteTiles(const cv::Mat& image, int level, int x0, int y0, int x1, int y1, int originX, int originY) const;
+        bool WriteDescriptor() const;
+        void ReadManifest();
+        void WriteManifest() const;
+        void Finish(bool success);
+
+        int GetLevelWidth(int level) const;
+        int GetLevelHeight(int level) const;
+        QString GetWindowKey(const Window& window) const;
+
+        // Tiles [first, last] whose pixels without the overlap lie in [begin, end)
+        static void GetTileSpan(int begin, int end, int& first, int& last);
+
+        TileRenderer mTileRenderer;
+
+        QVector<Window> mWindows;
+        QHash<QString, QByteArray> mHashes; // Window key to input hash, loaded from and saved to the manifest
+
+        State mState{ State::Idle };
+        std::atomic_bool mCancelRequested{ false };
+
+        QString mDescriptorPath;
+        QString mTileDirectory;
+        QRectF mView;
+        RenderModes mRenderModes;
+        int mWidth{ 0 };
+        int mHeight{ 0 };
+        int mMaxLevel{ 0 };
+        int mNextWindow{ 0 };
+        int mReusedWindows{ 0 };
+
+        static constexpr int TILE_SIZE = 256;
+        static constexpr int TILE_OVERLAP = 1;
+    };
+}
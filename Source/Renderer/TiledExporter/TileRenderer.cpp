@@ -0,0 +1,345 @@
+#include "TileRenderer.h"
+
+#include "Curve/Spline.h"
+#include "Renderer/ContourRenderer/ContourRenderer.h"
+#include "Renderer/DiffusionRenderer/Solvers/CpuDiffusionSolver.h"
+#include "Renderer/DiffusionRenderer/Solvers/DiffusionSolverFactory.h"
+#include "Util/Logger.h"
+#include "Util/Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <opencv2/core.hpp>
+
+DiffusionCurveRenderer::TileRenderer::~TileRenderer()
+{
+    delete mSolver;
+}
+
+void DiffusionCurveRenderer::TileRenderer::Initialize()
+{
+    initializeOpenGLFunctions();
+
+    mContourRenderer = new ContourRenderer;
+    mContourRenderer->SetCamera(&mCamera);
+    mContourRenderer->SetCurveContainer(mCurveContainer);
+    mContourRenderer->Initialize();
+}
+
+void DiffusionCurveRenderer::TileRenderer::Begin(const QRectF& view, RenderModes renderModes)
+{
+    mView = view;
+    mRenderModes = renderModes;
+
+    if (mRenderModes.testAnyFlag(RenderMode::Contour) && mContourRenderer == nullptr)
+    {
+        LOG_WARN("TileRenderer::Begin: No OpenGL context was given, contours are not rendered.");
+        mRenderModes.setFlag(RenderMode::Contour, false);
+    }
+
+    if (mSolver == nullptr)
+    {
+        // Window borders are fixed with SetBoundary(), which only the CPU solvers provide
+        DiffusionSolver* solver = DiffusionSolverFactory::Create(mSolverType);
+        mSolver = dynamic_cast<CpuDiffusionSolver*>(solver);
+
+        if (mSolver == nullptr)
+        {
+            LOG_INFO("TileRenderer::Begin: {} solver cannot fix window borders, using the CPU solver.", DiffusionSolverFactory::GetName(mSolverType));
+            delete solver;
+            mSolver = dynamic_cast<CpuDiffusionSolver*>(DiffusionSolverFactory::Create(DiffusionSolverType::Cpu));
+        }
+    }
+
+    mSolver->SetCurveContainer(mCurveContainer);
+    mSolver->SetCamera(&mCamera);
+    mSolver->SetFramebufferSize(mWindowSize);
+    mSolver->SetSmoothIterations(mSmoothIterations);
+
+    mCurves.clear();
+    mCurveBounds.clear();
+
+    bool blurred = false;
+
+    const auto isBlurred = [](const BezierPtr& bezier) {
+        const auto& points = bezier->GetBlurPoints();
+        return std::any_of(points.begin(), points.end(), [](const BlurPointPtr& point) { return point->strength > 0.0f; });
+    };
+
+    for (const auto& curve : mCurveContainer->GetCurves())
+    {
+        if (const auto bezier = std::dynamic_pointer_cast<Bezier>(curve))
+            blurred = blurred || isBlurred(bezier);
+        else if (const auto spline = std::dynamic_pointer_cast<Spline>(curve))
+            blurred = blurred || std::any_of(spline->GetBezierPatches().begin(), spline->GetBezierPatches().end(), isBlurred);
+
+        float minX = std::numeric_limits<float>::max();
+        float minY = std::numeric_limits<float>::max();
+        float maxX = std::numeric_limits<float>::lowest();
+        float maxY = std::numeric_limits<float>::lowest();
+
+        // Curves lie in the convex hull of their control points
+        for (const auto& point : curve->GetControlPoints())
+        {
+            minX = std::min(minX, point->position.x());
+            minY = std::min(minY, point->position.y());
+            maxX = std::max(maxX, point->position.x());
+            maxY = std::max(maxY, point->position.y());
+        }
+
+        const float margin = 0.5f * curve->GetDiffusionGap() + curve->GetDiffusionWidth() + curve->GetContourThickness();
+
+        mCurves.push_back(curve);
+        mCurveBounds.push_back(QRectF(minX, minY, maxX - minX, maxY - minY).adjusted(-margin, -margin, margin, margin));
+    }
+
+    if (blurred && mRenderModes.testAnyFlag(RenderMode::Diffusion))
+        LOG_WARN("TileRenderer::Begin: Blur points are not supported by tiled rendering, the export is not blurred.");
+
+    mCoarse.release();
+}
+
+void DiffusionCurveRenderer::TileRenderer::SolveCoarse()
+{
+    // The square framebuffer is stretched over the whole view like in the window
+    mCamera.Resize(mWindowSize, std::max(1, qRound(mWindowSize * mView.height() / mView.width())), 1.0f);
+    mCamera.SetZoom(mView.width() / mWindowSize);
+    mCamera.SetLeft(mView.left());
+    mCamera.SetTop(mView.top());
+
+    mSolver->SetBoundary(cv::Mat());
+    mSolver->Solve();
+
+    mCoarse = mSolver->GetResultImage();
+}
+
+cv::Mat DiffusionCurveRenderer::TileRenderer::RenderWindow(int width, int height, int x, int y)
+{
+    const QRectF rect = GetWindowRect(width, height, x, y);
+
+    // One framebuffer pixel per output pixel
+    mCamera.Resize(mWindowSize, mWindowSize, 1.0f);
+    mCamera.SetZoom(rect.width() / mWindowSize);
+    mCamera.SetLeft(rect.left());
+    mCamera.SetTop(rect.top());
+
+    // Save() starts from a white framebuffer as well
+    cv::Mat window(mWindowSize, mWindowSize, CV_8UC4, cv::Scalar::all(255));
+
+    const bool empty = IsWindowEmpty(width, height, x, y);
+
+    if (mRenderModes.testAnyFlag(RenderMode::Diffusion))
+    {
+        if (empty && HasCoarseSolve())
+        {
+            // Far from the curves the solution has no detail the coarse solve misses
+            InterpolateCoarse(width, height, x, y, window);
+        }
+        else
+        {
+            if (HasCoarseSolve())
+                BuildBoundary(width, height, x, y);
+
+            mSolver->SetBoundary(HasCoarseSolve() ? mBoundary : cv::Mat());
+            mSolver->Solve();
+
+            // Rounds like the conversion to the 8-bit framebuffer
+            mSolver->GetResultImage().convertTo(window, CV_8UC4, 255.0);
+        }
+    }
+
+    if (mRenderModes.testAnyFlag(RenderMode::Contour) && empty == false)
+        RenderContours(window);
+
+    return window;
+}
+
+bool DiffusionCurveRenderer::TileRenderer::IsWindowEmpty(int width, int height, int x, int y) const
+{
+    const QRectF rect = GetWindowRect(width, height, x, y);
+
+    return std::none_of(mCurveBounds.begin(), mCurveBounds.end(), [&rect](const QRectF& bounds) { return bounds.intersects(rect); });
+}
+
+QVector<DiffusionCurveRenderer::CurvePtr> DiffusionCurveRenderer::TileRenderer::GetCurvesInWindow(int width, int height, int x, int y, QVector<int>* indices) const
+{
+    const QRectF rect = GetWindowRect(width, height, x, y);
+
+    QVector<CurvePtr> curves;
+
+    if (indices)
+        indices->clear();
+
+    for (int i = 0; i < mCurves.size(); ++i)
+    {
+        if (mCurveBounds[i].intersects(rect))
+        {
+            curves.push_back(mCurves[i]);
+
+            if (indices)
+                indices->push_back(i);
+        }
+    }
+
+    return curves;
+}
+
+QRectF DiffusionCurveRenderer::TileRenderer::GetWindowRect(int width, int height, int x, int y) const
+{
+    const qreal pixelSize = mView.width() / width;
+
+    return QRectF(mView.left() + x * pixelSize, mView.top() + y * pixelSize, mWindowSize * pixelSize, mWindowSize * pixelSize);
+}
+
+cv::Mat DiffusionCurveRenderer::TileRenderer::GetCoarseFootprint(int width, int height, int x, int y) const
+{
+    if (HasCoarseSolve() == false)
+        return cv::Mat();
+
+    // Bilinear lookups reach one texel beyond the window
+    const int left = std::clamp(int(std::floor(double(x) * mCoarse.cols / width)) - 1, 0, mCoarse.cols - 1);
+    const int top = std::clamp(int(std::floor(double(y) * mCoarse.rows / height)) - 1, 0, mCoarse.rows - 1);
+    const int right = std::clamp(int(std::ceil(double(x + mWindowSize) * mCoarse.cols / width)) + 1, left + 1, mCoarse.cols);
+    const int bottom = std::clamp(int(std::ceil(double(y + mWindowSize) * mCoarse.rows / height)) + 1, top + 1, mCoarse.rows);
+
+    cv::Mat footprint;
+    mCoarse(cv::Rect(left, top, right - left, bottom - top)).convertTo(footprint, CV_8UC4, 255.0);
+
+    return footprint;
+}
+
+int DiffusionCurveRenderer::TileRenderer::GetWindowCount(int size, int overlap) const
+{
+    const int core = mWindowSize - 2 * overlap;
+
+    return size <= mWindowSize ? 1 : (size + core - 1) / core;
+}
+
+void DiffusionCurveRenderer::TileRenderer::GetWindowRange(int index, int size, int overlap, int& begin, int& end, int& window) const
+{
+    // A single window covers the whole axis and has no inner borders
+    if (size <= mWindowSize)
+    {
+        begin = 0;
+        end = size;
+        window = 0;
+        return;
+    }
+
+    const int core = mWindowSize - 2 * overlap;
+
+    begin = index * core;
+    end = std::min(begin + core, size);
+    window = std::clamp(begin - overlap, 0, size - mWindowSize);
+}
+
+void DiffusionCurveRenderer::TileRenderer::End()
+{
+    delete mSolver;
+    mSolver = nullptr;
+
+    mCoarse.release();
+    mBoundary.release();
+    mContourFramebuffer.reset();
+    mCurves.clear();
+    mCurveBounds.clear();
+}
+
+void DiffusionCurveRenderer::TileRenderer::RenderContours(cv::Mat& window)
+{
+    if (mContourFramebuffer == nullptr || mContourFramebuffer->width() != mWindowSize)
+        mContourFramebuffer = std::make_unique<QOpenGLFramebufferObject>(mWindowSize, mWindowSize);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mContourFramebuffer->handle());
+    glViewport(0, 0, mWindowSize, mWindowSize);
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    mContourRenderer->Render(mContourFramebuffer.get());
+
+    cv::Mat contours(mWindowSize, mWindowSize, CV_8UC4);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mContourFramebuffer->handle());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, mWindowSize, mWindowSize, GL_RGBA, GL_UNSIGNED_BYTE, contours.ptr());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // Contours are drawn without blending, so covered pixels replace the diffusion
+    cv::flip(contours, contours, 0);
+
+    cv::Mat alpha;
+    cv::extractChannel(contours, alpha, 3);
+    contours.copyTo(window, alpha > 0);
+}
+
+void DiffusionCurveRenderer::TileRenderer::BuildBoundary(int width, int height, int x, int y)
+{
+    mBoundary.create(mWindowSize, mWindowSize, CV_32FC4);
+    mBoundary.setTo(cv::Scalar::all(0));
+
+    const int last = mWindowSize - 1;
+
+    // Only borders inside the image are fixed, borders on the image edge stay clamped like the full view
+    const bool left = x > 0;
+    const bool right = x + mWindowSize < width;
+    const bool top = y > 0;
+    const bool bottom = y + mWindowSize < height;
+
+    const auto sample = [&](int px, int py) { //
+        return SampleCoarse((px + 0.5f) / width, (py + 0.5f) / height);
+    };
+
+    for (int i = 0; i < mWindowSize; ++i)
+    {
+        if (left)
+            mBoundary.at<cv::Vec4f>(i, 0) = sample(x, y + i);
+
+        if (right)
+            mBoundary.at<cv::Vec4f>(i, last) = sample(x + last, y + i);
+
+        if (top)
+            mBoundary.at<cv::Vec4f>(0, i) = sample(x + i, y);
+
+        if (bottom)
+            mBoundary.at<cv::Vec4f>(last, i) = sample(x + i, y + last);
+    }
+}
+
+void DiffusionCurveRenderer::TileRenderer::InterpolateCoarse(int width, int height, int x, int y, cv::Mat& window) const
+{
+    Parallel::For(mWindowSize, 64, [&](int begin, int end) {
+        for (int j = begin; j < end; ++j)
+        {
+            cv::Vec4b* row = window.ptr<cv::Vec4b>(j);
+
+            for (int i = 0; i < mWindowSize; ++i)
+            {
+                const cv::Vec4f color = SampleCoarse((x + i + 0.5f) / width, (y + j + 0.5f) / height);
+
+                for (int k = 0; k < 4; ++k)
+                    row[i][k] = cv::saturate_cast<uchar>(255.0f * color[k]);
+            }
+        }
+    });
+}
+
+cv::Vec4f DiffusionCurveRenderer::TileRenderer::SampleCoarse(float u, float v) const
+{
+    // Bilinear lookup at normalized view coordinates
+    const float s = std::clamp(u * mCoarse.cols - 0.5f, 0.0f, mCoarse.cols - 1.0f);
+    const float t = std::clamp(v * mCoarse.rows - 0.5f, 0.0f, mCoarse.rows - 1.0f);
+
+    const int s0 = int(s);
+    const int t0 = int(t);
+    const int s1 = std::min(s0 + 1, mCoarse.cols - 1);
+    const int t1 = std::min(t0 + 1, mCoarse.rows - 1);
+
+    const float fs = s - s0;
+    const float ft = t - t0;
+
+    const cv::Vec4f top = (1 - fs) * mCoarse.at<cv::Vec4f>(t0, s0) + fs * mCoarse.at<cv::Vec4f>(t0, s1);
+    const cv::Vec4f bottom = (1 - fs) * mCoarse.at<cv::Vec4f>(t1, s0) + fs * mCoarse.at<cv::Vec4f>(t1, s1);
+
+    return (1 - ft) * top + ft * bottom;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Core/Constants.h"
+#include "Core/CurveContainer.h"
+#include "Core/OrthographicCamera.h"
+#include "Structs/Enums.h"
+#include "Util/Macros.h"
+
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+#include <QRectF>
+#include <memory>
+#include <opencv2/core/mat.hpp>
+
+namespace DiffusionCurveRenderer
+{
+    class ContourRenderer;
+    class CpuDiffusionSolver;
+
+    // Renders square windows of a view at resolutions far beyond the diffusion framebuffer, shared by the exporters.
+    // A coarse solve of the whole view provides the values at the window borders, then every window is solved at
+    // full resolution with those borders fixed. Callers overlap the windows so the error of the coarse borders fades
+    // out before the part they keep. Windows without curves nearby are interpolated from the coarse solve.
+    // Diffusion runs on the CPU solvers, contours need the OpenGL context given to Initialize().
+    // Blur points are not applied: the blur pass diffuses its own map and reads a pyramid of the whole framebuffer,
+    // neither of which can be split into windows with fixed borders yet. Exports are the unblurred image.
+    class TileRenderer : protected QOpenGLExtraFunctions
+    {
+        DISABLE_COPY(TileRenderer);
+
+      public:
+        TileRenderer() = default;
+        ~TileRenderer();
+
+        // Optional, requires a current OpenGL context. Without it contours are not rendered.
+        void Initialize();
+        bool CanRenderContours() const { return mContourRenderer != nullptr; }
+
+        // Starts rendering of view, a rectangle in world units. Takes a snapshot of the curve bounds.
+        void Begin(const QRectF& view, RenderModes renderModes);
+
+        // Solves the whole view at WindowSize, later windows take their borders from it
+        void SolveCoarse();
+        bool HasCoarseSolve() const { return mCoarse.empty() == false; }
+
+        // Top-down CV_8UC4 window of WindowSize pixels with its top left corner at pixel (x, y),
+        // for the view rendered at width x height pixels
+        cv::Mat RenderWindow(int width, int height, int x, int y);
+
+        // True if no curve is close enough to change the pixels of the window
+        bool IsWindowEmpty(int width, int height, int x, int y) const;
+
+        // Curves close enough to change the pixels of the window in draw order, indices are their positions in the container
+        QVector<CurvePtr> GetCurvesInWindow(int width, int height, int x, int y, QVector<int>* indices = nullptr) const;
+
+        // World rectangle of the window, same arguments as RenderWindow()
+        QRectF GetWindowRect(int width, int height, int x, int y) const;
+
+        // Coarse solve values the window depends on, quantized to 8 bits so they can be hashed
+        cv::Mat GetCoarseFootprint(int width, int height, int x, int y) const;
+
+        // Number of windows along an axis of size pixels, neighboring windows share 2 * overlap pixels
+        int GetWindowCount(int size, int overlap) const;
+
+        // Pixels [begin, end) kept from window index along an axis and the window start that covers them
+        void GetWindowRange(int index, int size, int overlap, int& begin, int& end, int& window) const;
+
+        // Releases the solver and the images, they are large at print resolutions
+        void End();
+
+        DEFINE_MEMBER(int, WindowSize, 2048); // Power of two
+        DEFINE_MEMBER(int, SmoothIterations, DEFAULT_SMOOTH_ITERATIONS);
+        DEFINE_MEMBER(DiffusionSolverType, SolverType, DiffusionSolverType::Cpu);
+
+        DEFINE_MEMBER_PTR(CurveContainer, CurveContainer);
+
+      private:
+        void RenderContours(cv::Mat& window);
+        void BuildBoundary(int width, int height, int x, int y);
+        void InterpolateCoarse(int width, int height, int x, int y, cv::Mat& window) const;
+        cv::Vec4f SampleCoarse(float u, float v) const;
+
+        CpuDiffusionSolver* mSolver{ nullptr };
+        ContourRenderer* mContourRenderer{ nullptr };
+        std::unique_ptr<QOpenGLFramebufferObject> mContourFramebuffer;
+
+        OrthographicCamera mCamera;
+
+        QRectF mView;
+        RenderModes mRenderModes;
+        QVector<CurvePtr> mCurves;
+        QVector<QRectF> mCurveBounds; // Including strips and contours
+
+        cv::Mat mCoarse;   // Top-down CV_32FC4 solve of the whole view
+        cv::Mat mBoundary; // Top-down CV_32FC4 fixed window borders
+    };
+}
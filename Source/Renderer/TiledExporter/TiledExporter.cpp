@@ -0,0 +1,179 @@
+#include "TiledExporter.h"
+
+#include "Util/Chronometer.h"
+#include "Util/Logger.h"
+
+#include <algorithm>
+#include <opencv2/core.hpp>
+
+void DiffusionCurveRenderer::TiledExporter::Initialize()
+{
+    mTileRenderer.SetCurveContainer(mCurveContainer);
+    mTileRenderer.Initialize();
+}
+
+bool DiffusionCurveRenderer::TiledExporter::Start(const QString& path, int width, int height, RenderModes renderModes)
+{
+    if (IsRunning())
+    {
+        LOG_WARN("TiledExporter::Start: An export is already running.");
+        return false;
+    }
+
+    const int core = mTileSize - 2 * mTileOverlap;
+
+    if (mTileSize < 64 || (mTileSize & (mTileSize - 1)) != 0 || mTileOverlap < 0 || core < mTileSize / 2)
+    {
+        LOG_WARN("TiledExporter::Start: Tile size must be a power of two of at least 64 and the overlap at most a quarter of it.");
+        return false;
+    }
+
+    if (mWriter.Open(path, width, height) == false)
+        return false;
+
+    // Same view as the window, scaled to the output width
+    const float pixelSize = mCamera->GetWidth() * mCamera->GetZoom() / width;
+    const QRectF view(mCamera->GetLeft(), mCamera->GetTop(), width * pixelSize, height * pixelSize);
+
+    mTileRenderer.SetCurveContainer(mCurveContainer);
+    mTileRenderer.SetWindowSize(mTileSize);
+    mTileRenderer.SetSmoothIterations(mSmoothIterations);
+    mTileRenderer.SetSolverType(mSolverType);
+    mTileRenderer.Begin(view, renderModes);
+
+    mWidth = width;
+    mHeight = height;
+    mColumns = mTileRenderer.GetWindowCount(width, mTileOverlap);
+    mRows = mTileRenderer.GetWindowCount(height, mTileOverlap);
+    mNextTile = 0;
+
+    if (mWriter.SupportsRegions() == false)
+    {
+        mStrip.create(mRows == 1 ? height : core, width, CV_8UC4);
+        mStrip.setTo(cv::Scalar::all(255));
+    }
+
+    mCancelRequested = false;
+    mLastExportSucceeded = false;
+
+    // A single tile covers the whole image and has no inner borders
+    const bool needsBoundary = renderModes.testAnyFlag(RenderMode::Diffusion) && mColumns * mRows > 1;
+    mState = needsBoundary ? State::CoarseSolve : State::Tiles;
+
+    LOG_INFO("TiledExporter::Start: Exporting {}x{} pixels in {}x{} tiles to '{}'.", width, height, mColumns, mRows, path.toStdString());
+
+    return true;
+}
+
+bool DiffusionCurveRenderer::TiledExporter::Step()
+{
+    if (mState == State::Idle)
+        return false;
+
+    if (mCancelRequested)
+    {
+        LOG_INFO("TiledExporter::Step: Export cancelled.");
+        Finish(false);
+        return false;
+    }
+
+    MEASURE_CALL_TIME(TILED_EXPORTER);
+
+    if (mState == State::CoarseSolve)
+    {
+        mTileRenderer.SolveCoarse();
+        mState = State::Tiles;
+        return true;
+    }
+
+    const int column = mNextTile % mColumns;
+    const int row = mNextTile / mColumns;
+
+    if (RenderTile(column, row) == false)
+    {
+        Finish(false);
+        return false;
+    }
+
+    ++mNextTile;
+
+    if (mStrip.empty() == false && column == mColumns - 1)
+    {
+        int begin, end, window;
+        mTileRenderer.GetWindowRange(row, mHeight, mTileOverlap, begin, end, window);
+
+        if (mWriter.WriteRows(mStrip.ptr(), end - begin, mStrip.step) == false)
+        {
+            Finish(false);
+            return false;
+        }
+
+        mStrip.setTo(cv::Scalar::all(255));
+    }
+
+    if (mNextTile == mColumns * mRows)
+    {
+        Finish(mWriter.Close());
+        return false;
+    }
+
+    return true;
+}
+
+void DiffusionCurveRenderer::TiledExporter::Cancel()
+{
+    mCancelRequested = true;
+}
+
+float DiffusionCurveRenderer::TiledExporter::GetProgress() const
+{
+    if (mState == State::Idle)
+        return mLastExportSucceeded ? 1.0f : 0.0f;
+
+    // The coarse solve costs about as much as one tile
+    const int tiles = mColumns * mRows;
+    const int done = mNextTile + (mState == State::Tiles && tiles > 1 ? 1 : 0);
+
+    return float(done) / float(tiles + (tiles > 1 ? 1 : 0));
+}
+
+bool DiffusionCurveRenderer::TiledExporter::RenderTile(int column, int row)
+{
+    int x0, x1, windowX;
+    int y0, y1, windowY;
+
+    mTileRenderer.GetWindowRange(column, mWidth, mTileOverlap, x0, x1, windowX);
+    mTileRenderer.GetWindowRange(row, mHeight, mTileOverlap, y0, y1, windowY);
+
+    const cv::Mat tile = mTileRenderer.RenderWindow(mWidth, mHeight, windowX, windowY);
+
+    const cv::Rect source(x0 - windowX, y0 - windowY, x1 - x0, y1 - y0);
+
+    if (mStrip.empty())
+    {
+        const cv::Mat core = tile(source);
+        return mWriter.WriteRegion(x0, y0, source.width, source.height, core.ptr(), core.step);
+    }
+
+    const cv::Rect target(x0, 0, x1 - x0, y1 - y0);
+
+    tile(source).copyTo(mStrip(target));
+
+    return true;
+}
+
+void DiffusionCurveRenderer::TiledExporter::Finish(bool success)
+{
+    if (success == false)
+        mWriter.Abort();
+
+    // Release the pyramid and the strip, they are large at print resolutions
+    mTileRenderer.End();
+    mStrip.release();
+
+    mLastExportSucceeded = success;
+    mState = State::Idle;
+
+    if (success)
+        LOG_INFO("TiledExporter::Finish: Export finished.");
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Core/Constants.h"
+#include "Core/CurveContainer.h"
+#include "Core/OrthographicCamera.h"
+#include "Renderer/TiledExporter/TileRenderer.h"
+#include "Structs/Enums.h"
+#include "Util/Macros.h"
+#include "Util/StreamingImageWriter.h"
+
+#include <atomic>
+#include <opencv2/core/mat.hpp>
+
+namespace DiffusionCurveRenderer
+{
+    // Exports the view of the camera at resolutions far beyond the diffusion framebuffer, e.g. 32k x 32k prints.
+    // Tiles are rendered by TileRenderer and overlap so the error of the coarse borders fades out before the kept
+    // center. TIFF tiles are written to their place in the file as soon as they are rendered, so memory depends
+    // on the tile size only. PNG needs whole rows and buffers one row of tiles, it grows with the output width.
+    class TiledExporter
+    {
+        DISABLE_COPY(TiledExporter);
+
+      public:
+        TiledExporter() = default;
+
+        // Optional, requires a current OpenGL context. Without it contours are not exported.
+        void Initialize();
+
+        // Exports the view of Camera at width x height pixels to a .tif or .png file
+        bool Start(const QString& path, int width, int height, RenderModes renderModes);
+
+        // Does the next unit of work, the coarse solve or one tile. Returns true while the export is running.
+        bool Step();
+
+        // May be called from any thread, the next Step() stops the export and removes the partial file
+        void Cancel();
+
+        bool IsRunning() const { return mState != State::Idle; }
+        float GetProgress() const; // [0,1]
+
+        DEFINE_MEMBER(int, TileSize, 2048); // Power of two
+        DEFINE_MEMBER(int, TileOverlap, 128);
+        DEFINE_MEMBER(int, SmoothIterations, DEFAULT_SMOOTH_ITERATIONS);
+        DEFINE_MEMBER(DiffusionSolverType, SolverType, DiffusionSolverType::Cpu);
+        DEFINE_MEMBER_CONST(bool, LastExportSucceeded, false);
+
+        DEFINE_MEMBER_PTR(OrthographicCamera, Camera);
+        DEFINE_MEMBER_PTR(CurveContainer, CurveContainer);
+
+      private:
+        enum class State
+        {
+            Idle,
+            CoarseSolve,
+            Tiles
+        };
+
+        bool RenderTile(int column, int row);
+        void Finish(bool success);
+
+        TileRenderer mTileRenderer;
+        StreamingImageWriter mWriter;
+
+        cv::Mat mStrip; // CV_8UC4 row of finished tiles, only for writers without regions
+
+        State mState{ State::Idle };
+        std::atomic_bool mCancelRequested{ false };
+
+        int mWidth{ 0 };
+        int mHeight{ 0 };
+        int mColumns{ 0 };
+        int mRows{ 0 };
+        int mNextTile{ 0 };
+    };
+}
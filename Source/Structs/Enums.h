@@ -36,6 +36,13 @@ namespace DiffusionCurveRenderer
         Diffusion = 0x02
     };
 
+    enum class DiffusionSolverType
+    {
+        Gpu = 0,
+        Cpu = 1,
+        Pcg = 2
+    };
+
     enum class ColorPointType
     {
         Left,
@@ -48,6 +55,12 @@ namespace DiffusionCurveRenderer
         Spline = 0x01
     };
 
+    enum class EdgeTracerType
+    {
+        Sequential = 0x00,
+        Components = 0x01
+    };
+
     // UI Theme options
     enum class UITheme
     {
@@ -1,45 +1,348 @@
 #include "Chronometer.h"
 
 #include "Logger.h"
+#include "Tracer.h"
 
-#include <format>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace DiffusionCurveRenderer
+{
+    namespace
+    {
+        constexpr ScopeId MAX_NUMBER_OF_SCOPES = 1024;
+
+        // Log-linear histogram of microseconds: values below 16 get their own bin, every power of two
+        // above is split into 8 linear sub-bins. Relative error of a percentile is at most 12.5%.
+        constexpr int NUMBER_OF_LINEAR_BINS = 16;
+        constexpr int NUMBER_OF_SUB_BINS = 8;
+        constexpr int NUMBER_OF_SUB_BIN_BITS = 3;
+        constexpr int MAX_EXPONENT = 40;
+        constexpr int NUMBER_OF_BINS = NUMBER_OF_LINEAR_BINS + (MAX_EXPONENT - 4 + 1) * NUMBER_OF_SUB_BINS;
+
+        int GetBinIndex(uint64_t value)
+        {
+            if (value < NUMBER_OF_LINEAR_BINS)
+            {
+                return static_cast<int>(value);
+            }
+
+            const int exponent = std::min(static_cast<int>(std::bit_width(value)) - 1, MAX_EXPONENT);
+            const int subBin = static_cast<int>((value >> (exponent - NUMBER_OF_SUB_BIN_BITS)) & (NUMBER_OF_SUB_BINS - 1));
+
+            return NUMBER_OF_LINEAR_BINS + (exponent - 4) * NUMBER_OF_SUB_BINS + subBin;
+        }
+
+        uint64_t GetBinValue(int index)
+        {
+            if (index < NUMBER_OF_LINEAR_BINS)
+            {
+                return index;
+            }
+
+            const int exponent = 4 + (index - NUMBER_OF_LINEAR_BINS) / NUMBER_OF_SUB_BINS;
+            const uint64_t subBin = (index - NUMBER_OF_LINEAR_BINS) % NUMBER_OF_SUB_BINS;
+            const uint64_t lower = (NUMBER_OF_SUB_BINS + subBin) << (exponent - NUMBER_OF_SUB_BIN_BITS);
+            const uint64_t width = 1ull << (exponent - NUMBER_OF_SUB_BIN_BITS);
+
+            return lower + width / 2;
+        }
+
+        // Written only by the owning thread, read by the querying thread
+        struct ScopeRecord
+        {
+            std::atomic<uint64_t> numberOfCalls{ 0 };
+            std::atomic<uint64_t> totalCallTime{ 0 };
+            std::atomic<uint64_t> lastCallTime{ 0 };
+            std::atomic<uint64_t> lastCallTimestamp{ 0 };
+            std::atomic<uint64_t> longestCallTime{ 0 };
+            std::array<std::atomic<uint64_t>, NUMBER_OF_BINS> bins{};
+        };
+
+        struct ThreadBuckets
+        {
+            ~ThreadBuckets()
+            {
+                for (auto& record : records)
+                    delete record.load();
+            }
+
+            std::array<std::atomic<ScopeRecord*>, MAX_NUMBER_OF_SCOPES> records{};
+        };
+
+        struct QueryState
+        {
+            uint64_t numberOfQueries{ 0 };
+            uint64_t numberOfCallsAtLastQuery{ 0 };
+        };
+
+        struct Registry
+        {
+            std::mutex mutex;
+            std::deque<std::string> names;
+            std::unordered_map<std::string, ScopeId> ids;
+
+            // Buckets of the running threads, and the merged buckets of the threads that exited.
+            // Pool threads expire and are recreated, so exited threads must not stay registered.
+            std::vector<ThreadBuckets*> threads;
+            ThreadBuckets retired;
+
+            std::array<QueryState, MAX_NUMBER_OF_SCOPES> queryStates{};
+        };
+
+        Registry& GetRegistry()
+        {
+            // Never destroyed, threads may exit after static destruction has begun
+            static Registry* REGISTRY = new Registry;
+            return *REGISTRY;
+        }
+
+        void Merge(ScopeRecord& target, const ScopeRecord& source)
+        {
+            const auto add = [](std::atomic<uint64_t>& value, const std::atomic<uint64_t>& amount)
+            { value.store(value.load(std::memory_order_relaxed) + amount.load(std::memory_order_relaxed), std::memory_order_relaxed); };
+
+            add(target.numberOfCalls, source.numberOfCalls);
+            add(target.totalCallTime, source.totalCallTime);
+
+            for (int i = 0; i < NUMBER_OF_BINS; ++i)
+                add(target.bins[i], source.bins[i]);
+
+            if (target.lastCallTimestamp.load(std::memory_order_relaxed) <= source.lastCallTimestamp.load(std::memory_order_relaxed))
+            {
+                target.lastCallTimestamp.store(source.lastCallTimestamp.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                target.lastCallTime.store(source.lastCallTime.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+
+            target.longestCallTime.store(std::max(target.longestCallTime.load(std::memory_order_relaxed), source.longestCallTime.load(std::memory_order_relaxed)),
+                                         std::memory_order_relaxed);
+        }
+
+        // Registers the buckets of a thread on first use, folds them into the retired buckets when the thread exits
+        struct ThreadBucketsOwner
+        {
+            ThreadBucketsOwner()
+                : buckets(new ThreadBuckets)
+            {
+                auto& registry = GetRegistry();
+                std::scoped_lock lock(registry.mutex);
+                registry.threads.push_back(buckets);
+            }
+
+            ~ThreadBucketsOwner()
+            {
+                auto& registry = GetRegistry();
+                std::scoped_lock lock(registry.mutex);
+
+                for (ScopeId id = 0; id < MAX_NUMBER_OF_SCOPES; ++id)
+                {
+                    const ScopeRecord* record = buckets->records[id].load(std::memory_order_relaxed);
+
+                    if (record == nullptr)
+                        continue;
+
+                    ScopeRecord* retired = registry.retired.records[id].load(std::memory_order_relaxed);
+
+                    if (retired == nullptr)
+                    {
+                        retired = new ScopeRecord;
+                        registry.retired.records[id].store(retired, std::memory_order_release);
+                    }
+
+                    Merge(*retired, *record);
+                }
+
+                std::erase(registry.threads, buckets);
+                delete buckets;
+            }
+
+            ThreadBuckets* buckets;
+        };
+
+        ThreadBuckets& GetThreadBuckets()
+        {
+            thread_local ThreadBucketsOwner OWNER;
+            return *OWNER.buckets;
+        }
+
+        void Increment(std::atomic<uint64_t>& value, uint64_t amount)
+        {
+            // Single writer, a plain load/store pair is enough and cheaper than a locked add
+            value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+    }
+}
+
+DiffusionCurveRenderer::Chronometer::Chronometer(ScopeId id)
+    : mId(id)
+{
+}
 
 DiffusionCurveRenderer::Chronometer::Chronometer(const std::string& name)
-    : mName(name)
+    : mId(Intern(name))
 {
 }
 
 DiffusionCurveRenderer::Chronometer::~Chronometer()
 {
-    std::scoped_lock lock(MUTEX);
+    const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - mStartTime);
+
+    Record(mId, duration);
+    Tracer::AddScope(mId, mStartTime, duration);
+}
+
+DiffusionCurveRenderer::ScopeId DiffusionCurveRenderer::Chronometer::Intern(const std::string& name)
+{
+    auto& registry = GetRegistry();
+    std::scoped_lock lock(registry.mutex);
+
+    if (const auto it = registry.ids.find(name); it != registry.ids.end())
+    {
+        return it->second;
+    }
+
+    if (registry.names.size() == MAX_NUMBER_OF_SCOPES)
+    {
+        LOG_WARN("Chronometer::Intern: '{}' could not be interned because the total number of scopes is {}.", name, MAX_NUMBER_OF_SCOPES);
+        return INVALID_SCOPE_ID;
+    }
+
+    const auto id = static_cast<ScopeId>(registry.names.size());
+    registry.names.push_back(name);
+    registry.ids.emplace(name, id);
+
+    return id;
+}
+
+std::string DiffusionCurveRenderer::Chronometer::GetName(ScopeId id)
+{
+    auto& registry = GetRegistry();
+    std::scoped_lock lock(registry.mutex);
 
-    // Update
-    auto& stats = STATS_OF_INSTANCES[mName];
-    const auto now = std::chrono::system_clock::now();
-    const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(now - mStartTime);
+    return id < registry.names.size() ? registry.names[id] : std::string();
+}
 
-    stats.callTime = duration;
-    stats.lastCallTime = duration;
-    stats.totalCallTime += duration;
-    stats.numberOfCalls += 1;
+void DiffusionCurveRenderer::Chronometer::Record(ScopeId id, std::chrono::microseconds duration)
+{
+    if (id >= MAX_NUMBER_OF_SCOPES)
+    {
+        return;
+    }
 
-    if (stats.longestCallTime < duration)
+    auto& slot = GetThreadBuckets().records[id];
+    ScopeRecord* record = slot.load(std::memory_order_relaxed);
+
+    if (record == nullptr)
+    {
+        record = new ScopeRecord;
+        slot.store(record, std::memory_order_release);
+    }
+
+    const uint64_t microseconds = std::max<int64_t>(duration.count(), 0);
+    const uint64_t timestamp = Clock::now().time_since_epoch().count();
+
+    Increment(record->numberOfCalls, 1);
+    Increment(record->totalCallTime, microseconds);
+    Increment(record->bins[GetBinIndex(microseconds)], 1);
+    record->lastCallTime.store(microseconds, std::memory_order_relaxed);
+    record->lastCallTimestamp.store(timestamp, std::memory_order_relaxed);
+
+    if (record->longestCallTime.load(std::memory_order_relaxed) < microseconds)
     {
-        stats.longestCallTime = duration;
+        record->longestCallTime.store(microseconds, std::memory_order_relaxed);
     }
 }
 
+void DiffusionCurveRenderer::Chronometer::Record(const std::string& name, std::chrono::microseconds duration)
+{
+    Record(Intern(name), duration);
+}
+
 DiffusionCurveRenderer::Stats DiffusionCurveRenderer::Chronometer::QueryAverageStats(const std::string& name)
 {
-    std::scoped_lock lock(MUTEX);
-    Stats& stats = STATS_OF_INSTANCES[name];
+    const ScopeId id = Intern(name);
+
+    if (id == INVALID_SCOPE_ID)
+    {
+        return Stats();
+    }
+
+    auto& registry = GetRegistry();
+    std::scoped_lock lock(registry.mutex);
+
+    Stats stats;
+    uint64_t lastCallTimestamp = 0;
+    std::array<uint64_t, NUMBER_OF_BINS> bins{};
+
+    std::vector<const ThreadBuckets*> threads(registry.threads.begin(), registry.threads.end());
+    threads.push_back(&registry.retired);
+
+    // Merge the buckets of all threads, running or exited
+    for (const auto* thread : threads)
+    {
+        const ScopeRecord* record = thread->records[id].load(std::memory_order_acquire);
 
-    stats.numberOfQueries++;
+        if (record == nullptr)
+            continue;
 
-    if (stats.numberOfCallsAtLastQuery == stats.numberOfCalls)
-        stats.callTime = std::chrono::microseconds(0);
+        stats.numberOfCalls += record->numberOfCalls.load(std::memory_order_relaxed);
+        stats.totalCallTime += std::chrono::microseconds(record->totalCallTime.load(std::memory_order_relaxed));
+        stats.longestCallTime = std::max(stats.longestCallTime, std::chrono::microseconds(record->longestCallTime.load(std::memory_order_relaxed)));
+
+        if (const uint64_t timestamp = record->lastCallTimestamp.load(std::memory_order_relaxed); lastCallTimestamp <= timestamp)
+        {
+            lastCallTimestamp = timestamp;
+            stats.lastCallTime = std::chrono::microseconds(record->lastCallTime.load(std::memory_order_relaxed));
+        }
+
+        for (int i = 0; i < NUMBER_OF_BINS; ++i)
+            bins[i] += record->bins[i].load(std::memory_order_relaxed);
+    }
+
+    // Percentiles
+    uint64_t numberOfSamples = 0;
+    for (const auto count : bins)
+        numberOfSamples += count;
+
+    const auto percentile = [&](double fraction)
+    {
+        const auto rank = static_cast<uint64_t>(std::ceil(fraction * numberOfSamples));
+        uint64_t cumulative = 0;
 
-    stats.numberOfCallsAtLastQuery = stats.numberOfCalls;
+        for (int i = 0; i < NUMBER_OF_BINS; ++i)
+        {
+            cumulative += bins[i];
+
+            if (rank <= cumulative)
+                return std::chrono::microseconds(GetBinValue(i));
+        }
+
+        return std::chrono::microseconds(0);
+    };
+
+    if (numberOfSamples > 0)
+    {
+        stats.p50 = percentile(0.50);
+        stats.p95 = percentile(0.95);
+        stats.p99 = percentile(0.99);
+    }
+
+    // Call time is reported only if the scope was called since the last query
+    QueryState& state = registry.queryStates[id];
+    state.numberOfQueries++;
+
+    stats.callTime = state.numberOfCallsAtLastQuery == stats.numberOfCalls ? std::chrono::microseconds(0) : stats.lastCallTime;
+    stats.numberOfQueries = state.numberOfQueries;
+    stats.numberOfCallsAtLastQuery = state.numberOfCallsAtLastQuery;
+
+    state.numberOfCallsAtLastQuery = stats.numberOfCalls;
 
     return stats;
 }
@@ -48,13 +351,23 @@ std::string DiffusionCurveRenderer::Chronometer::Print(const std::string& name)
 {
     const auto stats = QueryAverageStats(name);
 
-    return std::format("{:<40}: {:<5.3} ms,   {:<5.3} ms,   {:<5.3} ms",
+    return std::format("{:<40}: {:<5.3} ms,   {:<5.3} ms,   {:<5.3} ms,   p50 {:<5.3} ms,   p95 {:<5.3} ms,   p99 {:<5.3} ms",
                        name,
                        stats.callTime.count() / 1000.0f,
                        stats.lastCallTime.count() / 1000.0f,
-                       stats.longestCallTime.count() / 1000.0f);
+                       stats.longestCallTime.count() / 1000.0f,
+                       stats.p50.count() / 1000.0f,
+                       stats.p95.count() / 1000.0f,
+                       stats.p99.count() / 1000.0f);
 }
 
-std::mutex DiffusionCurveRenderer::Chronometer::MUTEX = std::mutex();
+std::vector<std::string> DiffusionCurveRenderer::Chronometer::GetNames()
+{
+    auto& registry = GetRegistry();
+    std::scoped_lock lock(registry.mutex);
 
-std::map<std::string, DiffusionCurveRenderer::Stats> DiffusionCurveRenderer::Chronometer::STATS_OF_INSTANCES{};
\ No newline at end of file
+    std::vector<std::string> names(registry.names.begin(), registry.names.end());
+    std::sort(names.begin(), names.end());
+
+    return names;
+}
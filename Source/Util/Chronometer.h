@@ -1,13 +1,19 @@
 #pragma once
 
 #include <chrono>
-#include <map>
-#include <mutex>
+#include <cstdint>
+#include <format>
 #include <string>
+#include <vector>
 
 namespace DiffusionCurveRenderer
 {
-    using Clock = std::chrono::time_point<std::chrono::system_clock>;
+    using Clock = std::chrono::steady_clock;
+
+    // Interned name of a measured scope
+    using ScopeId = uint32_t;
+
+    constexpr ScopeId INVALID_SCOPE_ID = UINT32_MAX;
 
     struct Stats
     {
@@ -18,28 +24,41 @@ namespace DiffusionCurveRenderer
         std::chrono::microseconds callTime{ 0 };
         std::chrono::microseconds lastCallTime{ 0 };
         std::chrono::microseconds longestCallTime{ 0 };
+        std::chrono::microseconds p50{ 0 };
+        std::chrono::microseconds p95{ 0 };
+        std::chrono::microseconds p99{ 0 };
     };
 
+    // Measures the lifetime of a scope. Each thread records into its own buckets without
+    // locking, buckets of all threads are merged when stats are queried.
     class Chronometer
     {
       public:
+        Chronometer(ScopeId id);
         Chronometer(const std::string& name);
         ~Chronometer();
 
+        // Takes a lock, intern once and keep the ID for frequently measured scopes
+        static ScopeId Intern(const std::string& name);
+        static std::string GetName(ScopeId id);
+
+        // Adds a measurement taken elsewhere, e.g. a GPU timer query
+        static void Record(ScopeId id, std::chrono::microseconds duration);
+        static void Record(const std::string& name, std::chrono::microseconds duration);
+
         static Stats QueryAverageStats(const std::string& name);
         static std::string Print(const std::string& name);
+        static std::vector<std::string> GetNames();
 
       private:
-        Clock mStartTime{ std::chrono::system_clock::now() };
-        std::string mName;
-
-        static std::mutex MUTEX;
-        static std::map<std::string, Stats> STATS_OF_INSTANCES;
+        Clock::time_point mStartTime{ Clock::now() };
+        ScopeId mId;
     };
 }
 
-#define MEASURE_CALL_TIME(NAME) \
-    DiffusionCurveRenderer::Chronometer CHORONOMETER__##NAME = DiffusionCurveRenderer::Chronometer(NAME)
+#define MEASURE_CALL_TIME(NAME)                                                                                                  \
+    static const DiffusionCurveRenderer::ScopeId CHORONOMETER_ID__##NAME = DiffusionCurveRenderer::Chronometer::Intern(NAME); \
+    DiffusionCurveRenderer::Chronometer CHORONOMETER__##NAME = DiffusionCurveRenderer::Chronometer(CHORONOMETER_ID__##NAME)
 
 #define MEASURE_CALL_TIME_WITH_ARGS(NAME, FORMAT, ...) \
     DiffusionCurveRenderer::Chronometer CHORONOMETER__##NAME = DiffusionCurveRenderer::Chronometer(std::format(FORMAT, __VA_ARGS__))
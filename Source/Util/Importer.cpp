@@ -84,12 +84,44 @@ QVector<DiffusionCurveRenderer::CurvePtr> DiffusionCurveRenderer::Importer::Impo
                         curve->AddColorPoint(type, colors[i], positions[i] / maxGlobalID);
                     }
                 }
+                else if (child.tagName() == "blur_points_set")
+                {
+                    // Blur scales are radii in scene units, positions use the same global IDs as the colors
+                    QDomElement element = child.firstChild().toElement();
+                    int maxGlobalID = 0;
+
+                    QVector<float> strengths;
+                    QVector<float> positions;
+
+                    while (element.isNull() == false)
+                    {
+                        const int globalID = element.attribute("globalID").toInt();
+
+                        strengths << element.attribute("value").toFloat();
+                        positions << globalID;
+
+                        if (globalID >= maxGlobalID)
+                        {
+                            maxGlobalID = globalID;
+                        }
+
+                        element = element.nextSibling().toElement();
+                    }
+
+                    for (int i = 0; i < strengths.size(); ++i)
+                    {
+                        curve->AddBlurPoint(maxGlobalID > 0 ? positions[i] / maxGlobalID : 0.0f, strengths[i]);
+                    }
+                }
                 child = child.nextSibling().toElement();
             }
         }
 
-        curve->AddBlurPoint(0, DEFAULT_BLUR_STRENGTH);
-        curve->AddBlurPoint(0, DEFAULT_BLUR_STRENGTH);
+        if (curve->GetNumberOfBlurPoints() == 0)
+        {
+            curve->AddBlurPoint(0, DEFAULT_BLUR_STRENGTH);
+            curve->AddBlurPoint(0, DEFAULT_BLUR_STRENGTH);
+        }
 
         curves << curve;
 
@@ -0,0 +1,91 @@
+#include "Parallel.h"
+
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrent>
+#include <algorithm>
+#include <atomic>
+
+void DiffusionCurveRenderer::Parallel::For(int count, int grain, const std::function<void(int, int)>& function)
+{
+    if (count <= 0)
+        return;
+
+    grain = std::max(1, grain);
+
+    const int numberOfChunks = (count + grain - 1) / grain;
+
+    if (numberOfChunks == 1 || GetThreadCount() == 1)
+    {
+        function(0, count);
+        return;
+    }
+
+    QVector<int> chunks(numberOfChunks);
+
+    for (int i = 0; i < numberOfChunks; ++i)
+    {
+        chunks[i] = i;
+    }
+
+    QtConcurrent::blockingMap(GetThreadPool(), chunks, [&](int chunk) { //
+        function(chunk * grain, std::min(count, (chunk + 1) * grain));
+    });
+}
+
+void DiffusionCurveRenderer::Parallel::ForLargestFirst(int count,
+                                                       const std::function<qint64(int)>& size,
+                                                       const std::function<void(int)>& function,
+                                                       const std::function<void(int)>& progress)
+{
+    QVector<int> order(count);
+    QVector<qint64> sizes(count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        order[i] = i;
+        sizes[i] = size(i);
+    }
+
+    // Stable, items of the same size keep their order
+    std::stable_sort(order.begin(), order.end(), [&sizes](int a, int b) { return sizes[a] > sizes[b]; });
+
+    QThread* caller = QThread::currentThread();
+    std::atomic_int finished{ 0 };
+
+    For(count, 1, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i)
+        {
+            function(order[i]);
+
+            const int done = ++finished;
+
+            if (progress && QThread::currentThread() == caller)
+                progress(done);
+        }
+    });
+}
+
+void DiffusionCurveRenderer::Parallel::SetThreadCount(int threadCount)
+{
+    // The caller works too, the pool only provides the helpers
+    GetThreadPool()->setMaxThreadCount(std::max(1, threadCount) - 1);
+}
+
+int DiffusionCurveRenderer::Parallel::GetThreadCount()
+{
+    return GetThreadPool()->maxThreadCount() + 1;
+}
+
+QThreadPool* DiffusionCurveRenderer::Parallel::GetThreadPool()
+{
+    // A dedicated pool, so long running tasks in the global pool (e.g. vectorization) cannot starve the render loops
+    static QThreadPool* pool = []() {
+        auto* pool = new QThreadPool;
+        pool->setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+        return pool;
+    }();
+
+    return pool;
+}
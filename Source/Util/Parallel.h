@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QtGlobal>
+#include <functional>
+
+class QThreadPool;
+
+namespace DiffusionCurveRenderer
+{
+    class Parallel
+    {
+      public:
+        Parallel() = delete;
+
+        // Calls function(begin, end) over [0, count) in chunks of at most grain items and returns when all chunks are done.
+        // Chunks are handed out one by one, so threads that finish early pick up the remaining work.
+        // The calling thread takes part in the work. Do not nest calls, inner calls would wait on a busy pool.
+        static void For(int count, int grain, const std::function<void(int, int)>& function);
+
+        // Calls function(i) for every i in [0, count), one item per task and the items with the largest size(i) first.
+        // Balances items of very different costs, e.g. chains whose lengths span orders of magnitude, since a long item
+        // started last would keep one thread busy after the others are done. Do not nest, see For().
+        // progress(finished) is called on the calling thread only, whenever it finishes an item itself.
+        static void ForLargestFirst(int count,
+                                    const std::function<qint64(int)>& size,
+                                    const std::function<void(int)>& function,
+                                    const std::function<void(int)>& progress = nullptr);
+
+        // Number of threads For() uses including the caller, defaults to QThread::idealThreadCount()
+        static void SetThreadCount(int threadCount);
+        static int GetThreadCount();
+
+      private:
+        static QThreadPool* GetThreadPool();
+    };
+}
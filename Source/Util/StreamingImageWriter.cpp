@@ -0,0 +1,460 @@
+#include "StreamingImageWriter.h"
+
+#include "Util/Logger.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace
+{
+    void AppendLittleEndian(QByteArray& bytes, uint64_t value, int size)
+    {
+        for (int i = 0; i < size; ++i)
+            bytes.append(char((value >> (8 * i)) & 0xFF));
+    }
+
+    void AppendBigEndian(QByteArray& bytes, uint32_t value)
+    {
+        for (int i = 3; i >= 0; --i)
+            bytes.append(char((value >> (8 * i)) & 0xFF));
+    }
+
+    uint32_t Crc32(const QByteArray& bytes, uint32_t crc = 0xFFFFFFFFu)
+    {
+        static const std::array<uint32_t, 256> TABLE = [] {
+            std::array<uint32_t, 256> table{};
+
+            for (uint32_t n = 0; n < 256; ++n)
+            {
+                uint32_t c = n;
+
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+
+                table[n] = c;
+            }
+
+            return table;
+        }();
+
+        for (const char byte : bytes)
+            crc = TABLE[(crc ^ uint8_t(byte)) & 0xFF] ^ (crc >> 8);
+
+        return crc;
+    }
+
+    uint32_t Adler32(const char* data, int64_t size, uint32_t adler)
+    {
+        constexpr uint32_t BASE = 65521;
+        constexpr int64_t NMAX = 5552; // Largest run that cannot overflow 32 bits before the modulo
+
+        uint32_t a = adler & 0xFFFF;
+        uint32_t b = adler >> 16;
+
+        while (size > 0)
+        {
+            const int64_t count = std::min(size, NMAX);
+
+            for (int64_t i = 0; i < count; ++i)
+            {
+                a += uint8_t(data[i]);
+                b += a;
+            }
+
+            a %= BASE;
+            b %= BASE;
+            data += count;
+            size -= count;
+        }
+
+        return (b << 16) | a;
+    }
+
+    // TIFF field types
+    constexpr uint16_t SHORT = 3;
+    constexpr uint16_t LONG = 4;
+    constexpr uint16_t LONG8 = 16;
+}
+
+DiffusionCurveRenderer::StreamingImageWriter::~StreamingImageWriter()
+{
+    if (mFile.isOpen())
+        Abort();
+}
+
+bool DiffusionCurveRenderer::StreamingImageWriter::Open(const QString& path, int width, int height)
+{
+    if (width <= 0 || height <= 0)
+    {
+        LOG_WARN("StreamingImageWriter::Open: Invalid image size {}x{}.", width, height);
+        return false;
+    }
+
+    if (path.endsWith(".tif", Qt::CaseInsensitive) || path.endsWith(".tiff", Qt::CaseInsensitive))
+        mFormat = Format::Tiff;
+    else if (path.endsWith(".png", Qt::CaseInsensitive))
+        mFormat = Format::Png;
+    else
+    {
+        LOG_WARN("StreamingImageWriter::Open: Unsupported format '{}', use .tif or .png.", path.toStdString());
+        return false;
+    }
+
+    mFile.setFileName(path);
+
+    if (mFile.open(QIODevice::WriteOnly | QIODevice::Truncate) == false)
+    {
+        LOG_WARN("StreamingImageWriter::Open: Could not open '{}' for writing.", path.toStdString());
+        return false;
+    }
+
+    mWidth = width;
+    mHeight = height;
+    mRowsWritten = 0;
+    mRegionPixelsWritten = 0;
+    mPendingBytes.clear();
+    mAdler = 1;
+
+    const bool success = mFormat == Format::Tiff ? WriteTiffHeader() : WritePngHeader();
+
+    if (success == false)
+        Abort();
+
+    return success;
+}
+
+bool DiffusionCurveRenderer::StreamingImageWriter::WriteRows(const uint8_t* data, int rows, int64_t stride)
+{
+    DCR_ASSERT(mFile.isOpen());
+    DCR_ASSERT(mRegionPixelsWritten == 0);
+
+    if (mRowsWritten + rows > mHeight)
+    {
+        LOG_WARN("StreamingImageWriter::WriteRows: More rows than the image height.");
+        return false;
+    }
+
+    bool success = true;
+
+    if (mFormat == Format::Tiff)
+    {
+        const int64_t rowBytes = 4 * int64_t(mWidth);
+
+        for (int y = 0; y < rows && success; ++y)
+            success = Write(data + y * stride, rowBytes);
+    }
+    else
+    {
+        success = WritePngRows(data, rows, stride);
+    }
+
+    mRowsWritten += rows;
+
+    return success;
+}
+
+bool DiffusionCurveRenderer::StreamingImageWriter::WriteRegion(int x, int y, int width, int rows, const uint8_t* data, int64_t stride)
+{
+    DCR_ASSERT(mFile.isOpen());
+    DCR_ASSERT(mRowsWritten == 0);
+
+    if (mFormat != Format::Tiff)
+    {
+        LOG_WARN("StreamingImageWriter::WriteRegion: Only TIFF files can be written in regions.");
+        return false;
+    }
+
+    if (x < 0 || y < 0 || width <= 0 || rows <= 0 || x + width > mWidth || y + rows > mHeight)
+    {
+        LOG_WARN("StreamingImageWriter::WriteRegion: Region {}x{} at {},{} is outside of the image.", width, rows, x, y);
+        return false;
+    }
+
+    const int64_t dataOffset = mBigTiff ? 16 : 8;
+    const int64_t rowBytes = 4 * int64_t(mWidth);
+
+    // Writing past the end extends the file, the gaps are filled by later regions
+    for (int row = 0; row < rows; ++row)
+    {
+        if (mFile.seek(dataOffset + (y + row) * rowBytes + 4 * int64_t(x)) == false || Write(data + row * stride, 4 * int64_t(width)) == false)
+            return false;
+    }
+
+    mRegionPixelsWritten += int64_t(width) * rows;
+
+    return true;
+}
+
+bool DiffusionCurveRenderer::StreamingImageWriter::Close()
+{
+    if (mFile.isOpen() == false)
+        return false;
+
+    if (mRegionPixelsWritten > 0)
+    {
+        if (mRegionPixelsWritten != int64_t(mWidth) * mHeight)
+        {
+            LOG_WARN("StreamingImageWriter::Close: Only {} of {} pixels were written.", mRegionPixelsWritten, int64_t(mWidth) * mHeight);
+            Abort();
+            return false;
+        }
+    }
+    else if (mRowsWritten != mHeight)
+    {
+        LOG_WARN("StreamingImageWriter::Close: Only {} of {} rows were written.", mRowsWritten, mHeight);
+        Abort();
+        return false;
+    }
+
+    const bool success = mFormat == Format::Tiff ? WriteTiffDirectory() : WritePngTrailer();
+
+    mFile.close();
+
+    if (success == false)
+        mFile.remove();
+
+    return success;
+}
+
+void DiffusionCurveRenderer::StreamingImageWriter::Abort()
+{
+    if (mFile.isOpen())
+        mFile.close();
+
+    mFile.remove();
+    mPendingBytes.clear();
+}
+
+bool DiffusionCurveRenderer::StreamingImageWriter::Write(const void* data, int64_t size)
+{
+    if (mFile.write(static_cast<const char*>(data), size) != size)
+    {
+        LOG_WARN("StreamingImageWriter::Write: Could not write to '{}'.", mFile.fileName().toStdString());
+        return false;
+    }
+
+    return true;
+}
+
+bool DiffusionCurveRenderer::StreamingImageWriter::WriteTiffHeader()
+{
+    const uint64_t strips = (mHeight + TIFF_ROWS_PER_STRIP - 1) / TIFF_ROWS_PER_STRIP;
+    const uint64_t pixelBytes = 4ull * mWidth * mHeight;
+
+    // Classic TIFF offsets are 32 bits, leave room for the directory and the strip tables after the pixels
+    mBigTiff = pixelBytes + 16 * strips + 4096 > 0xFFFFFFFFull;
+
+    QByteArray header("II");
+
+    if (mBigTiff)
+    {
+        AppendLittleEndian(header, 43, 2);
+        AppendLittleEndian(header, 8, 2); // Offset size
+        AppendLittleEndian(header, 0, 2);
+        AppendLittleEndian(header, 0, 8); // Directory offset, patched in WriteTiffDirectory()
+    }
+    else
+    {
+        AppendLittleEndian(header, 42, 2);
+        AppendLittleEndian(header, 0, 4);
+    }
+
+    return Write(header.constData(), header.size());
+}
+
+bool DiffusionCurveRenderer::StreamingImageWriter::WriteTiffDirectory()
+{
+    struct Entry
+    {
+        uint16_t tag;
+        uint16_t type;
+        std::vector<uint64_t> values;
+    };
+
+    const int64_t dataOffset = mBigTiff ? 16 : 8;
+    const int64_t rowBytes = 4 * int64_t(mWidth);
+    const int strips = (mHeight + TIFF_ROWS_PER_STRIP - 1) / TIFF_ROWS_PER_STRIP;
+
+    std::vector<uint64_t> stripOffsets(strips);
+    std::vector<uint64_t> stripByteCounts(strips);
+
+    for (int i = 0; i < strips; ++i)
+    {
+        const int rows = std::min(TIFF_ROWS_PER_STRIP, mHeight - i * TIFF_ROWS_PER_STRIP);
+        stripOffsets[i] = dataOffset + int64_t(i) * TIFF_ROWS_PER_STRIP * rowBytes;
+        stripByteCounts[i] = rows * rowBytes;
+    }
+
+    const uint16_t offsetType = mBigTiff ? LONG8 : LONG;
+
+    // Regions may have left the file position anywhere, the directory follows the pixels
+    if (mFile.seek(dataOffset + mHeight * rowBytes) == false)
+        return false;
+
+    // Sorted by tag as the format requires
+    const std::vector<Entry> entries = {
+        { 256, LONG, { uint64_t(mWidth) } },           // ImageWidth
+        { 257, LONG, { uint64_t(mHeight) } },          // ImageLength
+        { 258, SHORT, { 8, 8, 8, 8 } },                // BitsPerSample
+        { 259, SHORT, { 1 } },                         // Compression: none
+        { 262, SHORT, { 2 } },                         // PhotometricInterpretation: RGB
+        { 273, offsetType, stripOffsets },             // StripOffsets
+        { 277, SHORT, { 4 } },                         // SamplesPerPixel
+        { 278, LONG, { TIFF_ROWS_PER_STRIP } },        // RowsPerStrip
+        { 279, offsetType, stripByteCounts },          // StripByteCounts
+        { 284, SHORT, { 1 } },                         // PlanarConfiguration: chunky
+        { 338, SHORT, { 2 } },                         // ExtraSamples: unassociated alpha
+    };
+
+    const int offsetSize = mBigTiff ? 8 : 4;
+    const int countSize = mBigTiff ? 8 : 4;
+    const int numberOfEntriesSize = mBigTiff ? 8 : 2;
+    const int entrySize = 4 + countSize + offsetSize;
+
+    const int64_t directoryOffset = mFile.pos();
+    const int64_t directorySize = numberOfEntriesSize + int64_t(entries.size()) * entrySize + offsetSize;
+
+    QByteArray directory;
+    QByteArray external;
+
+    AppendLittleEndian(directory, entries.size(), numberOfEntriesSize);
+
+    for (const auto& entry : entries)
+    {
+        const int valueSize = entry.type == SHORT ? 2 : (entry.type == LONG ? 4 : 8);
+
+        QByteArray values;
+
+        for (const auto value : entry.values)
+            AppendLittleEndian(values, value, valueSize);
+
+        AppendLittleEndian(directory, entry.tag, 2);
+        AppendLittleEndian(directory, entry.type, 2);
+        AppendLittleEndian(directory, entry.values.size(), countSize);
+
+        if (values.size() <= offsetSize)
+        {
+            // Small values are stored in the entry itself, left aligned
+            values.append(QByteArray(offsetSize - values.size(), '\0'));
+            directory.append(values);
+        }
+        else
+        {
+            AppendLittleEndian(directory, directoryOffset + directorySize + external.size(), offsetSize);
+            external.append(values);
+        }
+    }
+
+    AppendLittleEndian(directory, 0, offsetSize); // No further directories
+
+    if (Write(directory.constData(), directory.size()) == false || Write(external.constData(), external.size()) == false)
+        return false;
+
+    QByteArray offset;
+    AppendLittleEndian(offset, directoryOffset, offsetSize);
+
+    return mFile.seek(mBigTiff ? 8 : 4) && Write(offset.constData(), offset.size());
+}
+
+bool DiffusionCurveRenderer::StreamingImageWriter::WritePngHeader()
+{
+    const char signature[] = { char(0x89), 'P', 'N', 'G', '\r', '\n', char(0x1A), '\n' };
+
+    if (Write(signature, sizeof(signature)) == false)
+        return false;
+
+    QByteArray header;
+    AppendBigEndian(header, mWidth);
+    AppendBigEndian(header, mHeight);
+    header.append(char(8)); // Bit depth
+    header.append(char(6)); // Color type: RGBA
+    header.append(char(0)); // Compression: deflate
+    header.append(char(0)); // Filter method
+    header.append(char(0)); // No interlace
+
+    return WritePngChunk("IHDR", header);
+}
+
+bool DiffusionCurveRenderer::StreamingImageWriter::WritePngRows(const uint8_t* data, int rows, int64_t stride)
+{
+    const int64_t rowBytes = 4 * int64_t(mWidth);
+
+    for (int first = 0; first < rows; first += PNG_ROWS_PER_CHUNK)
+    {
+        QByteArray chunk;
+
+        // The whole image data is a single zlib stream spread over the IDAT chunks
+        if (mRowsWritten == 0 && first == 0)
+        {
+            chunk.append(char(0x78));
+            chunk.append(char(0x01));
+        }
+
+        for (int y = first; y < std::min(rows, first + PNG_ROWS_PER_CHUNK); ++y)
+        {
+            const char filter = 0; // None
+
+            mPendingBytes.append(filter);
+            mPendingBytes.append(reinterpret_cast<const char*>(data + y * stride), rowBytes);
+
+            mAdler = Adler32(&filter, 1, mAdler);
+            mAdler = Adler32(reinterpret_cast<const char*>(data + y * stride), rowBytes, mAdler);
+
+            AppendStoredBlocks(chunk, false);
+        }
+
+        if (chunk.isEmpty() == false && WritePngChunk("IDAT", chunk) == false)
+            return false;
+    }
+
+    return true;
+}
+
+bool DiffusionCurveRenderer::StreamingImageWriter::WritePngTrailer()
+{
+    QByteArray chunk;
+
+    AppendStoredBlocks(chunk, true);
+    AppendBigEndian(chunk, mAdler);
+
+    return WritePngChunk("IDAT", chunk) && WritePngChunk("IEND", QByteArray());
+}
+
+void DiffusionCurveRenderer::StreamingImageWriter::AppendStoredBlocks(QByteArray& chunk, bool final)
+{
+    qsizetype consumed = 0;
+
+    // Full blocks can be emitted right away, the last one is held back until it is known to be final
+    while (mPendingBytes.size() - consumed >= PNG_MAX_STORED_BLOCK || final)
+    {
+        const int length = int(std::min<qsizetype>(mPendingBytes.size() - consumed, PNG_MAX_STORED_BLOCK));
+        const bool last = final && consumed + length == mPendingBytes.size();
+
+        chunk.append(char(last ? 1 : 0)); // BFINAL, BTYPE 00 (stored)
+        AppendLittleEndian(chunk, length, 2);
+        AppendLittleEndian(chunk, uint16_t(~length), 2);
+        chunk.append(mPendingBytes.constData() + consumed, length);
+
+        consumed += length;
+
+        if (last)
+            break;
+    }
+
+    mPendingBytes.remove(0, consumed);
+}
+
+bool DiffusionCurveRenderer::StreamingImageWriter::WritePngChunk(const char* type, const QByteArray& data)
+{
+    const QByteArray name(type, 4);
+
+    QByteArray length;
+    AppendBigEndian(length, uint32_t(data.size()));
+
+    // CRC covers the chunk type and the data
+    QByteArray crc;
+    AppendBigEndian(crc, Crc32(data, Crc32(name)) ^ 0xFFFFFFFFu);
+
+    return Write(length.constData(), 4) && Write(name.constData(), 4) && Write(data.constData(), data.size()) && Write(crc.constData(), 4);
+}
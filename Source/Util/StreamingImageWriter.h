@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <cstdint>
+
+namespace DiffusionCurveRenderer
+{
+    // Writes RGBA8 images that are too large to keep in memory, rows are appended from top to bottom.
+    // The format follows the extension: .tif/.tiff writes uncompressed strips and switches to BigTIFF above 4 GB,
+    // .png writes stored (uncompressed) deflate blocks since no zlib is linked, so prefer TIFF for large prints.
+    // TIFF pixels sit at fixed offsets, so it also accepts rectangles in any order instead of whole rows.
+    class StreamingImageWriter
+    {
+      public:
+        StreamingImageWriter() = default;
+        ~StreamingImageWriter();
+
+        bool Open(const QString& path, int width, int height);
+
+        // Rows are tightly packed RGBA8 with stride bytes between them
+        bool WriteRows(const uint8_t* data, int rows, int64_t stride);
+
+        // Writes a width x rows rectangle at x, y. Only TIFF supports it, rectangles must not overlap
+        // and rows cannot be appended to the same file.
+        bool WriteRegion(int x, int y, int width, int rows, const uint8_t* data, int64_t stride);
+        bool SupportsRegions() const { return mFormat == Format::Tiff; }
+
+        // Finishes the file, fails if fewer pixels than the image has were written
+        bool Close();
+
+        // Closes and removes the file
+        void Abort();
+
+        bool IsOpen() const { return mFile.isOpen(); }
+        int GetRowsWritten() const { return mRowsWritten; }
+
+      private:
+        enum class Format
+        {
+            Tiff,
+            Png
+        };
+
+        bool WriteTiffHeader();
+        bool WriteTiffDirectory();
+
+        bool WritePngHeader();
+        bool WritePngRows(const uint8_t* data, int rows, int64_t stride);
+        bool WritePngTrailer();
+        bool WritePngChunk(const char* type, const QByteArray& data);
+        void AppendStoredBlocks(QByteArray& chunk, bool final);
+
+        bool Write(const void* data, int64_t size);
+
+        QFile mFile;
+        Format mFormat{ Format::Tiff };
+        int mWidth{ 0 };
+        int mHeight{ 0 };
+        int mRowsWritten{ 0 };
+        int64_t mRegionPixelsWritten{ 0 };
+
+        // TIFF, strips are written back to back so their offsets follow from the row size
+        bool mBigTiff{ false };
+
+        // PNG, filtered bytes that do not fill a stored block yet
+        QByteArray mPendingBytes;
+        uint32_t mAdler{ 1 };
+
+        static constexpr int TIFF_ROWS_PER_STRIP = 64;
+        static constexpr int PNG_MAX_STORED_BLOCK = 65535;
+        static constexpr int PNG_ROWS_PER_CHUNK = 256;
+    };
+}
@@ -0,0 +1,273 @@
+#include "Tracer.h"
+
+#include "Logger.h"
+
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace DiffusionCurveRenderer
+{
+    namespace
+    {
+        constexpr uint64_t CAPACITY = 1 << 18;
+
+        enum class EventType : uint32_t
+        {
+            Scope,
+            FrameMarker
+        };
+
+        // Each field is atomic so that dumping while other threads record is race free. The sequence is
+        // zero while a slot is being written and the event index plus one once it is complete.
+        struct Event
+        {
+            std::atomic<uint64_t> sequence{ 0 };
+            std::atomic<uint32_t> type{ 0 };
+            std::atomic<uint32_t> id{ 0 };
+            std::atomic<uint32_t> trackId{ 0 };
+            std::atomic<int64_t> begin{ 0 };
+            std::atomic<int64_t> duration{ 0 };
+        };
+
+        struct EventSnapshot
+        {
+            EventType type;
+            ScopeId id;
+            uint32_t trackId;
+            int64_t begin;
+            int64_t duration;
+        };
+
+        std::atomic_bool ENABLED{ false };
+        std::atomic<uint64_t> HEAD{ 0 };
+        std::atomic<uint32_t> LAST_THREAD_ID{ 0 };
+
+        std::mutex MUTEX; // Guards the thread names and the allocation of the buffer
+        std::map<uint32_t, std::string> THREAD_NAMES;
+        std::unique_ptr<Event[]> EVENTS;
+        std::atomic<Event*> BUFFER{ nullptr };
+
+        uint32_t GetCurrentThreadId()
+        {
+            thread_local const uint32_t THREAD_ID = LAST_THREAD_ID.fetch_add(1) + 1;
+            return THREAD_ID;
+        }
+
+        int64_t ToMicroseconds(Clock::time_point timePoint)
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(timePoint.time_since_epoch()).count();
+        }
+
+        void Push(EventType type, ScopeId id, uint32_t trackId, int64_t begin, int64_t duration)
+        {
+            Event* buffer = BUFFER.load(std::memory_order_acquire);
+
+            if (buffer == nullptr)
+                return;
+
+            const uint64_t index = HEAD.fetch_add(1, std::memory_order_relaxed);
+            Event& event = buffer[index % CAPACITY];
+
+            event.sequence.store(0, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            event.type.store(static_cast<uint32_t>(type), std::memory_order_relaxed);
+            event.id.store(id, std::memory_order_relaxed);
+            event.trackId.store(trackId, std::memory_order_relaxed);
+            event.begin.store(begin, std::memory_order_relaxed);
+            event.duration.store(duration, std::memory_order_relaxed);
+
+            event.sequence.store(index + 1, std::memory_order_release);
+        }
+
+        bool Read(const Event& event, uint64_t index, EventSnapshot& snapshot)
+        {
+            if (event.sequence.load(std::memory_order_acquire) != index + 1)
+                return false;
+
+            snapshot.type = static_cast<EventType>(event.type.load(std::memory_order_relaxed));
+            snapshot.id = event.id.load(std::memory_order_relaxed);
+            snapshot.trackId = event.trackId.load(std::memory_order_relaxed);
+            snapshot.begin = event.begin.load(std::memory_order_relaxed);
+            snapshot.duration = event.duration.load(std::memory_order_relaxed);
+
+            // Overwritten while being copied
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return event.sequence.load(std::memory_order_relaxed) == index + 1;
+        }
+
+        std::string Escape(const std::string& text)
+        {
+            std::string result;
+            result.reserve(text.size());
+
+            for (const char c : text)
+            {
+                if (c == '"' || c == '\\')
+                    result += '\\';
+
+                result += c;
+            }
+
+            return result;
+        }
+    }
+}
+
+void DiffusionCurveRenderer::Tracer::SetEnabled(bool enabled)
+{
+    if (enabled)
+    {
+        std::scoped_lock lock(MUTEX);
+
+        if (EVENTS == nullptr)
+        {
+            EVENTS = std::make_unique<Event[]>(CAPACITY);
+            BUFFER.store(EVENTS.get(), std::memory_order_release);
+        }
+    }
+
+    ENABLED.store(enabled, std::memory_order_relaxed);
+
+    LOG_INFO("Tracer::SetEnabled: Trace recording is {}.", enabled ? "enabled" : "disabled");
+}
+
+bool DiffusionCurveRenderer::Tracer::IsEnabled()
+{
+    return ENABLED.load(std::memory_order_relaxed);
+}
+
+void DiffusionCurveRenderer::Tracer::AddScope(ScopeId id, Clock::time_point begin, std::chrono::microseconds duration)
+{
+    AddScope(id, GetCurrentThreadId(), begin, duration);
+}
+
+void DiffusionCurveRenderer::Tracer::AddScope(ScopeId id, uint32_t trackId, Clock::time_point begin, std::chrono::microseconds duration)
+{
+    if (IsEnabled() == false)
+        return;
+
+    Push(EventType::Scope, id, trackId, ToMicroseconds(begin), duration.count());
+}
+
+void DiffusionCurveRenderer::Tracer::AddFrameMarker(uint64_t frame)
+{
+    if (IsEnabled() == false)
+        return;
+
+    Push(EventType::FrameMarker, 0, GetCurrentThreadId(), ToMicroseconds(Clock::now()), static_cast<int64_t>(frame));
+}
+
+void DiffusionCurveRenderer::Tracer::SetCurrentThreadName(const std::string& name)
+{
+    std::scoped_lock lock(MUTEX);
+    THREAD_NAMES[GetCurrentThreadId()] = name;
+}
+
+bool DiffusionCurveRenderer::Tracer::Dump(const std::string& path)
+{
+    Event* buffer = BUFFER.load(std::memory_order_acquire);
+
+    if (buffer == nullptr)
+    {
+        LOG_WARN("Tracer::Dump: Nothing to dump, trace recording has never been enabled.");
+        return false;
+    }
+
+    std::ofstream file(path);
+
+    if (file.is_open() == false)
+    {
+        LOG_WARN("Tracer::Dump: Could not open '{}' for writing.", path);
+        return false;
+    }
+
+    const uint64_t head = HEAD.load(std::memory_order_acquire);
+    const uint64_t first = head > CAPACITY ? head - CAPACITY : 0;
+
+    std::map<ScopeId, std::string> names;
+    std::map<uint32_t, bool> tracks;
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool isFirstEvent = true;
+    uint64_t numberOfEvents = 0;
+
+    for (uint64_t index = first; index < head; ++index)
+    {
+        EventSnapshot event;
+
+        if (Read(buffer[index % CAPACITY], index, event) == false)
+            continue;
+
+        if (isFirstEvent == false)
+            file << ",\n";
+
+        isFirstEvent = false;
+        tracks[event.trackId] = true;
+
+        if (event.type == EventType::FrameMarker)
+        {
+            file << "{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":" << event.trackId //
+                 << ",\"ts\":" << event.begin << ",\"args\":{\"frame\":" << event.duration << "}}";
+        }
+        else
+        {
+            auto it = names.find(event.id);
+
+            if (it == names.end())
+                it = names.emplace(event.id, Escape(Chronometer::GetName(event.id))).first;
+
+            file << "{\"name\":\"" << it->second << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.trackId //
+                 << ",\"ts\":" << event.begin << ",\"dur\":" << event.duration << "}";
+        }
+
+        ++numberOfEvents;
+    }
+
+    // Track names
+    {
+        std::scoped_lock lock(MUTEX);
+
+        for (const auto& [trackId, used] : tracks)
+        {
+            std::string name;
+
+            if (trackId == GPU_TRACK_ID)
+                name = "GPU";
+            else if (const auto it = THREAD_NAMES.find(trackId); it != THREAD_NAMES.end())
+                name = it->second;
+            else
+                name = std::format("Thread {}", trackId);
+
+            if (isFirstEvent == false)
+                file << ",\n";
+
+            isFirstEvent = false;
+
+            file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << trackId //
+                 << ",\"args\":{\"name\":\"" << Escape(name) << "\"}}";
+        }
+    }
+
+    file << "\n]}\n";
+
+    LOG_INFO("Tracer::Dump: {} events are written to '{}'.", numberOfEvents, path);
+
+    return file.good();
+}
+
+void DiffusionCurveRenderer::Tracer::Clear()
+{
+    Event* buffer = BUFFER.load(std::memory_order_acquire);
+
+    if (buffer == nullptr)
+        return;
+
+    // Invalidate all slots by moving the head past them
+    HEAD.fetch_add(CAPACITY, std::memory_order_acq_rel);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Util/Chronometer.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace DiffusionCurveRenderer
+{
+    // Records measured scopes into an in-memory ring buffer and dumps them as Chrome trace-event JSON,
+    // which can be opened in chrome://tracing or ui.perfetto.dev. Recording is off by default.
+    class Tracer
+    {
+      public:
+        Tracer() = delete;
+
+        static void SetEnabled(bool enabled);
+        static bool IsEnabled();
+
+        // Scope that ran on the calling thread
+        static void AddScope(ScopeId id, Clock::time_point begin, std::chrono::microseconds duration);
+
+        // Scope that ran on a virtual track, e.g. the GPU
+        static void AddScope(ScopeId id, uint32_t trackId, Clock::time_point begin, std::chrono::microseconds duration);
+
+        static void AddFrameMarker(uint64_t frame);
+
+        static void SetCurrentThreadName(const std::string& name);
+
+        // Writes the events that are still in the ring buffer, oldest first
+        static bool Dump(const std::string& path);
+        static void Clear();
+
+        static constexpr uint32_t GPU_TRACK_ID = 1000000;
+    };
+}
@@ -17,4 +17,29 @@ QByteArray DiffusionCurveRenderer::Util::GetBytes(const QString& path)
         LOG_WARN("Util::GetBytes: '{}' could not be opened", path.toStdString());
         return QByteArray();
     }
-}
\ No newline at end of file
+}
+QVector4D DiffusionCurveRenderer::Util::InterpolateColor(const QVector<QVector4D>& colors, const QVector<float>& positions, float t)
+{
+    const int count = colors.size();
+
+    if (count == 0)
+        return QVector4D(0, 0, 0, 0);
+
+    for (int i = 1; i < count; ++i)
+    {
+        const float t0 = positions[i - 1];
+        const float t1 = positions[i];
+
+        if (t0 <= t && t <= t1)
+            return colors[i - 1] + (t - t0) / (t1 - t0) * (colors[i] - colors[i - 1]);
+    }
+
+    // Clamped at both ends
+    if (t < positions[0])
+        return colors[0];
+
+    if (positions[count - 1] < t)
+        return colors[count - 1];
+
+    return QVector4D(0, 0, 0, 0);
+}
@@ -2,6 +2,8 @@
 
 #include <QByteArray>
 #include <QString>
+#include <QVector4D>
+#include <QVector>
 
 namespace DiffusionCurveRenderer
 {
@@ -11,5 +13,8 @@ namespace DiffusionCurveRenderer
         Util() = delete;
 
         static QByteArray GetBytes(const QString& path);
+
+        // Color of a curve side at parameter t, GradientAtlas bakes the gradients of Color.geom with it
+        static QVector4D InterpolateColor(const QVector<QVector4D>& colors, const QVector<float>& positions, float t);
     };
 }
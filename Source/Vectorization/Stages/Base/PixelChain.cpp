@@ -22,7 +22,7 @@ DiffusionCurveRenderer::PixelChain::PixelChain(const PixelChain& other)
 /*
  * Returns the number of pixels in the chain.
  */
-int DiffusionCurveRenderer::PixelChain::GetLength()
+int DiffusionCurveRenderer::PixelChain::GetLength() const
 {
     return this->mPoints.size();
 }
@@ -30,7 +30,7 @@ int DiffusionCurveRenderer::PixelChain::GetLength()
 /*
  * Returns the first pixel position in the chain.
  */
-DiffusionCurveRenderer::Point DiffusionCurveRenderer::PixelChain::GetHead()
+DiffusionCurveRenderer::Point DiffusionCurveRenderer::PixelChain::GetHead() const
 {
     return this->mPoints.front();
 }
@@ -38,7 +38,7 @@ DiffusionCurveRenderer::Point DiffusionCurveRenderer::PixelChain::GetHead()
 /*
  * Returns the last pixel position in the chain.
  */
-DiffusionCurveRenderer::Point DiffusionCurveRenderer::PixelChain::GetTail()
+DiffusionCurveRenderer::Point DiffusionCurveRenderer::PixelChain::GetTail() const
 {
     return this->mPoints.back();
 }
@@ -46,7 +46,7 @@ DiffusionCurveRenderer::Point DiffusionCurveRenderer::PixelChain::GetTail()
 /*
  * Returns the <index>'th pixel position in the chain.
  */
-DiffusionCurveRenderer::Point DiffusionCurveRenderer::PixelChain::Get(int index)
+DiffusionCurveRenderer::Point DiffusionCurveRenderer::PixelChain::Get(int index) const
 {
     return this->mPoints.at(index);
 }
@@ -87,10 +87,10 @@ void DiffusionCurveRenderer::PixelChain::Reverse()
  */
 DiffusionCurveRenderer::PixelChain DiffusionCurveRenderer::PixelChain::Reversed()
 {
-    PixelChain* copy = new PixelChain(*this);
-    copy->Reverse();
+    PixelChain copy;
+    copy.mPoints.assign(this->mPoints.rbegin(), this->mPoints.rend());
 
-    return *copy;
+    return copy;
 }
 
 /*
@@ -102,15 +102,9 @@ DiffusionCurveRenderer::PixelChain DiffusionCurveRenderer::PixelChain::Reversed(
  *
  * param other: Another chain of pixels to add to this one.
  */
-void DiffusionCurveRenderer::PixelChain::InsertFront(PixelChain other)
+void DiffusionCurveRenderer::PixelChain::InsertFront(const PixelChain& other)
 {
-    std::deque<Point> copy = other.mPoints;
-
-    for (int i = 0; i < other.GetLength(); i++)
-    {
-        this->Prepend(copy.back());
-        copy.pop_back();
-    }
+    this->mPoints.insert(this->mPoints.begin(), other.mPoints.begin(), other.mPoints.end());
 }
 
 /*
@@ -122,13 +116,7 @@ void DiffusionCurveRenderer::PixelChain::InsertFront(PixelChain other)
  *
  * param other: Another chain of pixels to add to this one.
  */
-void DiffusionCurveRenderer::PixelChain::InsertBack(PixelChain other)
+void DiffusionCurveRenderer::PixelChain::InsertBack(const PixelChain& other)
 {
-    std::deque<Point> copy = other.mPoints;
-
-    for (int i = 0; i < other.GetLength(); i++)
-    {
-        this->Append(copy.front());
-        copy.pop_front();
-    }
+    this->mPoints.insert(this->mPoints.end(), other.mPoints.begin(), other.mPoints.end());
 }
\ No newline at end of file
@@ -30,22 +30,22 @@ namespace DiffusionCurveRenderer
         /*
          * Returns the number of pixels in the chain.
          */
-        int GetLength();
+        int GetLength() const;
 
         /*
          * Returns the first pixel position in the chain.
          */
-        Point GetHead();
+        Point GetHead() const;
 
         /*
          * Returns the last pixel position in the chain.
          */
-        Point GetTail();
+        Point GetTail() const;
 
         /*
          * Returns the <index>'th pixel position in the chain.
          */
-        Point Get(int index);
+        Point Get(int index) const;
 
         /*
          * Expands the pixel chain by attaching a new pixel to the front.
@@ -83,7 +83,7 @@ namespace DiffusionCurveRenderer
          *
          * param other: Another chain of pixels to add to this one.
          */
-        void InsertFront(PixelChain other);
+        void InsertFront(const PixelChain& other);
 
         /*
          * Extends this pixel chain by adding an entire other chain to the back.
@@ -94,6 +94,6 @@ namespace DiffusionCurveRenderer
          *
          * param other: Another chain of pixels to add to this one.
          */
-        void InsertBack(PixelChain other);
+        void InsertBack(const PixelChain& other);
     };
 }
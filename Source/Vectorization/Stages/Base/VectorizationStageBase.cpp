@@ -3,4 +3,27 @@
 DiffusionCurveRenderer::VectorizationStageBase::VectorizationStageBase(QObject* parent)
     : QObject(parent)
 {
+}
+
+void DiffusionCurveRenderer::VectorizationStageBase::SetCancellationToken(const std::atomic_bool* token)
+{
+    mCancellationToken = token;
+}
+
+bool DiffusionCurveRenderer::VectorizationStageBase::IsCancelled() const
+{
+    return mCancellationToken && mCancellationToken->load(std::memory_order_relaxed);
+}
+
+void DiffusionCurveRenderer::VectorizationStageBase::ReportProgress(float fraction)
+{
+    const bool newRun = !mProgressTimer.isValid() || fraction < mReportedProgress;
+
+    if (newRun || fraction >= 1.0f || (fraction - mReportedProgress >= PROGRESS_STEP && mProgressTimer.hasExpired(PROGRESS_INTERVAL)))
+    {
+        mReportedProgress = fraction;
+        mProgressTimer.start();
+
+        emit ProgressChanged(fraction);
+    }
 }
\ No newline at end of file
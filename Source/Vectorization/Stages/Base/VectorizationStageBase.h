@@ -1,6 +1,8 @@
 #pragma once
 
+#include <QElapsedTimer>
 #include <QObject>
+#include <atomic>
 
 namespace DiffusionCurveRenderer
 {
@@ -12,8 +14,30 @@ namespace DiffusionCurveRenderer
 
         virtual void Reset() = 0;
 
+        // The stage polls <token> while it runs, its owner raises it from any thread to stop the stage early.
+        // A cancelled stage skips its remaining work and finishes with partial results. Null, the default, never cancels.
+        void SetCancellationToken(const std::atomic_bool* token);
+
+        bool IsCancelled() const;
+
       signals:
         void Finished();
         void ProgressChanged(float fraction);
+
+      protected:
+        // Emits ProgressChanged(fraction) once it grew by PROGRESS_STEP and PROGRESS_INTERVAL milliseconds have
+        // passed since the last emission, stages call it per item without flooding the queued connections.
+        // 1.0 is always emitted and a fraction below the last emitted one starts a new run.
+        // Call it from the thread that runs the stage.
+        void ReportProgress(float fraction);
+
+      private:
+        static constexpr float PROGRESS_STEP = 0.01f;
+        static constexpr qint64 PROGRESS_INTERVAL = 50;
+
+        const std::atomic_bool* mCancellationToken{ nullptr };
+
+        QElapsedTimer mProgressTimer;
+        float mReportedProgress{ -1.0f };
     };
 }
\ No newline at end of file
@@ -1,88 +1,143 @@
 #include "ColorSampler.h"
 
+#include "Util/Parallel.h"
+
+#include <algorithm>
+
 DiffusionCurveRenderer::ColorSampler::ColorSampler(QObject* parent)
     : VectorizationStageBase(parent)
 {
-    mRandomGenerator = QRandomGenerator::securelySeeded();
 }
 
 void DiffusionCurveRenderer::ColorSampler::Run(const QVector<CurvePtr>& curves, cv::Mat& image, cv::Mat& imageLab, const double sampleDensity)
 {
-    int nCurves = curves.size();
+    const int nCurves = curves.size();
 
-    for (int i = 0; i < nCurves; i++)
-    {
+    // Curves only add color points to themselves, the longest ones take the most samples and are started first
+    Parallel::ForLargestFirst(
+        nCurves,
+        [&](int i) { return qint64(curves[i]->CalculateLength()); },
+        [&](int i) {
+            if (IsCancelled())
+                return;
 
-        CurvePtr curve = curves[i];
+            const quint32 seeds[] = { mSeed, quint32(i) };
+            QRandomGenerator generator(seeds, 2);
 
-        if (BezierPtr bezier = std::dynamic_pointer_cast<Bezier>(curve))
-        {
-            Sample(bezier, image, imageLab, sampleDensity);
-        }
-        else if (SplinePtr spline = std::dynamic_pointer_cast<Spline>(curve))
-        {
-            for (const auto& bezier : spline->GetBezierPatches())
+            CurvePtr curve = curves[i];
+
+            if (BezierPtr bezier = std::dynamic_pointer_cast<Bezier>(curve))
             {
-                Sample(bezier, image, imageLab, sampleDensity);
+                Sample(bezier, generator, image, sampleDensity);
             }
-        }
-
-        emit ProgressChanged(float(i) / (nCurves - 1));
-    }
+            else if (SplinePtr spline = std::dynamic_pointer_cast<Spline>(curve))
+            {
+                for (const auto& bezier : spline->GetBezierPatches())
+                {
+                    Sample(bezier, generator, image, sampleDensity);
+                }
+            }
+        },
+        [&](int finished) { ReportProgress(float(finished) / nCurves); });
 }
 
-void DiffusionCurveRenderer::ColorSampler::Sample(BezierPtr bezier, cv::Mat& image, cv::Mat& imageLab, const double sampleDensity)
+/*
+ * Samples both sides of <bezier> at its ends, at its middle and once per
+ * stratum of equal arc length, at a random position within the stratum.
+ * Positions and normals of all samples are evaluated in one batch and
+ * the color points are added at once.
+ */
+void DiffusionCurveRenderer::ColorSampler::Sample(BezierPtr bezier, QRandomGenerator& generator, const cv::Mat& image, const double sampleDensity)
 {
-    SampleAlongNormal(bezier, 0.0f, ColorPointType::Left, image, imageLab);
-    SampleAlongNormal(bezier, 0.0f, ColorPointType::Right, image, imageLab);
+    QVector<float> tableParameters(LENGTH_INTERVALS + 1);
+
+    for (int k = 0; k <= LENGTH_INTERVALS; ++k)
+    {
+        tableParameters[k] = float(k) / LENGTH_INTERVALS;
+    }
+
+    QVector<QVector2D> tablePositions;
+    bezier->EvaluateAt(tableParameters, tablePositions);
+
+    QVector<float> lengths(LENGTH_INTERVALS + 1, 0.0f);
 
-    SampleAlongNormal(bezier, 0.5, ColorPointType::Left, image, imageLab);
-    SampleAlongNormal(bezier, 0.5, ColorPointType::Right, image, imageLab);
+    for (int k = 1; k <= LENGTH_INTERVALS; ++k)
+    {
+        lengths[k] = lengths[k - 1] + tablePositions[k - 1].distanceToPoint(tablePositions[k]);
+    }
 
-    SampleAlongNormal(bezier, 1.0f, ColorPointType::Left, image, imageLab);
-    SampleAlongNormal(bezier, 1.0f, ColorPointType::Right, image, imageLab);
+    const float length = lengths.last();
+    const int nSamples = sampleDensity * length;
+    const int nStrata = std::max(0, nSamples - 3);
 
-    int nSamples = sampleDensity * bezier->CalculateLength();
+    // Left and right alternate, the strata cover the curve evenly instead of clustering where random parameters would
+    QVector<float> parameters = { 0.0f, 0.0f, 0.5f, 0.5f, 1.0f, 1.0f };
 
-    for (int i = 0; i < nSamples - 3; i++)
+    for (int i = 0; i < nStrata; i++)
     {
-        SampleAlongNormal(bezier, mRandomGenerator.bounded(1.0f), ColorPointType::Left, image, imageLab);
-        SampleAlongNormal(bezier, mRandomGenerator.bounded(1.0f), ColorPointType::Right, image, imageLab);
+        parameters << ParameterAt(lengths, (i + generator.bounded(1.0f)) / nStrata * length);
+        parameters << ParameterAt(lengths, (i + generator.bounded(1.0f)) / nStrata * length);
     }
+
+    QVector<QVector2D> positions;
+    QVector<QVector2D> normals;
+    bezier->EvaluateAt(parameters, positions, &normals);
+
+    QVector<ColorPoint> points;
+    points.reserve(parameters.size());
+
+    for (int j = 0; j < parameters.size(); j++)
+    {
+        const ColorPointType type = j % 2 == 0 ? ColorPointType::Left : ColorPointType::Right;
+        const QVector2D normal = type == ColorPointType::Left ? normals[j] : -normals[j];
+
+        QVector4D color;
+
+        if (SampleAlongNormal(positions[j], normal, image, color))
+        {
+            points << ColorPoint{ type, color, parameters[j] };
+        }
+    }
+
+    bezier->AddColorPoints(points);
 }
 
-void DiffusionCurveRenderer::ColorSampler::SampleAlongNormal(CurvePtr curve, float parameter, ColorPointType type, cv::Mat& image, cv::Mat& imageLab, const double distance)
+/*
+ * Returns the parameter at which the curve is <arcLength> long, by linear
+ * interpolation in <lengths>, the arc lengths at evenly spaced parameters.
+ */
+float DiffusionCurveRenderer::ColorSampler::ParameterAt(const QVector<float>& lengths, float arcLength)
 {
-    const int width = image.cols;
-    const int height = image.rows;
-    QVector2D point = curve->PositionAt(parameter);
-    QVector2D normal = curve->NormalAt(parameter);
+    // First entry at or beyond arcLength, the last one if there is none
+    const int k = std::lower_bound(lengths.begin() + 1, lengths.end() - 1, arcLength) - lengths.begin();
+
+    const float segment = lengths[k] - lengths[k - 1];
+    const float fraction = segment > 0.0f ? (arcLength - lengths[k - 1]) / segment : 0.0f;
 
-    if (type == ColorPointType::Right)
-        normal = -normal;
+    return std::clamp((k - 1 + fraction) / (lengths.size() - 1), 0.0f, 1.0f);
+}
 
+/*
+ * Reads the color <distance> pixels away from <point> along <normal>.
+ * Returns false if that pixel is outside of the image.
+ */
+bool DiffusionCurveRenderer::ColorSampler::SampleAlongNormal(const QVector2D& point, const QVector2D& normal, const cv::Mat& image, QVector4D& color, const double distance)
+{
     // Traverse the (normalized) normal to a sample point.
-    QVector2D sample = (point + distance * normal);
-    sample[0] = int(sample[0]);
-    sample[1] = int(sample[1]);
+    const QVector2D sample = point + distance * normal;
+    const int x = int(sample.x());
+    const int y = int(sample.y());
 
     // Check that the sample point is inside the image.
-    bool xOutOfBounds = sample.x() < 0 || sample.x() >= width;
-    bool yOutOfBounds = sample.y() < 0 || sample.y() >= height;
-    if (xOutOfBounds || yOutOfBounds)
+    if (x < 0 || x >= image.cols || y < 0 || y >= image.rows)
     {
-        // Return null to signify that no colour could be sampled here.
-        return;
+        return false;
     }
 
-    auto color = &image.at<cv::Vec3b>(sample.y(), sample.x());
+    const cv::Vec3b& pixel = image.at<cv::Vec3b>(y, x);
+    color = QVector4D(pixel[2] / 255.0f, pixel[1] / 255.0f, pixel[0] / 255.0f, 1.0f);
 
-    if (color != nullptr)
-    {
-        // Colour sample is valid.;
-        const auto color4d = QVector4D(int(color->val[2]) / 255.0f, int(color->val[1]) / 255.0f, int(color->val[0]) / 255.0f, 1.0);
-        curve->AddColorPoint(type, color4d, parameter);
-    }
+    return true;
 }
 
 void DiffusionCurveRenderer::ColorSampler::Reset()
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Curve/Spline.h"
+#include "Util/Macros.h"
 #include "Vectorization/Stages/Base/VectorizationStageBase.h"
 
 #include <QRandomGenerator>
@@ -15,15 +16,37 @@ namespace DiffusionCurveRenderer
       public:
         explicit ColorSampler(QObject* parent);
 
+        // Curves are sampled in parallel. Every curve draws its random parameters from its own generator, seeded
+        // with Seed and the index of the curve, so the colors do not depend on the thread count or on timing and
+        // are identical to those of a single-threaded run.
         void Run(const QVector<CurvePtr>& curves, cv::Mat& image, cv::Mat& imageLab, const double sampleDensity);
 
         void Reset() override;
 
-      private:
-        void Sample(BezierPtr bezier, cv::Mat& image, cv::Mat& imageLab, const double sampleDensity);
-        void SampleAlongNormal(CurvePtr curve, float parameter, ColorPointType type, cv::Mat& image, cv::Mat& imageLab, const double distance = 3.0);
+        DEFINE_MEMBER(quint32, Seed, 0);
 
       private:
-        QRandomGenerator mRandomGenerator;
+        /*
+         * Samples both sides of <bezier> at its ends, at its middle and once per
+         * stratum of equal arc length, at a random position within the stratum.
+         * Positions and normals of all samples are evaluated in one batch and
+         * the color points are added at once.
+         */
+        void Sample(BezierPtr bezier, QRandomGenerator& generator, const cv::Mat& image, const double sampleDensity);
+
+        /*
+         * Returns the parameter at which the curve is <arcLength> long, by linear
+         * interpolation in <lengths>, the arc lengths at evenly spaced parameters.
+         */
+        static float ParameterAt(const QVector<float>& lengths, float arcLength);
+
+        /*
+         * Reads the color <distance> pixels away from <point> along <normal>.
+         * Returns false if that pixel is outside of the image.
+         */
+        static bool SampleAlongNormal(const QVector2D& point, const QVector2D& normal, const cv::Mat& image, QVector4D& color, const double distance = 3.0);
+
+        // Intervals of the arc length table of a curve, as many as CalculateLength() uses
+        static constexpr int LENGTH_INTERVALS = 100;
     };
 }
@@ -0,0 +1,224 @@
+#include "ComponentEdgeTracer.h"
+
+#include "Util/Parallel.h"
+#include "Vectorization/Stages/EdgeTracer/EdgeTracer.h"
+
+#include <QBitArray>
+#include <QHash>
+#include <algorithm>
+#include <utility>
+
+DiffusionCurveRenderer::ComponentEdgeTracer::ComponentEdgeTracer(QObject* parent)
+    : VectorizationStageBase(parent)
+{
+}
+
+/*
+ * Returns the same chains as EdgeTracer, computed in parallel.
+ *
+ * 8-connected components of edge pixels are labeled with union-find,
+ * in parallel over horizontal bands whose borders are merged
+ * afterwards. Chains only ever merge with chains of their own
+ * component, so every component is traced independently on the
+ * thread pool. Chains are ordered by the pixel they were started
+ * from, as EdgeTracer returns them.
+ *
+ * Edges of length less than <lengthThreshold> are discarded.
+ *
+ * param edges: Black-and-white image, where edges are identified by white pixels.
+ * param lengthThreshold: Minimum length required for an edge to be returned.
+ */
+void DiffusionCurveRenderer::ComponentEdgeTracer::Run(cv::Mat edges, int lengthThreshold)
+{
+    const int width = edges.cols;
+    const int height = edges.rows;
+
+    // Set of every edge pixel, indexed by y * width + x. Background pixels
+    // are never read.
+    std::vector<int> parents(width * height);
+
+    const int bandHeight = std::max(16, height / (4 * Parallel::GetThreadCount()));
+
+    // Label the components within every band. Unions only touch pixels of
+    // the band, so bands do not interfere.
+    Parallel::For(height, bandHeight, [&](int begin, int end) {
+        for (int y = begin; y < end; y++)
+        {
+            const uchar* row = edges.ptr<uchar>(y);
+            const uchar* previousRow = y > begin ? edges.ptr<uchar>(y - 1) : nullptr;
+
+            for (int x = 0; x < width; x++)
+            {
+                if (row[x] == 0)
+                {
+                    continue;
+                }
+
+                const int pixel = y * width + x;
+                parents[pixel] = pixel;
+
+                if (x > 0 && row[x - 1] != 0)
+                {
+                    Union(parents, pixel, pixel - 1);
+                }
+
+                if (previousRow == nullptr)
+                {
+                    continue;
+                }
+
+                for (int dx = -1; dx <= 1; dx++)
+                {
+                    if (x + dx >= 0 && x + dx < width && previousRow[x + dx] != 0)
+                    {
+                        Union(parents, pixel, pixel - width + dx);
+                    }
+                }
+            }
+        }
+    });
+
+    // Merge the components across the borders of the bands.
+    for (int y = bandHeight; y < height; y += bandHeight)
+    {
+        const uchar* row = edges.ptr<uchar>(y);
+        const uchar* previousRow = edges.ptr<uchar>(y - 1);
+
+        for (int x = 0; x < width; x++)
+        {
+            if (row[x] == 0)
+            {
+                continue;
+            }
+
+            for (int dx = -1; dx <= 1; dx++)
+            {
+                if (x + dx >= 0 && x + dx < width && previousRow[x + dx] != 0)
+                {
+                    Union(parents, y * width + x, (y - 1) * width + x + dx);
+                }
+            }
+        }
+    }
+
+    ReportProgress(0.2f);
+
+    // Gives fast access to edge pixels.
+    std::vector<cv::Point> nonZeros;
+    cv::findNonZero(edges, nonZeros);
+
+    // Seeds of every component in scan order, as EdgeTracer visits them.
+    std::vector<std::vector<cv::Point>> components;
+    QHash<int, int> componentOfRoot;
+
+    for (const auto& point : nonZeros)
+    {
+        const int root = Find(parents, point.y * width + point.x);
+        const auto it = componentOfRoot.constFind(root);
+
+        if (it == componentOfRoot.cend())
+        {
+            componentOfRoot.insert(root, components.size());
+            components.push_back({ point });
+        }
+        else
+        {
+            components[it.value()].push_back(point);
+        }
+    }
+
+    ReportProgress(0.3f);
+
+    // Chains of every component, keyed by the scan index of their first pixel.
+    std::vector<std::vector<std::pair<int, PixelChain>>> componentChains(components.size());
+
+    const int nComponents = components.size();
+    const int grain = std::max(1, nComponents / (8 * Parallel::GetThreadCount()));
+
+    Parallel::For(nComponents, grain, [&](int begin, int end) {
+        QBitArray visited(width * height);
+        std::vector<int> chainSeeds;
+
+        for (int i = begin; i < end && !IsCancelled(); i++)
+        {
+            const auto& seeds = components[i];
+
+            chainSeeds.clear();
+            std::vector<PixelChain> chains = EdgeTracer::Trace(edges, seeds, visited, &chainSeeds);
+
+            for (int j = 0; j < int(chains.size()); j++)
+            {
+                const cv::Point seed = seeds[chainSeeds[j]];
+                componentChains[i].emplace_back(seed.y * width + seed.x, chains[j]);
+            }
+
+            // Every pixel of the component has been visited, clear them for the next one
+            for (const auto& seed : seeds)
+            {
+                visited.clearBit(seed.y * width + seed.x);
+            }
+        }
+    });
+
+    ReportProgress(0.9f);
+
+    std::vector<std::pair<int, PixelChain>> chains;
+
+    for (auto& component : componentChains)
+    {
+        for (auto& chain : component)
+        {
+            chains.push_back(std::move(chain));
+        }
+    }
+
+    std::sort(chains.begin(), chains.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    // Only keep chains that are at least as long as the threshold.
+    for (auto& candidate : chains)
+    {
+        if (candidate.second.GetLength() >= lengthThreshold)
+        {
+            mChains.push_back(candidate.second);
+        }
+    }
+
+    ReportProgress(1.0f);
+    emit Finished();
+}
+
+const QList<DiffusionCurveRenderer::PixelChain>& DiffusionCurveRenderer::ComponentEdgeTracer::GetChains() const
+{
+    return mChains;
+}
+
+void DiffusionCurveRenderer::ComponentEdgeTracer::Reset()
+{
+    mChains.clear();
+}
+
+int DiffusionCurveRenderer::ComponentEdgeTracer::Find(std::vector<int>& parents, int pixel)
+{
+    while (parents[pixel] != pixel)
+    {
+        parents[pixel] = parents[parents[pixel]];
+        pixel = parents[pixel];
+    }
+
+    return pixel;
+}
+
+void DiffusionCurveRenderer::ComponentEdgeTracer::Union(std::vector<int>& parents, int a, int b)
+{
+    a = Find(parents, a);
+    b = Find(parents, b);
+
+    if (a < b)
+    {
+        parents[b] = a;
+    }
+    else if (b < a)
+    {
+        parents[a] = b;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Vectorization/Stages/Base/PixelChain.h"
+#include "Vectorization/Stages/Base/VectorizationStageBase.h"
+
+#include <QList>
+#include <opencv2/core.hpp>
+#include <opencv2/core/mat.hpp>
+#include <vector>
+
+namespace DiffusionCurveRenderer
+{
+    class ComponentEdgeTracer : public VectorizationStageBase
+    {
+      public:
+        explicit ComponentEdgeTracer(QObject* parent);
+
+        /*
+         * Returns the same chains as EdgeTracer, computed in parallel.
+         *
+         * 8-connected components of edge pixels are labeled with union-find,
+         * in parallel over horizontal bands whose borders are merged
+         * afterwards. Chains only ever merge with chains of their own
+         * component, so every component is traced independently on the
+         * thread pool. Chains are ordered by the pixel they were started
+         * from, as EdgeTracer returns them.
+         *
+         * Edges of length less than <lengthThreshold> are discarded.
+         *
+         * param edges: Black-and-white image, where edges are identified by white pixels.
+         * param lengthThreshold: Minimum length required for an edge to be returned.
+         */
+        void Run(cv::Mat edges, int lengthThreshold);
+
+        const QList<PixelChain>& GetChains() const;
+
+        void Reset() override;
+
+      private:
+        /*
+         * Returns the root of the set of <pixel>, halving the path on the way.
+         */
+        static int Find(std::vector<int>& parents, int pixel);
+
+        /*
+         * Merges the sets of pixels <a> and <b>. The smaller root becomes
+         * the root of both, so the labels do not depend on the order of
+         * the merges.
+         */
+        static void Union(std::vector<int>& parents, int a, int b);
+
+        QList<PixelChain> mChains;
+    };
+}
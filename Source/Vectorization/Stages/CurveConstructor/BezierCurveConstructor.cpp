@@ -1,5 +1,7 @@
 #include "BezierCurveConstructor.h"
 
+#include "Util/Parallel.h"
+
 #include <QDebug>
 
 DiffusionCurveRenderer::BezierCurveConstructor::BezierCurveConstructor(QObject* parent)
@@ -8,52 +10,71 @@ DiffusionCurveRenderer::BezierCurveConstructor::BezierCurveConstructor(QObject*
 }
 
 void DiffusionCurveRenderer::BezierCurveConstructor::Run(const QVector<QVector<Point>>& polylines)
+{
+    const int nPolylines = polylines.size();
+
+    QVector<QVector<CurvePtr>> curves(nPolylines);
+
+    // Polylines are independent, the longest ones are started first.
+    Parallel::ForLargestFirst(
+        nPolylines,
+        [&](int i) { return qint64(polylines[i].size()); },
+        [&](int i) {
+            if (!IsCancelled())
+                curves[i] = ConstructCurves(polylines[i]);
+        },
+        [&](int finished) { ReportProgress(float(finished) / nPolylines); });
+
+    // In the order of the polylines, whichever thread constructed them
+    for (const auto& curvesOfPolyline : curves)
+    {
+        mCurves << curvesOfPolyline;
+    }
+
+    emit Finished();
+}
+
+QVector<DiffusionCurveRenderer::CurvePtr> DiffusionCurveRenderer::BezierCurveConstructor::ConstructCurves(const QVector<Point>& polyline)
 {
     constexpr int NUMBER_OF_POINTS_PER_POLYLINE = 8;
-    const auto nPolylines = polylines.size();
+    const auto nPoints = polyline.size();
 
-    for (int i = 0; i < nPolylines; i++)
-    {
-        const auto& polyline = polylines.at(i);
-        const auto nPoints = polyline.size();
+    QVector<CurvePtr> curves;
 
-        if (nPoints > NUMBER_OF_POINTS_PER_POLYLINE)
+    if (nPoints > NUMBER_OF_POINTS_PER_POLYLINE)
+    {
+        const auto numberOfSmallerSegments = nPoints / NUMBER_OF_POINTS_PER_POLYLINE + 1;
+        for (int indexOfSmallerSegments = 0; indexOfSmallerSegments < numberOfSmallerSegments; ++indexOfSmallerSegments)
         {
-            const auto numberOfSmallerSegments = nPoints / NUMBER_OF_POINTS_PER_POLYLINE + 1;
-            for (int indexOfSmallerSegments = 0; indexOfSmallerSegments < numberOfSmallerSegments; ++indexOfSmallerSegments)
-            {
-                QVector<Point> smaller;
+            QVector<Point> smaller;
 
-                for (int j = 0; j < NUMBER_OF_POINTS_PER_POLYLINE; j++)
+            for (int j = 0; j < NUMBER_OF_POINTS_PER_POLYLINE; j++)
+            {
+                const auto indexOfPoint = NUMBER_OF_POINTS_PER_POLYLINE * indexOfSmallerSegments + j;
+                if (indexOfPoint >= polyline.size())
                 {
-                    const auto indexOfPoint = NUMBER_OF_POINTS_PER_POLYLINE * indexOfSmallerSegments + j;
-                    if (indexOfPoint >= polyline.size())
+                    if (smaller.size() == 1)
                     {
-                        if (smaller.size() == 1)
-                        {
-                            smaller.append(polyline.at(indexOfPoint - 2));
-                        }
-                        break;
+                        smaller.append(polyline.at(indexOfPoint - 2));
                     }
-
-                    smaller.append(polyline.at(indexOfPoint));
+                    break;
                 }
 
-                if (CurvePtr curve = ConstructCurve(smaller))
-                {
-                    mCurves << curve;
-                }
+                smaller.append(polyline.at(indexOfPoint));
             }
-        }
-        else if (CurvePtr curve = ConstructCurve(polyline))
-        {
-            mCurves << curve;
-        }
 
-        emit ProgressChanged(float(i) / (nPolylines - 1));
+            if (CurvePtr curve = ConstructCurve(smaller))
+            {
+                curves << curve;
+            }
+        }
+    }
+    else if (CurvePtr curve = ConstructCurve(polyline))
+    {
+        curves << curve;
     }
 
-    emit Finished();
+    return curves;
 }
 
 DiffusionCurveRenderer::CurvePtr DiffusionCurveRenderer::BezierCurveConstructor::ConstructCurve(const QVector<Point>& polyline, double tension)
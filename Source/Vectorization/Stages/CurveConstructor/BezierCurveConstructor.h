@@ -18,6 +18,8 @@ namespace DiffusionCurveRenderer
         void Reset() override;
 
       private:
+        // Splits long polylines into curves of at most 8 points
+        QVector<CurvePtr> ConstructCurves(const QVector<Point>& polyline);
         CurvePtr ConstructCurve(const QVector<Point>& polyline, double tension = 2.0);
 
       private:
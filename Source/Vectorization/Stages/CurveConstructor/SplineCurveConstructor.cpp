@@ -1,5 +1,7 @@
 #include "SplineCurveConstructor.h"
 
+#include "Util/Parallel.h"
+
 #include <QDebug>
 
 DiffusionCurveRenderer::SplineCurveConstructor::SplineCurveConstructor(QObject* parent)
@@ -9,15 +11,27 @@ DiffusionCurveRenderer::SplineCurveConstructor::SplineCurveConstructor(QObject*
 
 void DiffusionCurveRenderer::SplineCurveConstructor::Run(const QVector<QVector<Point>>& polylines)
 {
-    for (int i = 0; i < polylines.size(); i++)
+    const int nPolylines = polylines.size();
+
+    QVector<CurvePtr> curves(nPolylines);
+
+    // Polylines are independent, the longest ones are started first.
+    Parallel::ForLargestFirst(
+        nPolylines,
+        [&](int i) { return qint64(polylines[i].size()); },
+        [&](int i) {
+            if (!IsCancelled())
+                curves[i] = ConstructCurve(polylines[i]);
+        },
+        [&](int finished) { ReportProgress(float(finished) / nPolylines); });
+
+    // In the order of the polylines, whichever thread constructed them
+    for (const auto& curve : curves)
     {
-        if (CurvePtr curve = ConstructCurve(polylines.at(i)))
+        if (curve)
         {
             mCurves << curve;
         }
-
-        float progress = float(i) / (polylines.size() - 1);
-        emit ProgressChanged(progress);
     }
 }
 
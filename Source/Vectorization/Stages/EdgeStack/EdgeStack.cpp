@@ -1,18 +1,29 @@
 #include "EdgeStack.h"
 
+#include "Util/Logger.h"
+#include "Util/Parallel.h"
+
 #include "opencv2/imgproc/imgproc.hpp"
 
+#include <QMutexLocker>
+#include <QVector>
+#include <algorithm>
+
 DiffusionCurveRenderer::EdgeStack::EdgeStack(QObject* parent)
     : VectorizationStageBase(parent)
 {
 }
 
 /**
- * Creates a stack of edge images from a Gaussian scale space.
+ * Prepares a stack of edge images from a Gaussian scale space.
+ *
+ * Runs Canny edge detection on an image of the Gaussian stack when
+ * its layer is first requested. Edge detection uses low and high
+ * thresholds as specified by parameters.
  *
- * Runs Canny edge detection on each image in the Gaussian stack.
- * Edge detection uses low and high thresholds as specified by
- * parameters.
+ * Previously every layer was computed here to drop the layers above
+ * the first one without edge pixels. Those layers are kept now, they
+ * show an empty edge image.
  *
  * param stack: A stack of images from a Gaussian scale space.
  * param lowThreshold: Low edge strength threshold for Canny edges.
@@ -20,62 +31,243 @@ DiffusionCurveRenderer::EdgeStack::EdgeStack(QObject* parent)
  */
 void DiffusionCurveRenderer::EdgeStack::Run(GaussianStack* stack, double lowThreshold, double highThreshold)
 {
-    int stackHeight = stack->GetHeight();
+    QMutexLocker locker(&mMutex);
+
+    this->mLevels.clear();
+    this->mStack = stack;
+    this->mLowThreshold = lowThreshold;
+    this->mHighThreshold = highThreshold;
+    this->mGeneration++;
 
-    // Meaningless, nonzero initial value for number of detected edge pixels.
-    int nonzeros = 1;
+    ReportProgress(1.0f);
+    emit Finished();
+}
+
+/*
+ * Returns the number of levels in the edge stack, the height of the
+ * Gaussian stack. The top levels may have no edge pixels.
+ */
+int DiffusionCurveRenderer::EdgeStack::GetHeight()
+{
+    QMutexLocker locker(&mMutex);
+
+    return this->mStack ? this->mStack->GetHeight() : 0;
+}
+
+/*
+ * Returns the image of edges at the <layer>'th layer, computing it
+ * if it was not requested before. Returns an empty matrix if the
+ * stack has no such layer, e.g. because it was reset meanwhile.
+ * <generation> receives the generation the edges belong to, or -1 if
+ * the stack was run or reset while they were computed.
+ *
+ * The stack, the thresholds and the generation are copied under the
+ * lock, so a Run() or Reset() on another thread while the layer is
+ * computed cannot mix two images or store a stale layer.
+ */
+cv::Mat DiffusionCurveRenderer::EdgeStack::GetLayer(int layer, int* generation)
+{
+    GaussianStack* stack;
+    double lowThreshold, highThreshold;
+    int current;
 
-    for (int layer = 0; layer < stackHeight && nonzeros > 0; layer++)
     {
-        float progress = float(layer) / float(stackHeight - 1);
-        emit ProgressChanged(progress);
+        QMutexLocker locker(&mMutex);
 
-        cv::Mat image = stack->GetLayer(layer);
+        current = this->mGeneration;
 
-        cv::Mat edges;
-        cv::Canny(image, edges, lowThreshold, highThreshold);
+        if (generation)
+        {
+            *generation = current;
+        }
 
-        this->mLevels.push_back(edges);
+        const auto it = this->mLevels.find(layer);
 
-        nonzeros = cv::countNonZero(edges);
+        if (it != this->mLevels.end())
+        {
+            return it->second;
+        }
+
+        stack = this->mStack;
+        lowThreshold = this->mLowThreshold;
+        highThreshold = this->mHighThreshold;
     }
 
-    if (nonzeros == 0)
+    if (stack == nullptr)
     {
-        // Remove the top level if it had no detectable edge pixels.
-        this->mLevels.pop_back();
+        return cv::Mat();
     }
 
-    // @berkbavas: Do we really need this?
-    // Trim any blurred images from the Gaussian stack beyond the point
-    // where edges stopped being detectable.
-    // int edgeHeight = this->GetHeight();
+    // Not locked while computing, other levels can be computed meanwhile
+    cv::Mat image = stack->GetLayer(layer);
 
-    // if (edgeHeight < stackHeight)
-    // {
-    //     stack->Restrict(edgeHeight);
-    // }
+    if (image.empty())
+    {
+        return cv::Mat();
+    }
 
-    emit Finished();
+    cv::Mat edges;
+    cv::Canny(image, edges, lowThreshold, highThreshold);
+
+    QMutexLocker locker(&mMutex);
+
+    if (current == this->mGeneration)
+    {
+        this->mLevels[layer] = edges;
+    }
+    else if (generation)
+    {
+        *generation = -1;
+    }
+
+    return edges;
 }
 
 /*
- * Returns the number of levels in the edge stack.
+ * Returns true if the <layer>'th layer was computed or set before.
  */
-int DiffusionCurveRenderer::EdgeStack::GetHeight()
+bool DiffusionCurveRenderer::EdgeStack::HasLayer(int layer)
+{
+    QMutexLocker locker(&mMutex);
+
+    return this->mLevels.count(layer) != 0;
+}
+
+/*
+ * Stores <edges> as the <layer>'th layer, e.g. edges of the same
+ * image and thresholds loaded from a cache. Returns false without
+ * storing them if the stack is no longer at <generation>.
+ */
+bool DiffusionCurveRenderer::EdgeStack::SetLayer(int layer, cv::Mat edges, int generation)
 {
-    return this->mLevels.size();
+    QMutexLocker locker(&mMutex);
+
+    if (generation != this->mGeneration)
+    {
+        return false;
+    }
+
+    this->mLevels[layer] = edges;
+
+    return true;
 }
 
 /*
- * Returns the image of edges at the <layer>'th layer.
+ * Returns the generation of the stack, it changes with every Run()
+ * and Reset().
  */
-cv::Mat DiffusionCurveRenderer::EdgeStack::GetLayer(int layer)
+int DiffusionCurveRenderer::EdgeStack::GetGeneration()
 {
-    return this->mLevels.at(layer);
+    QMutexLocker locker(&mMutex);
+
+    return this->mGeneration;
+}
+
+/*
+ * Computes the levels in [<first>, <last>] that were not requested
+ * yet. Canny levels are independent and run in parallel, in batches
+ * of as many levels as there are threads.
+ *
+ * Without <cancelled> it stops with the vectorization token and
+ * reports progress. Prefetches in the background pass their own
+ * <cancelled>, polled between batches, and emit nothing. The
+ * vectorization token belongs to the vectorization thread, a load or
+ * a cancel there must not stop a prefetch the GUI is waiting for.
+ *
+ * The Gaussian layers of a batch are computed one after another, each
+ * of them band-parallel, since every layer is blurred from the one
+ * below. Only one batch of blurred images is held at a time.
+ */
+void DiffusionCurveRenderer::EdgeStack::Precompute(int first, int last, const std::function<bool()>& cancelled)
+{
+    const int batchSize = Parallel::GetThreadCount();
+    const bool reportProgress = !cancelled;
+    const auto stop = [&]() { return cancelled ? cancelled() : IsCancelled(); };
+
+    GaussianStack* stack;
+    double lowThreshold, highThreshold;
+    int generation;
+
+    {
+        QMutexLocker locker(&mMutex);
+
+        stack = this->mStack;
+        lowThreshold = this->mLowThreshold;
+        highThreshold = this->mHighThreshold;
+        generation = this->mGeneration;
+    }
+
+    for (int begin = first; begin <= last && stack && !stop(); begin += batchSize)
+    {
+        const int end = std::min(last + 1, begin + batchSize);
+
+        QVector<int> layers;
+
+        {
+            QMutexLocker locker(&mMutex);
+
+            if (generation != this->mGeneration)
+            {
+                break;
+            }
+
+            for (int layer = begin; layer < end; ++layer)
+            {
+                if (this->mLevels.count(layer) == 0)
+                {
+                    layers.push_back(layer);
+                }
+            }
+        }
+
+        QVector<cv::Mat> images;
+
+        for (const int layer : layers)
+        {
+            images.push_back(stack->GetLayer(layer));
+        }
+
+        QVector<cv::Mat> edges(layers.size());
+
+        Parallel::For(int(layers.size()), 1, [&](int from, int to) {
+            for (int i = from; i < to; ++i)
+            {
+                if (!images[i].empty())
+                {
+                    cv::Canny(images[i], edges[i], lowThreshold, highThreshold);
+                }
+            }
+        });
+
+        {
+            QMutexLocker locker(&mMutex);
+
+            for (int i = 0; i < layers.size() && generation == this->mGeneration; ++i)
+            {
+                if (!edges[i].empty())
+                {
+                    this->mLevels[layers[i]] = edges[i];
+                }
+            }
+        }
+
+        if (reportProgress)
+        {
+            ReportProgress(float(end - first) / float(last - first + 1));
+        }
+    }
+
+    if (reportProgress)
+    {
+        emit Finished();
+    }
 }
 
 void DiffusionCurveRenderer::EdgeStack::Reset()
 {
+    QMutexLocker locker(&mMutex);
+
     this->mLevels.clear();
-}
\ No newline at end of file
+    this->mStack = nullptr;
+    this->mGeneration++;
+}
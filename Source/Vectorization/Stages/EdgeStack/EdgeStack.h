@@ -2,7 +2,9 @@
 
 #include "Vectorization/Stages/GaussianStack/GaussianStack.h"
 
-#include <QVector>
+#include <QMutex>
+#include <functional>
+#include <map>
 #include <opencv2/core/mat.hpp>
 
 namespace DiffusionCurveRenderer
@@ -11,19 +13,39 @@ namespace DiffusionCurveRenderer
     {
       private:
         /*
-         * A vector of edge images of increasingly Gaussian-blurred images.
+         * Edge images of increasingly Gaussian-blurred images computed so far,
+         * keyed by layer.
          */
-        std::vector<cv::Mat> mLevels;
+        std::map<int, cv::Mat> mLevels;
+
+        /*
+         * The Gaussian stack and the Canny thresholds the edges are computed with.
+         */
+        GaussianStack* mStack{ nullptr };
+        double mLowThreshold{ 0.0 };
+        double mHighThreshold{ 0.0 };
+
+        /*
+         * Incremented by Run() and Reset(). Layers are computed without the
+         * lock, those of an earlier generation are returned but not stored.
+         */
+        int mGeneration{ 0 };
+
+        /*
+         * Layers are requested from the vectorization thread and from the
+         * thread pool that prepares the layers displayed by the GUI.
+         */
+        QMutex mMutex;
 
       public:
         explicit EdgeStack(QObject* parent);
 
         /**
-         * Creates a stack of edge images from a Gaussian scale space.
+         * Prepares a stack of edge images from a Gaussian scale space.
          *
-         * Runs Canny edge detection on each image in the Gaussian stack.
-         * Edge detection uses low and high thresholds as specified by
-         * parameters.
+         * Runs Canny edge detection on an image of the Gaussian stack when
+         * its layer is first requested. Edge detection uses low and high
+         * thresholds as specified by parameters.
          *
          * param stack: A stack of images from a Gaussian scale space.
          * param lowThreshold: Low edge strength threshold for Canny edges.
@@ -32,14 +54,48 @@ namespace DiffusionCurveRenderer
         void Run(GaussianStack* stack, double lowThreshold, double highThreshold);
 
         /*
-         *  Returns the number of levels in the edge stack.
+         *  Returns the number of levels in the edge stack, the height of the
+         *  Gaussian stack. The top levels may have no edge pixels.
          */
         int GetHeight();
 
         /*
-         *  Returns the image of edges at the <layer>'th layer.
+         *  Returns the image of edges at the <layer>'th layer, computing it
+         *  if it was not requested before. Returns an empty matrix if the
+         *  stack has no such layer, e.g. because it was reset meanwhile.
+         *  <generation> receives the generation the edges belong to, or -1
+         *  if the stack was run or reset while they were computed.
+         */
+        cv::Mat GetLayer(int layer, int* generation = nullptr);
+
+        /*
+         *  Returns true if the <layer>'th layer was computed or set before.
+         */
+        bool HasLayer(int layer);
+
+        /*
+         *  Stores <edges> as the <layer>'th layer, e.g. edges of the same
+         *  image and thresholds loaded from a cache. Returns false without
+         *  storing them if the stack is no longer at <generation>.
+         */
+        bool SetLayer(int layer, cv::Mat edges, int generation);
+
+        /*
+         *  Returns the generation of the stack, it changes with every Run()
+         *  and Reset().
+         */
+        int GetGeneration();
+
+        /*
+         *  Computes the levels in [<first>, <last>] that were not requested
+         *  yet. Canny levels are independent and run in parallel, in batches
+         *  of as many levels as there are threads.
+         *
+         *  Without <cancelled> it stops with the vectorization token and
+         *  reports progress. Prefetches in the background pass their own
+         *  <cancelled>, polled between batches, and emit nothing.
          */
-        cv::Mat GetLayer(int layer);
+        void Precompute(int first, int last, const std::function<bool()>& cancelled = nullptr);
 
         void Reset() override;
     };
@@ -1,6 +1,9 @@
 #include "EdgeTracer.h"
 
-#include <Eigen/SparseCore>
+#include <QBitArray>
+#include <QMultiHash>
+#include <algorithm>
+#include <vector>
 
 DiffusionCurveRenderer::EdgeTracer::EdgeTracer(QObject* parent)
     : VectorizationStageBase(parent)
@@ -20,30 +23,114 @@ DiffusionCurveRenderer::EdgeTracer::EdgeTracer(QObject* parent)
  * param lengthThreshold: Minimum length required for an edge to be returned.
  */
 void DiffusionCurveRenderer::EdgeTracer::Run(cv::Mat edges, int lengthThreshold)
+{
+    // Bits denoting which edges have already been included in a pixel chain.
+    QBitArray visited(edges.cols * edges.rows);
+
+    // Gives fast access to edge pixels.
+    std::vector<cv::Point> nonZeros;
+    cv::findNonZero(edges, nonZeros);
+
+    std::vector<PixelChain> chains = Trace(
+        edges, nonZeros, visited, nullptr, [this](float progress) { ReportProgress(progress); }, [this]() { return IsCancelled(); });
+
+    ReportProgress(1.0f);
+
+    // Only keep chains that are at least as long as the threshold.
+    for (auto& candidate : chains)
+    {
+        if (candidate.GetLength() >= lengthThreshold)
+        {
+            mChains.push_back(candidate);
+        }
+    }
+
+    emit Finished();
+}
+
+/*
+ * Traces chains of edge pixels starting at <seeds>, in order, and
+ * merges every new chain into the existing chains it touches.
+ *
+ * Pixels set in <visited> are skipped, traced pixels are set. For
+ * every chain, the index of the seed it was started from is written
+ * to <chainSeeds> if it is not null.
+ *
+ * Tracing stops early with the chains so far once <cancelled>
+ * returns true, it is polled as often as <progress> is called.
+ */
+std::vector<DiffusionCurveRenderer::PixelChain> DiffusionCurveRenderer::EdgeTracer::Trace(const cv::Mat& edges,
+                                                                                          const std::vector<cv::Point>& seeds,
+                                                                                          QBitArray& visited,
+                                                                                          std::vector<int>* chainSeeds,
+                                                                                          const std::function<void(float)>& progress,
+                                                                                          const std::function<bool()>& cancelled)
 {
     const int width = edges.cols;
     const int height = edges.rows;
-    const int nEdgePixels = cv::countNonZero(edges);
 
-    // Matrix denoting which edges have already been included in a pixel chain.
-    Eigen::SparseMatrix<int> visited(width, height);
-
-    // Matrix giving fast access to edge pixels.
-    cv::Mat nonZeros;
-    cv::findNonZero(edges, nonZeros);
+    const int nSeeds = seeds.size();
+    const int progressStep = std::max(1, nSeeds / 100);
 
     std::vector<PixelChain> growingChains;
 
-    for (int i = 0; i < nEdgePixels; i++)
+    // Chains whose head or tail is at a pixel, keyed by y * width + x.
+    QMultiHash<int, int> endpoints;
+
+    const auto addEndpoints = [&](int chain) {
+        const Point head = growingChains[chain].GetHead();
+        const Point tail = growingChains[chain].GetTail();
+
+        endpoints.insert(int(head.y) * width + int(head.x), chain);
+        endpoints.insert(int(tail.y) * width + int(tail.x), chain);
+    };
+
+    const auto removeEndpoints = [&](int chain) {
+        const Point head = growingChains[chain].GetHead();
+        const Point tail = growingChains[chain].GetTail();
+
+        endpoints.remove(int(head.y) * width + int(head.x), chain);
+        endpoints.remove(int(tail.y) * width + int(tail.x), chain);
+    };
+
+    // Appends the chains with an endpoint within one pixel of <point>.
+    const auto findNeighbouringChains = [&](Point point, std::vector<int>& chains) {
+        const int col = point.x;
+        const int row = point.y;
+
+        for (int x = std::max(col - 1, 0); x <= std::min(col + 1, width - 1); x++)
+        {
+            for (int y = std::max(row - 1, 0); y <= std::min(row + 1, height - 1); y++)
+            {
+                for (auto it = endpoints.constFind(y * width + x); it != endpoints.cend() && it.key() == y * width + x; ++it)
+                {
+                    chains.push_back(it.value());
+                }
+            }
+        }
+    };
+
+    std::vector<int> candidates;
+
+    for (int i = 0; i < nSeeds; i++)
     {
-        float progress = float(i) / (nEdgePixels - 1);
+        if (i % progressStep == 0)
+        {
+            if (progress)
+            {
+                progress(float(i) / nSeeds);
+            }
 
-        emit ProgressChanged(progress);
+            if (cancelled && cancelled())
+            {
+                break;
+            }
+        }
 
-        int row = nonZeros.at<cv::Point>(i).y;
-        int col = nonZeros.at<cv::Point>(i).x;
+        int row = seeds[i].y;
+        int col = seeds[i].x;
 
-        if (visited.coeffRef(col, row) != 0)
+        if (visited.testBit(row * width + col))
         {
             // Skip pixels that have already been used in an edge, to avoid
             // double-counting.
@@ -58,7 +145,7 @@ void DiffusionCurveRenderer::EdgeTracer::Run(cv::Mat edges, int lengthThreshold)
         do
         {
             points.Append(Point(col, row));
-            visited.coeffRef(col, row) = 1;
+            visited.setBit(row * width + col);
 
             // The neighbourhood consists of pixels within one space of the
             // current pixel.
@@ -77,7 +164,7 @@ void DiffusionCurveRenderer::EdgeTracer::Run(cv::Mat edges, int lengthThreshold)
                 {
                     uchar pixelValue = edges.at<uchar>(y, x);
 
-                    if (pixelValue != 0 && visited.coeffRef(x, y) == 0.0)
+                    if (pixelValue != 0 && !visited.testBit(y * width + x))
                     {
                         // Note down the new pixel and stop looking.
                         row = y;
@@ -88,62 +175,70 @@ void DiffusionCurveRenderer::EdgeTracer::Run(cv::Mat edges, int lengthThreshold)
             }
         } while (neighborFound);
 
-        bool newChain = true;
+        const Point newcomerHead = points.GetHead();
+        const Point newcomerTail = points.GetTail();
+
+        // Every existing chain with an end next to an end of this one gets a
+        // copy of it, as the scan over all chains this replaces did. Only the
+        // endpoints of a chain decide how it is extended, so the order the
+        // chains are visited in does not matter.
+        candidates.clear();
+        findNeighbouringChains(newcomerHead, candidates);
+        findNeighbouringChains(newcomerTail, candidates);
+
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        if (candidates.empty())
+        {
+            growingChains.push_back(points);
+            addEndpoints(int(growingChains.size()) - 1);
+
+            if (chainSeeds)
+            {
+                chainSeeds->push_back(i);
+            }
+
+            continue;
+        }
+
+        const PixelChain reversed = points.Reversed();
 
-        // Look for any existing chains that connect to this one, and merge
-        // them into one longer chain.
-        for (int j = 0; j < growingChains.size(); j++)
+        for (const int j : candidates)
         {
-            Point chainHead = growingChains.at(j).GetHead();
-            Point chainTail = growingChains.at(j).GetTail();
+            PixelChain& chain = growingChains[j];
 
-            Point newcomerHead = points.GetHead();
-            Point newcomerTail = points.GetTail();
+            Point chainHead = chain.GetHead();
+            Point chainTail = chain.GetTail();
+
+            removeEndpoints(j);
 
             if (chainTail.IsNeighbour(newcomerHead))
             {
                 // Insert the new chain at the end of the old chain.
-                growingChains.at(j).InsertBack(points);
-                newChain = false;
+                chain.InsertBack(points);
             }
             else if (chainTail.IsNeighbour(newcomerTail))
             {
                 // Insert the new chain backwards at the end of the old chain.
-                growingChains.at(j).InsertBack(points.Reversed());
-                newChain = false;
+                chain.InsertBack(reversed);
             }
             else if (chainHead.IsNeighbour(newcomerTail))
             {
                 // Insert the new chain at the front of the old one.
-                growingChains.at(j).InsertFront(points);
-                newChain = false;
+                chain.InsertFront(points);
             }
             else if (chainHead.IsNeighbour(newcomerHead))
             {
                 // Insert the new chain backwards at the front of the old one.
-                growingChains.at(j).InsertFront(points.Reversed());
-                newChain = false;
+                chain.InsertFront(reversed);
             }
-        }
 
-        if (newChain)
-        {
-            growingChains.push_back(points);
+            addEndpoints(j);
         }
     }
 
-    // Only keep chains that are at least as long as the threshold.
-    for (int i = 0; i < growingChains.size(); i++)
-    {
-        PixelChain candidate = growingChains.at(i);
-
-        if (candidate.GetLength() >= lengthThreshold)
-        {
-            mChains.push_back(candidate);
-        }
-    }
-
-    emit Finished();
+    return growingChains;
 }
 
 const QList<DiffusionCurveRenderer::PixelChain>& DiffusionCurveRenderer::EdgeTracer::GetChains() const
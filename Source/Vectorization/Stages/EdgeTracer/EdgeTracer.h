@@ -3,9 +3,12 @@
 #include "Vectorization/Stages/Base/PixelChain.h"
 #include "Vectorization/Stages/Base/VectorizationStageBase.h"
 
+#include <QBitArray>
 #include <QList>
+#include <functional>
 #include <opencv2/core.hpp>
 #include <opencv2/core/mat.hpp>
+#include <vector>
 
 namespace DiffusionCurveRenderer
 {
@@ -30,6 +33,24 @@ namespace DiffusionCurveRenderer
 
         const QList<PixelChain>& GetChains() const;
 
+        /*
+         * Traces chains of edge pixels starting at <seeds>, in order, and
+         * merges every new chain into the existing chains it touches.
+         *
+         * Pixels set in <visited> are skipped, traced pixels are set. For
+         * every chain, the index of the seed it was started from is written
+         * to <chainSeeds> if it is not null.
+         *
+         * Tracing stops early with the chains so far once <cancelled>
+         * returns true, it is polled as often as <progress> is called.
+         */
+        static std::vector<PixelChain> Trace(const cv::Mat& edges,
+                                             const std::vector<cv::Point>& seeds,
+                                             QBitArray& visited,
+                                             std::vector<int>* chainSeeds = nullptr,
+                                             const std::function<void(float)>& progress = nullptr,
+                                             const std::function<bool()>& cancelled = nullptr);
+
         void Reset() override;
 
       private:
@@ -1,57 +1,52 @@
 #include "GaussianStack.h"
 
+#include "Util/Logger.h"
+#include "Util/Parallel.h"
+
+#include <QMutexLocker>
+#include <cmath>
+
 DiffusionCurveRenderer::GaussianStack::GaussianStack(QObject* parent)
     : VectorizationStageBase(parent)
 {
 }
 
 /**
- * Construct a Gaussian scale space representing the image passed in.
+ * Prepares a Gaussian scale space representing the image passed in.
  *
- * Repeatedly applies a Gaussian filter with radius sigma starting from 0
- * and increasing by <sigmaStep> (default 0.4) each level. The stack stops
- * when the image's standard deviation drops below <stdDevCutoff> (default
- * 40) or, if a max height is specified, at that height.
+ * Layer n is the image blurred with sigma 0.4 + n * <sigmaStep> (default
+ * 0.4). Layers are computed when they are first requested, every
+ * eighth one from the image and the others from the one below with the
+ * incremental sigma sqrt(sigma_n^2 - sigma_n-1^2).
+ * The stack stops at <maxHeight> layers.
  *
  * param image: An OpenCV matrix containing an RGB image.
  * param stdDevCutoff: The minimum standard deviation of a blurred image
- *                     that will be used in the stack.
+ *                     that will be used in the stack. Currently unused.
  * param maxHeight: The maximum height of the stack.
  * param sigmaStep: The increase in Gaussian filter widths between each level.
  */
 void DiffusionCurveRenderer::GaussianStack::Run(cv::Mat image, double stdDevCutoff, int maxHeight, double sigmaStep)
 {
-    this->mLevels.clear();
-
-    double sigma = 0.4;
-    //    double stdDev;
-
-    int remainingHeight = maxHeight;
+    QMutexLocker locker(&mMutex);
 
-    do
-    {
-        float progress = float(maxHeight - remainingHeight) / float(maxHeight);
-        emit ProgressChanged(progress);
-
-        // Define parameters for the next level of Gaussian filter.
-        const int radius = std::ceil(2 * sigma);
-        const int width = 2 * radius + 1;
-
-        cv::Mat blurred;
-        cv::GaussianBlur(image, blurred, cv::Size(width, width), sigma, sigma);
+    this->mLevels.clear();
+    this->mRecentlyUsed.clear();
 
-        // Compute the image's standard deviation, averaged over three channels.
-        //        cv::Scalar mean, stdDevChannels;
-        //        cv::meanStdDev(blurred, mean, stdDevChannels);
-        //        stdDev = (stdDevChannels[0] + stdDevChannels[1] + stdDevChannels[2]) / 3.0;
+    image.convertTo(this->mImage, CV_32F);
+    this->mImageType = image.type();
 
-        sigma += 0.4;
+    // Four times the size of an 8-bit image, it is part of the budget like the layers
+    this->mUsedBytes = this->mImage.total() * this->mImage.elemSize();
 
-        this->mLevels.push_back(blurred);
+    this->mSigmas.clear();
 
-        remainingHeight -= 1;
-    } while (remainingHeight != 0);
+    for (int layer = 0; layer < maxHeight; ++layer)
+    {
+        this->mSigmas.push_back(0.4 + layer * sigmaStep);
+    }
 
+    ReportProgress(1.0f);
     emit Finished();
 }
 
@@ -60,7 +55,9 @@ void DiffusionCurveRenderer::GaussianStack::Run(cv::Mat image, double stdDevCuto
  */
 int DiffusionCurveRenderer::GaussianStack::GetHeight()
 {
-    return this->mLevels.size();
+    QMutexLocker locker(&mMutex);
+
+    return this->mSigmas.size();
 }
 
 /*
@@ -69,18 +66,191 @@ int DiffusionCurveRenderer::GaussianStack::GetHeight()
  */
 void DiffusionCurveRenderer::GaussianStack::Restrict(int layers)
 {
-    this->mLevels.resize(layers);
+    QMutexLocker locker(&mMutex);
+
+    this->mSigmas.resize(layers);
+
+    while (!this->mLevels.empty() && this->mLevels.rbegin()->first >= layers)
+    {
+        const auto last = std::prev(this->mLevels.end());
+        this->mUsedBytes -= last->second.total() * last->second.elemSize();
+        this->mRecentlyUsed.removeOne(last->first);
+        this->mLevels.erase(last);
+    }
 }
 
 /*
- * Returns the blurred RGB image at the <layer>'th layer.
+ * Returns the blurred RGB image at the <layer>'th layer, computing it
+ * if it is not stored. Returns an empty matrix if the stack has no
+ * such layer, e.g. because it was reset by another thread.
+ *
+ * The bounds are checked under the lock the layer is computed under,
+ * a height queried before may be outdated by then.
  */
 cv::Mat DiffusionCurveRenderer::GaussianStack::GetLayer(int layer)
 {
-    return this->mLevels.at(layer);
+    QMutexLocker locker(&mMutex);
+
+    if (layer < 0 || this->mSigmas.size() <= layer)
+    {
+        return cv::Mat();
+    }
+
+    cv::Mat blurred;
+    const auto it = this->mLevels.find(layer);
+
+    if (it != this->mLevels.end())
+    {
+        this->Touch(layer);
+        blurred = it->second;
+    }
+    else
+    {
+        blurred = this->ComputeLayer(layer);
+    }
+
+    // Rounded once here, never in between layers
+    cv::Mat result;
+    blurred.convertTo(result, this->mImageType);
+
+    return result;
+}
+
+/*
+ * Computes the <layer>'th layer from the closest layer below it that
+ * is still stored, down to its anchor layer, which is blurred from
+ * the image.
+ *
+ * Blurring with sigma a and then with sigma b equals blurring with
+ * sigma sqrt(a^2 + b^2), so every step only needs the small incremental
+ * kernel and the layers in between are stored on the way up. Browsing
+ * the layers one by one is cheap that way. A far away layer, e.g. the
+ * one chosen for vectorization right after loading, needs at most one
+ * direct blur and ANCHOR_SPACING - 1 small ones.
+ *
+ * Every layer has exactly one derivation, so it is the same whichever
+ * layers happen to be stored, and edges computed from it can be cached.
+ */
+cv::Mat DiffusionCurveRenderer::GaussianStack::ComputeLayer(int layer)
+{
+    const int anchor = layer - layer % ANCHOR_SPACING;
+
+    int start = layer - 1;
+
+    while (start >= anchor && this->mLevels.count(start) == 0)
+    {
+        start--;
+    }
+
+    cv::Mat blurred;
+
+    if (start < anchor)
+    {
+        blurred = this->Blur(this->mImage, this->mSigmas[anchor]);
+        this->Store(anchor, blurred);
+        start = anchor;
+    }
+    else
+    {
+        blurred = this->mLevels[start];
+    }
+
+    for (int current = start + 1; current <= layer; ++current)
+    {
+        blurred = this->Blur(blurred, this->GetIncrementalSigma(current));
+        this->Store(current, blurred);
+    }
+
+    return blurred;
+}
+
+/*
+ * Returns the sigma that blurs the layer below <layer> into <layer>.
+ */
+double DiffusionCurveRenderer::GaussianStack::GetIncrementalSigma(int layer) const
+{
+    const double previousSigma = layer == 0 ? 0.0 : this->mSigmas[layer - 1];
+
+    return std::sqrt(this->mSigmas[layer] * this->mSigmas[layer] - previousSigma * previousSigma);
+}
+
+/*
+ * Blurs <image> in horizontal bands in parallel. OpenCV filters read the
+ * rows around a band from the parent matrix, so the bands add up to the
+ * same result as a single call on the whole image.
+ */
+cv::Mat DiffusionCurveRenderer::GaussianStack::Blur(const cv::Mat& image, double sigma)
+{
+    // Define parameters for the next level of Gaussian filter.
+    const int radius = std::ceil(2 * sigma);
+    const int width = 2 * radius + 1;
+
+    cv::Mat blurred(image.size(), image.type());
+
+    const int bandHeight = std::max(64, image.rows / (4 * Parallel::GetThreadCount()));
+
+    Parallel::For(image.rows, bandHeight, [&](int begin, int end) {
+        cv::Mat band = blurred.rowRange(begin, end);
+        cv::GaussianBlur(image.rowRange(begin, end), band, cv::Size(width, width), sigma, sigma);
+    });
+
+    return blurred;
+}
+
+/*
+ * Stores <image> as the <layer>'th layer and drops the least recently
+ * used layers until the stack fits into the memory budget again.
+ */
+void DiffusionCurveRenderer::GaussianStack::Store(int layer, const cv::Mat& image)
+{
+    this->mLevels[layer] = image;
+    this->mUsedBytes += image.total() * image.elemSize();
+    this->Touch(layer);
+
+    while (this->mUsedBytes > this->mMemoryBudget && this->mRecentlyUsed.size() > 1)
+    {
+        const int evicted = this->mRecentlyUsed.takeLast();
+        const cv::Mat& level = this->mLevels[evicted];
+
+        this->mUsedBytes -= level.total() * level.elemSize();
+        this->mLevels.erase(evicted);
+    }
+}
+
+void DiffusionCurveRenderer::GaussianStack::Touch(int layer)
+{
+    this->mRecentlyUsed.removeOne(layer);
+    this->mRecentlyUsed.prepend(layer);
+}
+
+/*
+ * Upper bound for the bytes of the single precision copy of the
+ * image and the stored layers. The last computed layer is kept
+ * even if it exceeds the budget, and the layer being blurred is
+ * not counted, so the peak is the budget plus about two layers.
+ * Takes effect with the next stored layer.
+ */
+void DiffusionCurveRenderer::GaussianStack::SetMemoryBudget(size_t bytes)
+{
+    QMutexLocker locker(&mMutex);
+
+    this->mMemoryBudget = bytes;
+}
+
+size_t DiffusionCurveRenderer::GaussianStack::GetMemoryBudget()
+{
+    QMutexLocker locker(&mMutex);
+
+    return this->mMemoryBudget;
 }
 
 void DiffusionCurveRenderer::GaussianStack::Reset()
 {
-    mLevels.clear();
+    QMutexLocker locker(&mMutex);
+
+    this->mLevels.clear();
+    this->mRecentlyUsed.clear();
+    this->mUsedBytes = 0;
+    this->mImage.release();
+    this->mSigmas.clear();
 }
@@ -1,8 +1,13 @@
 #pragma once
 
+#include "Core/Constants.h"
+#include "Util/Macros.h"
 #include "Vectorization/Stages/Base/VectorizationStageBase.h"
 
+#include <QList>
+#include <QMutex>
 #include <QVector>
+#include <map>
 #include <opencv2/core/mat.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
@@ -13,24 +18,84 @@ namespace DiffusionCurveRenderer
         Q_OBJECT
       private:
         /*
-         * A vector of increasingly Gaussian-blurred images.
+         * Increasingly Gaussian-blurred images computed so far, keyed by layer,
+         * in single precision so the cascade does not accumulate rounding.
+         * The least recently used ones are dropped when they and <mImage>
+         * together exceed <mMemoryBudget> and computed again on demand.
          */
-        QVector<cv::Mat> mLevels;
+        std::map<int, cv::Mat> mLevels;
+
+        /*
+         * Layers in mLevels, the most recently used one first.
+         */
+        QList<int> mRecentlyUsed;
+
+        /*
+         * The image the stack is built from in single precision, its original
+         * type that layers are returned in, and the sigma of every layer.
+         */
+        cv::Mat mImage;
+        int mImageType{ 0 };
+        QVector<double> mSigmas;
+
+        /*
+         * Bytes of <mImage> and the stored layers, bounded by <mMemoryBudget>.
+         */
+        size_t mUsedBytes{ 0 };
+        size_t mMemoryBudget{ DEFAULT_GAUSSIAN_STACK_MEMORY_BUDGET };
+
+        /*
+         * GetLayer() is called from the vectorization thread and, to display
+         * layers, from the GUI thread.
+         */
+        QMutex mMutex;
+
+        /*
+         *  Computes the <layer>'th layer from the closest layer below it that
+         *  is still stored, down to its anchor layer, which is blurred from
+         *  the image.
+         */
+        cv::Mat ComputeLayer(int layer);
+
+        /*
+         *  Returns the sigma that blurs the layer below <layer> into <layer>.
+         */
+        double GetIncrementalSigma(int layer) const;
+
+        /*
+         *  Blurs <image> in horizontal bands in parallel.
+         */
+        static cv::Mat Blur(const cv::Mat& image, double sigma);
+
+        /*
+         *  Stores <image> as the <layer>'th layer and drops the least recently
+         *  used layers until the stack fits into the memory budget again.
+         */
+        void Store(int layer, const cv::Mat& image);
+
+        void Touch(int layer);
+
+        /*
+         *  Every ANCHOR_SPACING'th layer is blurred from the image directly,
+         *  the layers in between are blurred from the one below.
+         */
+        static constexpr int ANCHOR_SPACING = 8;
 
       public:
         explicit GaussianStack(QObject* parent);
 
         /**
-         * Construct a Gaussian scale space representing the image passed in.
+         * Prepares a Gaussian scale space representing the image passed in.
          *
-         * Repeatedly applies a Gaussian filter with radius sigma starting from 0
-         * and increasing by <sigmaStep> (default 0.4) each level. The stack stops
-         * when the image's standard deviation drops below <stdDevCutoff> (default
-         * 40) or, if a max height is specified, at that height.
+         * Layer n is the image blurred with sigma 0.4 + n * <sigmaStep> (default
+         * 0.4). Layers are computed when they are first requested, every
+         * eighth one from the image and the others from the one below with the
+         * incremental sigma sqrt(sigma_n^2 - sigma_n-1^2).
+         * The stack stops at <maxHeight> layers.
          *
          * param image: An OpenCV matrix containing an RGB image.
          * param stdDevCutoff: The minimum standard deviation of a blurred image
-         *                     that will be used in the stack.
+         *                     that will be used in the stack. Currently unused.
          * param maxHeight: The maximum height of the stack.
          * param sigmaStep: The increase in Gaussian filter widths between each level.
          */
@@ -48,10 +113,22 @@ namespace DiffusionCurveRenderer
         void Restrict(int layers);
 
         /*
-         *  Returns the blurred RGB image at the <layer>'th layer.
+         *  Returns the blurred RGB image at the <layer>'th layer, computing it
+         *  if it is not stored. Returns an empty matrix if the stack has no
+         *  such layer, e.g. because it was reset by another thread.
          */
         cv::Mat GetLayer(int layer);
 
         void Reset() override;
+
+        /*
+         *  Upper bound for the bytes of the single precision copy of the
+         *  image and the stored layers. The last computed layer is kept
+         *  even if it exceeds the budget, and the layer being blurred is
+         *  not counted, so the peak is the budget plus about two layers.
+         *  Takes effect with the next stored layer.
+         */
+        void SetMemoryBudget(size_t bytes);
+        size_t GetMemoryBudget();
     };
-}
\ No newline at end of file
+}
@@ -1,5 +1,11 @@
 #include "Potrace.h"
 
+#include "Util/Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
 DiffusionCurveRenderer::Potrace::Potrace(QObject* parent)
     : VectorizationStageBase(parent)
 {
@@ -23,114 +29,23 @@ DiffusionCurveRenderer::Potrace::Potrace(QObject* parent)
  */
 void DiffusionCurveRenderer::Potrace::Run(const QVector<PixelChain>& chains)
 {
-    for (int i = 0; i < chains.size(); i++)
-    {
-        float progress = float(i) / (chains.size() - 1);
-
-        emit ProgressChanged(progress);
-
-        PixelChain chain = chains[i];
-        QVector<Point> polyline;
-
-        const int nPoints = chain.GetLength();
+    const int nChains = chains.size();
 
-        // Each entry i, j represents the penalty of a straight line
-        // from pixel i directly to pixel j.
-        Eigen::MatrixXd penalties(nPoints, nPoints);
-        // Set a recognizable dummy value to signify no penalty is set.
-        penalties.setConstant(-1.0);
+    QVector<QVector<Point>> polylines(nChains);
 
-        // First, find a penalty between each pair of pixels, or leave the dummy
-        // value if two pixels cannot be connected by a straight line.
-
-        // Iterate over all triplets i, j, k, such that 0 <= i < j < k <= nPoints.
-        for (int i = 0; i < nPoints; i++)
-        {
-            for (int k = i + 1; k < nPoints; k++)
-            {
-                bool isStraightPath = true;
-
-                Eigen::Vector2f pointI = chain.Get(i).ToVector();
-                Eigen::Vector2f pointK = chain.Get(k).ToVector();
-
-                // Check that all points between I and K are close enough to the
-                // straight line connecting them.
-                for (int j = i + 1; j < k; j++)
-                {
-                    Eigen::Vector2f pointJ = chain.Get(j).ToVector();
+    // Chains are independent. The cost grows with the square of the length,
+    // so the longest chains are started first.
+    Parallel::ForLargestFirst(
+        nChains,
+        [&](int i) { return qint64(chains[i].GetLength()); },
+        [&](int i) {
+            if (!IsCancelled())
+                FindBestPath(polylines[i], chains[i]);
+        },
+        [&](int finished) { ReportProgress(float(finished) / nChains); });
 
-                    Eigen::Vector2f lineItoK = pointK - pointI;
-                    Eigen::Vector2f lineItoJ = pointJ - pointI;
-
-                    double coefficient = lineItoJ.dot(lineItoK) / lineItoK.squaredNorm();
-                    Eigen::Vector2f dispJFromLine = lineItoJ - coefficient * lineItoK;
-
-                    // Discard the line if any point J is further than one unit
-                    // off the line.
-                    if (dispJFromLine.norm() >= 1.0)
-                    {
-                        isStraightPath = false;
-                        break;
-                    }
-                }
-
-                if (isStraightPath)
-                {
-                    // Now that this line is known to be valid, compute the penalty
-                    // for this path segment.
-
-                    // Use an approximation of penalty from the Potrace paper.
-                    const double x = pointK.x() - pointI.x();
-                    const double y = pointK.y() - pointI.y();
-
-                    const double xBar = (pointK + pointI).x() / 2.0;
-                    const double yBar = (pointK + pointI).y() / 2.0;
-
-                    // Compute expected values of all the terms below.
-                    double expectedX = 0.0;
-                    double expectedY = 0.0;
-                    double expectedXY = 0.0;
-                    double expectedXSquare = 0.0;
-                    double expectedYSquare = 0.0;
-
-                    for (int j = i; j <= k; j++)
-                    {
-                        const int xAtj = chain.Get(j).x;
-                        const int yAtj = chain.Get(j).y;
-
-                        expectedX += xAtj;
-                        expectedY += yAtj;
-                        expectedXY += xAtj * yAtj;
-                        expectedXSquare += xAtj * xAtj;
-                        expectedYSquare += yAtj * yAtj;
-                    }
-
-                    expectedX /= (k - i + 1);
-                    expectedY /= (k - i + 1);
-                    expectedXY /= (k - i + 1);
-                    expectedXSquare /= (k - i + 1);
-                    expectedYSquare /= (k - i + 1);
-
-                    // Evaluate the penalty approximation from the Potrace paper.
-                    const double a = expectedXSquare - 2 * xBar * expectedX + pow(xBar, 2.0);
-                    const double b = expectedXY - xBar * expectedX - yBar * expectedY + xBar * yBar;
-                    const double c = expectedYSquare - 2 * yBar * expectedY + pow(yBar, 2.0);
-
-                    const double interior = c * pow(x, 2.0) + 2 * b * x * y + a * pow(y, 2.0);
-                    const double penalty = std::sqrt(interior);
-
-                    penalties(i, k) = penalty;
-                }
-            }
-        }
-
-        // Search for the shortest and least-penalty path using the penalties
-        // matrix. Invalid paths are now identified by dummy values left over
-        // in the matrix.
-        FindBestPath(polyline, chain, penalties);
-
-        mPolylines << polyline;
-    }
+    // In the order of the chains, whichever thread traced them
+    mPolylines.append(polylines);
 
     emit Finished();
 }
@@ -138,76 +53,233 @@ void DiffusionCurveRenderer::Potrace::Run(const QVector<PixelChain>& chains)
 /* This code taken from https://github.com/zhuethanca/DiffusionCurves
  *
  * Finds a sequence of pixels, forming a polyline, which approximates
- * the pixel chain <chain> with the minimum number of segments and with
- * the minimum penalty given the matrix <penalties>.
+ * the pixel chain <chain> with the minimum number of segments and,
+ * among those, the minimum penalty.
+ *
+ * A line from pixel i to pixel k is valid if every pixel between them
+ * is less than one unit off it. Pixel j allows the directions within
+ * asin(1 / |Pj - Pi|) of Pj - Pi, so the directions allowed by all
+ * pixels up to k shrink as k grows. Once none is left no longer line
+ * from i is valid, which bounds the scan. Penalties are evaluated in
+ * constant time from prefix sums of the pixel moments. The best paths
+ * are found backwards from the end, keeping only the next pixel, the
+ * number of segments and the penalty of every pixel, so memory is
+ * linear in the length of the chain.
  *
  * param bestPath: Return value, a sequence of points approximating the chain.
  * param chain: Continuous chain of pixels to be approximated by a polyline.
- * param penalties: Matrix in which the entry i, j represents the penalty of
- *                  a straight line between pixels i and j, or -1 if they are
- *                  not connectable by a straight line.
  */
-void DiffusionCurveRenderer::Potrace::FindBestPath(QVector<Point>& bestPath, PixelChain chain, Eigen::MatrixXd penalties)
+void DiffusionCurveRenderer::Potrace::FindBestPath(QVector<Point>& bestPath, const PixelChain& chain)
 {
     const int nPoints = chain.GetLength();
 
-    // Store a vector which identifies best paths and their penalties from
-    // pixel i to the endpoint.
-    Eigen::VectorXd bestPenalties(nPoints);
-    std::vector<std::vector<int>> bestPaths;
+    // Sums of integers are exact, the penalties equal those summed pixel by pixel.
+    std::vector<double> xs(nPoints);
+    std::vector<double> ys(nPoints);
 
-    // Make sure to set initial values for both penalties and paths, including
-    // a sensible initial value for the endpoint itself.
-    bestPenalties.setConstant(-1);
-    bestPenalties(nPoints - 1) = 0;
+    // Entry n holds the sums over pixels 0 to n - 1.
+    std::vector<double> sumX(nPoints + 1, 0.0);
+    std::vector<double> sumY(nPoints + 1, 0.0);
+    std::vector<double> sumXY(nPoints + 1, 0.0);
+    std::vector<double> sumXSquare(nPoints + 1, 0.0);
+    std::vector<double> sumYSquare(nPoints + 1, 0.0);
 
     for (int i = 0; i < nPoints; i++)
     {
-        std::vector<int> nullPath;
-        bestPaths.push_back(nullPath);
+        const Point point = chain.Get(i);
+
+        xs[i] = point.x;
+        ys[i] = point.y;
+
+        sumX[i + 1] = sumX[i] + xs[i];
+        sumY[i + 1] = sumY[i] + ys[i];
+        sumXY[i + 1] = sumXY[i] + xs[i] * ys[i];
+        sumXSquare[i + 1] = sumXSquare[i] + xs[i] * xs[i];
+        sumYSquare[i + 1] = sumYSquare[i] + ys[i] * ys[i];
     }
 
-    bestPaths.at(nPoints - 1).push_back(nPoints - 1);
+    // Use an approximation of penalty from the Potrace paper.
+    const auto penaltyOf = [&](int i, int k) {
+        const double x = xs[k] - xs[i];
+        const double y = ys[k] - ys[i];
+
+        const double xBar = (xs[k] + xs[i]) / 2.0;
+        const double yBar = (ys[k] + ys[i]) / 2.0;
+
+        // Compute expected values of all the terms below.
+        const double count = k - i + 1;
+        const double expectedX = (sumX[k + 1] - sumX[i]) / count;
+        const double expectedY = (sumY[k + 1] - sumY[i]) / count;
+        const double expectedXY = (sumXY[k + 1] - sumXY[i]) / count;
+        const double expectedXSquare = (sumXSquare[k + 1] - sumXSquare[i]) / count;
+        const double expectedYSquare = (sumYSquare[k + 1] - sumYSquare[i]) / count;
+
+        // Evaluate the penalty approximation from the Potrace paper.
+        const double a = expectedXSquare - 2 * xBar * expectedX + xBar * xBar;
+        const double b = expectedXY - xBar * expectedX - yBar * expectedY + xBar * yBar;
+        const double c = expectedYSquare - 2 * yBar * expectedY + yBar * yBar;
+
+        const double interior = c * (x * x) + 2 * b * x * y + a * (y * y);
+        return std::sqrt(std::max(0.0, interior));
+    };
+
+    // Number of segments, penalty and next pixel of the best path from
+    // every pixel to the endpoint.
+    std::vector<int> bestSegments(nPoints, 0);
+    std::vector<double> bestPenalties(nPoints, 0.0);
+    std::vector<int> next(nPoints, -1);
+
+    DirectionSet directions;
 
     // Work backwards, finding best paths from the end back to the beginning
     // using a dynamic programming approach.
     for (int i = nPoints - 2; i >= 0; i--)
     {
-        for (int j = i + 1; j < nPoints; j++)
+        directions.Reset();
+
+        for (int k = i + 1; k < nPoints && !directions.IsEmpty(); k++)
         {
-            if (penalties(i, j) != -1)
+            const double dx = xs[k] - xs[i];
+            const double dy = ys[k] - ys[i];
+
+            if (directions.Contains(dx, dy))
             {
-                const double penaltyCandidate = penalties(i, j) + bestPenalties(j);
-                std::vector<int> pathCandidate = bestPaths.at(j);
-                pathCandidate.push_back(i);
+                const int segmentsCandidate = bestSegments[k] + 1;
+                const double penaltyCandidate = penaltyOf(i, k) + bestPenalties[k];
 
-                bool firstPath = bestPaths.at(i).size() == 0;
-                bool shortPath = pathCandidate.size() < bestPaths.at(i).size();
-                bool equalPath = pathCandidate.size() == bestPaths.at(i).size();
-                bool cheapPath = penaltyCandidate < bestPenalties(i);
+                bool firstPath = next[i] == -1;
+                bool shortPath = segmentsCandidate < bestSegments[i];
+                bool equalPath = segmentsCandidate == bestSegments[i];
+                bool cheapPath = penaltyCandidate < bestPenalties[i];
 
                 // Check if this is a new best path for any of the above reasons.
                 if (firstPath || shortPath || (equalPath && cheapPath))
                 {
-                    bestPenalties(i) = penaltyCandidate;
-                    bestPaths.at(i) = pathCandidate;
+                    bestSegments[i] = segmentsCandidate;
+                    bestPenalties[i] = penaltyCandidate;
+                    next[i] = k;
                 }
             }
+
+            // Lines to the pixels after k must pass within one unit of it.
+            directions.Restrict(dx, dy);
         }
     }
 
-    std::vector<int> bestPathIndices = bestPaths.front();
-    std::reverse(bestPathIndices.begin(), bestPathIndices.end());
-
     // Convert the path indices into a polyline.
     bestPath.clear();
-    for (int i = 0; i < bestPathIndices.size(); i++)
+
+    for (int i = 0; i != -1; i = next[i])
     {
-        Point point = chain.Get(bestPathIndices.at(i));
-        bestPath.push_back(point);
+        bestPath.push_back(chain.Get(i));
     }
 }
 
+void DiffusionCurveRenderer::Potrace::DirectionSet::Reset()
+{
+    mIntervals.clear();
+    mIntervals.push_back({ 0.0, std::numbers::pi });
+}
+
+bool DiffusionCurveRenderer::Potrace::DirectionSet::IsEmpty() const
+{
+    return mIntervals.empty();
+}
+
+bool DiffusionCurveRenderer::Potrace::DirectionSet::Contains(double dx, double dy) const
+{
+    const double angle = ToAngle(dx, dy);
+
+    for (const auto& [low, high] : mIntervals)
+    {
+        if (low <= angle && angle <= high)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void DiffusionCurveRenderer::Potrace::DirectionSet::Restrict(double dx, double dy)
+{
+    const double length = std::sqrt(dx * dx + dy * dy);
+
+    // Every line through the origin passes closer than one unit
+    if (length < 1.0)
+    {
+        return;
+    }
+
+    // Distances of exactly one unit are not allowed, e.g. perpendicular to an
+    // axis neighbour, the margin keeps them out despite rounding.
+    const double halfWidth = std::asin(1.0 / length) - MARGIN;
+
+    if (halfWidth <= 0.0)
+    {
+        mIntervals.clear();
+        return;
+    }
+
+    const double center = ToAngle(dx, dy);
+    const double low = center - halfWidth;
+    const double high = center + halfWidth;
+
+    // The arc of allowed directions as intervals within [0, pi]
+    std::vector<std::pair<double, double>> arc;
+
+    if (low < 0.0)
+    {
+        arc.push_back({ 0.0, high });
+        arc.push_back({ low + std::numbers::pi, std::numbers::pi });
+    }
+    else if (high > std::numbers::pi)
+    {
+        arc.push_back({ 0.0, high - std::numbers::pi });
+        arc.push_back({ low, std::numbers::pi });
+    }
+    else
+    {
+        arc.push_back({ low, high });
+    }
+
+    std::vector<std::pair<double, double>> intersection;
+
+    for (const auto& [low0, high0] : mIntervals)
+    {
+        for (const auto& [low1, high1] : arc)
+        {
+            const double lowest = std::max(low0, low1);
+            const double highest = std::min(high0, high1);
+
+            if (lowest <= highest)
+            {
+                intersection.push_back({ lowest, highest });
+            }
+        }
+    }
+
+    mIntervals.swap(intersection);
+}
+
+double DiffusionCurveRenderer::Potrace::DirectionSet::ToAngle(double dx, double dy)
+{
+    // Lines have no orientation, directions are taken modulo pi
+    double angle = std::atan2(dy, dx);
+
+    if (angle < 0.0)
+    {
+        angle += std::numbers::pi;
+    }
+
+    if (angle >= std::numbers::pi)
+    {
+        angle -= std::numbers::pi;
+    }
+
+    return angle;
+}
+
 const QVector<QVector<DiffusionCurveRenderer::Point>>& DiffusionCurveRenderer::Potrace::GetPolylines() const
 {
     return mPolylines;
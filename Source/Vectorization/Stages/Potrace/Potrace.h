@@ -4,6 +4,8 @@
 #include "Vectorization/Stages/Base/VectorizationStageBase.h"
 
 #include <QVector>
+#include <utility>
+#include <vector>
 
 namespace DiffusionCurveRenderer
 {
@@ -38,16 +40,40 @@ namespace DiffusionCurveRenderer
         /* This code taken from https://github.com/zhuethanca/DiffusionCurves
          *
          * Finds a sequence of pixels, forming a polyline, which approximates
-         * the pixel chain <chain> with the minimum number of segments and with
-         * the minimum penalty given the matrix <penalties>.
+         * the pixel chain <chain> with the minimum number of segments and,
+         * among those, the minimum penalty. Runs in time quadratic and memory
+         * linear in the length of the chain.
          *
          * param bestPath: Return value, a sequence of points approximating the chain.
          * param chain: Continuous chain of pixels to be approximated by a polyline.
-         * param penalties: Matrix in which the entry i, j represents the penalty of
-         *                  a straight line between pixels i and j, or -1 if they are
-         *                  not connectable by a straight line.
          */
-        void FindBestPath(QVector<Point>& bestPath, PixelChain chain, Eigen::MatrixXd penalties);
+        void FindBestPath(QVector<Point>& bestPath, const PixelChain& chain);
+
+        /*
+         * Directions of lines through a pixel, as intervals of angles in
+         * [0, pi], that pass less than one unit from the pixels restricted
+         * so far.
+         */
+        class DirectionSet
+        {
+          public:
+            void Reset();
+            bool IsEmpty() const;
+            bool Contains(double dx, double dy) const;
+
+            /*
+             * Removes the directions of lines passing one unit or further
+             * from the point at offset (dx, dy).
+             */
+            void Restrict(double dx, double dy);
+
+          private:
+            static double ToAngle(double dx, double dy);
+
+            std::vector<std::pair<double, double>> mIntervals;
+
+            static constexpr double MARGIN = 1e-9;
+        };
 
       private:
         QVector<QVector<Point>> mPolylines;
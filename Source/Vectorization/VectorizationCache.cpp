@@ -0,0 +1,492 @@
+#include "VectorizationCache.h"
+
+#include "Curve/Bezier.h"
+#include "Curve/Spline.h"
+#include "Util/Logger.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+DiffusionCurveRenderer::VectorizationCache::VectorizationCache(const QString& directory)
+    : mDirectory(directory)
+{
+}
+
+QByteArray DiffusionCurveRenderer::VectorizationCache::HashImage(const cv::Mat& image)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    const qint32 header[] = { image.rows, image.cols, image.type() };
+    hash.addData(QByteArrayView(reinterpret_cast<const char*>(header), sizeof(header)));
+
+    // Row by row, the image may be a region of a larger one
+    const qsizetype rowBytes = qsizetype(image.cols) * image.elemSize();
+
+    for (int y = 0; y < image.rows; ++y)
+        hash.addData(QByteArrayView(image.ptr<char>(y), rowBytes));
+
+    return hash.result();
+}
+
+QByteArray DiffusionCurveRenderer::VectorizationCache::MakeKey(const QByteArray& imageHash, const QString& parameters)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(imageHash);
+    hash.addData(parameters.toUtf8());
+
+    return hash.result().toHex();
+}
+
+bool DiffusionCurveRenderer::VectorizationCache::LoadEdges(const QByteArray& key, cv::Mat& edges)
+{
+    QByteArray payload;
+
+    if (Read(key, payload) == false)
+        return false;
+
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    qint32 rows, cols, type;
+    stream >> rows >> cols >> type;
+
+    if (stream.status() != QDataStream::Ok || rows < 0 || cols < 0)
+        return false;
+
+    cv::Mat result(rows, cols, type);
+    const int rowBytes = cols * int(result.elemSize());
+
+    for (int y = 0; y < rows; ++y)
+    {
+        if (stream.readRawData(result.ptr<char>(y), rowBytes) != rowBytes)
+            return false;
+    }
+
+    edges = result;
+
+    return true;
+}
+
+void DiffusionCurveRenderer::VectorizationCache::StoreEdges(const QByteArray& key, const cv::Mat& edges)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    stream << qint32(edges.rows) << qint32(edges.cols) << qint32(edges.type());
+
+    const int rowBytes = edges.cols * int(edges.elemSize());
+
+    for (int y = 0; y < edges.rows; ++y)
+        stream.writeRawData(edges.ptr<char>(y), rowBytes);
+
+    Write(key, payload);
+}
+
+bool DiffusionCurveRenderer::VectorizationCache::LoadChains(const QByteArray& key, QList<PixelChain>& chains)
+{
+    QByteArray payload;
+
+    if (Read(key, payload) == false)
+        return false;
+
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    qint32 nChains;
+    stream >> nChains;
+
+    QList<PixelChain> result;
+
+    for (int i = 0; i < nChains && stream.status() == QDataStream::Ok; ++i)
+    {
+        qint32 length;
+        stream >> length;
+
+        PixelChain chain;
+
+        for (int j = 0; j < length && stream.status() == QDataStream::Ok; ++j)
+        {
+            qint32 x, y;
+            stream >> x >> y;
+            chain.Append(Point(x, y));
+        }
+
+        result.push_back(chain);
+    }
+
+    if (stream.status() != QDataStream::Ok)
+        return false;
+
+    chains = result;
+
+    return true;
+}
+
+void DiffusionCurveRenderer::VectorizationCache::StoreChains(const QByteArray& key, const QList<PixelChain>& chains)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    // Chains are made of pixel positions
+    stream << qint32(chains.size());
+
+    for (const auto& chain : chains)
+    {
+        stream << qint32(chain.GetLength());
+
+        for (int j = 0; j < chain.GetLength(); ++j)
+        {
+            const Point point = chain.Get(j);
+            stream << qint32(point.x) << qint32(point.y);
+        }
+    }
+
+    Write(key, payload);
+}
+
+bool DiffusionCurveRenderer::VectorizationCache::LoadPolylines(const QByteArray& key, QVector<QVector<Point>>& polylines)
+{
+    QByteArray payload;
+
+    if (Read(key, payload) == false)
+        return false;
+
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    qint32 nPolylines;
+    stream >> nPolylines;
+
+    QVector<QVector<Point>> result;
+
+    for (int i = 0; i < nPolylines && stream.status() == QDataStream::Ok; ++i)
+    {
+        qint32 length;
+        stream >> length;
+
+        QVector<Point> polyline;
+
+        for (int j = 0; j < length && stream.status() == QDataStream::Ok; ++j)
+        {
+            qint32 x, y;
+            stream >> x >> y;
+            polyline.push_back(Point(x, y));
+        }
+
+        result.push_back(polyline);
+    }
+
+    if (stream.status() != QDataStream::Ok)
+        return false;
+
+    polylines = result;
+
+    return true;
+}
+
+void DiffusionCurveRenderer::VectorizationCache::StorePolylines(const QByteArray& key, const QVector<QVector<Point>>& polylines)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    // Potrace picks the corners of a polyline among the pixels of its chain
+    stream << qint32(polylines.size());
+
+    for (const auto& polyline : polylines)
+    {
+        stream << qint32(polyline.size());
+
+        for (const auto& point : polyline)
+            stream << qint32(point.x) << qint32(point.y);
+    }
+
+    Write(key, payload);
+}
+
+bool DiffusionCurveRenderer::VectorizationCache::LoadCurves(const QByteArray& key, QVector<CurvePtr>& curves)
+{
+    QByteArray payload;
+
+    if (Read(key, payload) == false)
+        return false;
+
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    qint32 nCurves;
+    stream >> nCurves;
+
+    QVector<CurvePtr> result;
+
+    for (int i = 0; i < nCurves && stream.status() == QDataStream::Ok; ++i)
+    {
+        CurvePtr curve = ReadCurve(stream);
+
+        if (curve == nullptr)
+            return false;
+
+        result.push_back(curve);
+    }
+
+    if (stream.status() != QDataStream::Ok)
+        return false;
+
+    curves = result;
+
+    return true;
+}
+
+void DiffusionCurveRenderer::VectorizationCache::StoreCurves(const QByteArray& key, const QVector<CurvePtr>& curves)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+    stream << qint32(curves.size());
+
+    for (const auto& curve : curves)
+        WriteCurve(stream, curve);
+
+    Write(key, payload);
+}
+
+void DiffusionCurveRenderer::VectorizationCache::Clear()
+{
+    QMutexLocker locker(&mMutex);
+
+    for (const auto& file : QDir(mDirectory).entryInfoList({ "*.bin" }, QDir::Files))
+        QFile::remove(file.absoluteFilePath());
+}
+
+bool DiffusionCurveRenderer::VectorizationCache::Read(const QByteArray& key, QByteArray& payload)
+{
+    if (mEnabled == false)
+        return false;
+
+    // Writable, loading a file makes it the most recently used one
+    QFile file(GetPath(key));
+
+    if (file.open(QIODevice::ReadWrite | QIODevice::ExistingOnly) == false)
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic, version;
+    QByteArray storedKey, compressed;
+    stream >> magic >> version >> storedKey >> compressed;
+
+    if (stream.status() != QDataStream::Ok || magic != MAGIC || version != FORMAT_VERSION || storedKey != key)
+    {
+        LOG_WARN("VectorizationCache::Read: Removing '{}', it is corrupt or of another format version.", file.fileName().toStdString());
+        file.remove();
+        return false;
+    }
+
+    payload = qUncompress(compressed);
+
+    if (payload.isEmpty())
+    {
+        LOG_WARN("VectorizationCache::Read: Removing '{}', its payload could not be decompressed.", file.fileName().toStdString());
+        file.remove();
+        return false;
+    }
+
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+
+    return true;
+}
+
+void DiffusionCurveRenderer::VectorizationCache::Write(const QByteArray& key, const QByteArray& payload)
+{
+    if (mEnabled == false)
+        return;
+
+    if (QDir().mkpath(mDirectory) == false)
+    {
+        LOG_WARN("VectorizationCache::Write: Could not create the directory '{}'.", mDirectory.toStdString());
+        return;
+    }
+
+    // Written to a temporary file and renamed, readers never see a partial file
+    QSaveFile file(GetPath(key));
+
+    if (file.open(QIODevice::WriteOnly) == false)
+    {
+        LOG_WARN("VectorizationCache::Write: Could not open '{}'.", file.fileName().toStdString());
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << MAGIC << FORMAT_VERSION << key << qCompress(payload);
+
+    if (file.commit() == false)
+    {
+        LOG_WARN("VectorizationCache::Write: Could not write '{}'.", file.fileName().toStdString());
+        return;
+    }
+
+    Evict();
+}
+
+void DiffusionCurveRenderer::VectorizationCache::Evict()
+{
+    QMutexLocker locker(&mMutex);
+
+    // Most recently used first, everything past the capacity goes
+    const QFileInfoList files = QDir(mDirectory).entryInfoList({ "*.bin" }, QDir::Files, QDir::Time);
+
+    qint64 totalBytes = 0;
+
+    for (const auto& file : files)
+    {
+        totalBytes += file.size();
+
+        if (totalBytes > mCapacity)
+            QFile::remove(file.absoluteFilePath());
+    }
+}
+
+QString DiffusionCurveRenderer::VectorizationCache::GetPath(const QByteArray& key) const
+{
+    return QDir(mDirectory).filePath(QString::fromLatin1(key) + ".bin");
+}
+
+void DiffusionCurveRenderer::VectorizationCache::WriteCurve(QDataStream& stream, const CurvePtr& curve)
+{
+    const auto writeBezierPoints = [&stream](const BezierPtr& bezier) {
+        stream << qint32(bezier->GetColorPoints().size());
+
+        for (const auto& point : bezier->GetColorPoints())
+            stream << quint8(point->type) << point->color << point->position;
+
+        stream << qint32(bezier->GetBlurPoints().size());
+
+        for (const auto& point : bezier->GetBlurPoints())
+            stream << point->position << point->strength;
+    };
+
+    const auto writeControlPoints = [&stream](const CurvePtr& target) {
+        stream << qint32(target->GetControlPoints().size());
+
+        for (const auto& point : target->GetControlPoints())
+            stream << point->position;
+    };
+
+    stream << curve->GetContourColor() << curve->GetContourThickness() << curve->GetDiffusionWidth() << curve->GetDiffusionGap();
+
+    if (const auto bezier = std::dynamic_pointer_cast<Bezier>(curve))
+    {
+        stream << quint8(0);
+        writeControlPoints(bezier);
+        writeBezierPoints(bezier);
+    }
+    else if (const auto spline = std::dynamic_pointer_cast<Spline>(curve))
+    {
+        // Patches follow from the control points, only their color and blur points are stored
+        stream << quint8(1);
+        writeControlPoints(spline);
+        stream << qint32(spline->GetBezierPatches().size());
+
+        for (const auto& patch : spline->GetBezierPatches())
+            writeBezierPoints(patch);
+    }
+    else
+    {
+        DCR_EXIT_FAILURE("VectorizationCache::WriteCurve: Undefined curve type. Implement this branch!");
+    }
+}
+
+DiffusionCurveRenderer::CurvePtr DiffusionCurveRenderer::VectorizationCache::ReadCurve(QDataStream& stream)
+{
+    const auto readBezierPoints = [&stream](const BezierPtr& bezier) {
+        qint32 nColorPoints;
+        stream >> nColorPoints;
+
+        for (int i = 0; i < nColorPoints && stream.status() == QDataStream::Ok; ++i)
+        {
+            quint8 type;
+            QVector4D color;
+            float position;
+            stream >> type >> color >> position;
+            bezier->AddColorPoint(ColorPointType(type), color, position);
+        }
+
+        qint32 nBlurPoints;
+        stream >> nBlurPoints;
+
+        for (int i = 0; i < nBlurPoints && stream.status() == QDataStream::Ok; ++i)
+        {
+            float position, strength;
+            stream >> position >> strength;
+            bezier->AddBlurPoint(position, strength);
+        }
+    };
+
+    const auto readControlPoints = [&stream](const CurvePtr& target) {
+        qint32 nControlPoints;
+        stream >> nControlPoints;
+
+        for (int i = 0; i < nControlPoints && stream.status() == QDataStream::Ok; ++i)
+        {
+            QVector2D position;
+            stream >> position;
+            target->AddControlPoint(position);
+        }
+    };
+
+    QVector4D contourColor;
+    float contourThickness, diffusionWidth, diffusionGap;
+    quint8 type;
+    stream >> contourColor >> contourThickness >> diffusionWidth >> diffusionGap >> type;
+
+    CurvePtr curve;
+
+    if (type == 0)
+    {
+        const auto bezier = std::make_shared<Bezier>();
+        readControlPoints(bezier);
+        readBezierPoints(bezier);
+        curve = bezier;
+    }
+    else if (type == 1)
+    {
+        // Patches are created as Clone() does, then given their points
+        const auto spline = std::make_shared<Spline>();
+        readControlPoints(spline);
+        spline->Update();
+
+        qint32 nPatches;
+        stream >> nPatches;
+
+        if (nPatches != spline->GetBezierPatches().size())
+            return nullptr;
+
+        for (const auto& patch : spline->GetBezierPatches())
+            readBezierPoints(patch);
+
+        curve = spline;
+    }
+
+    if (curve == nullptr || stream.status() != QDataStream::Ok)
+        return nullptr;
+
+    curve->SetContourColor(contourColor);
+    curve->SetContourThickness(contourThickness);
+    curve->SetDiffusionWidth(diffusionWidth);
+    curve->SetDiffusionGap(diffusionGap);
+
+    return curve;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Core/Constants.h"
+#include "Curve/Curve.h"
+#include "Util/Macros.h"
+#include "Vectorization/Stages/Base/PixelChain.h"
+
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <opencv2/core/mat.hpp>
+
+class QDataStream;
+
+namespace DiffusionCurveRenderer
+{
+    /*
+     * Content-addressed store of intermediate vectorization products on disk.
+     *
+     * Every product is a file named after the hash of the image it was computed
+     * from and of the parameters of every stage that led to it, so a changed
+     * parameter is a different file and entries never go stale. A load touches
+     * the file, and the least recently used files are removed once all of them
+     * exceed <Capacity> bytes. Payloads are compressed binary streams.
+     *
+     * Loads and stores are thread safe. Unreadable or foreign files are misses.
+     */
+    class VectorizationCache
+    {
+      public:
+        explicit VectorizationCache(const QString& directory);
+
+        // Hash of the size, type and pixels of <image>, the root of every key
+        static QByteArray HashImage(const cv::Mat& image);
+
+        // Key of a product of <image>, <parameters> describe every stage that led to it
+        static QByteArray MakeKey(const QByteArray& imageHash, const QString& parameters);
+
+        bool LoadEdges(const QByteArray& key, cv::Mat& edges);
+        void StoreEdges(const QByteArray& key, const cv::Mat& edges);
+
+        bool LoadChains(const QByteArray& key, QList<PixelChain>& chains);
+        void StoreChains(const QByteArray& key, const QList<PixelChain>& chains);
+
+        bool LoadPolylines(const QByteArray& key, QVector<QVector<Point>>& polylines);
+        void StorePolylines(const QByteArray& key, const QVector<QVector<Point>>& polylines);
+
+        bool LoadCurves(const QByteArray& key, QVector<CurvePtr>& curves);
+        void StoreCurves(const QByteArray& key, const QVector<CurvePtr>& curves);
+
+        // Removes every file of the cache
+        void Clear();
+
+      private:
+        bool Read(const QByteArray& key, QByteArray& payload);
+        void Write(const QByteArray& key, const QByteArray& payload);
+
+        // Removes the least recently used files until the rest fit into <Capacity>
+        void Evict();
+
+        QString GetPath(const QByteArray& key) const;
+
+        static void WriteCurve(QDataStream& stream, const CurvePtr& curve);
+        static CurvePtr ReadCurve(QDataStream& stream);
+
+        static constexpr quint32 MAGIC = 0x44435643; // "DCVC"
+        // Bump when a stage changes its output, files of older versions are misses
+        static constexpr quint32 FORMAT_VERSION = 3;
+
+        QString mDirectory;
+
+        // Serializes eviction, files are written atomically and need no lock
+        QMutex mMutex;
+
+        DEFINE_MEMBER(bool, Enabled, true);
+        DEFINE_MEMBER(qint64, Capacity, DEFAULT_VECTORIZATION_CACHE_CAPACITY);
+    };
+}
@@ -1,8 +1,15 @@
 #include "VectorizationManager.h"
 
+#include "Core/Constants.h"
+#include "Util/Chronometer.h"
+
 #include <QImage>
+#include <QMutexLocker>
+#include <QStandardPaths>
 #include <QTemporaryDir>
 #include <QThread>
+#include <QThreadPool>
+#include <algorithm>
 #include <opencv2/core.hpp>
 #include <opencv2/core/mat.hpp>
 #include <opencv2/highgui.hpp>
@@ -14,25 +21,43 @@ DiffusionCurveRenderer::VectorizationManager::VectorizationManager(QObject* pare
     , mGaussianStack(this)
     , mEdgeStack(this)
     , mEdgeTracer(this)
+    , mComponentEdgeTracer(this)
     , mPotrace(this)
     , mSplineCurveConstructor(this)
     , mBezierCurveConstructor(this)
     , mColorSampler(this)
+    , mCache(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/Vectorization")
 {
     Setup();
 }
 
 void DiffusionCurveRenderer::VectorizationManager::Setup()
 {
+    for (VectorizationStageBase* stage : std::initializer_list<VectorizationStageBase*>{ &mGaussianStack,
+                                                                                        &mEdgeStack,
+                                                                                        &mEdgeTracer,
+                                                                                        &mComponentEdgeTracer,
+                                                                                        &mPotrace,
+                                                                                        &mSplineCurveConstructor,
+                                                                                        &mBezierCurveConstructor,
+                                                                                        &mColorSampler })
+    {
+        stage->SetCancellationToken(&mCancelRequested);
+    }
+
+    // Both stacks only prepare themselves, their layers are computed on request
     connect(&mGaussianStack, &VectorizationStageBase::ProgressChanged, this, [=](float fraction)
-            { emit ProgressChanged(0.90f * fraction); });
+            { emit ProgressChanged(0.05f * fraction); });
 
     connect(&mEdgeStack, &VectorizationStageBase::ProgressChanged, this, [=](float fraction)
-            { emit ProgressChanged(0.90f + 0.10f * fraction); });
+            { emit ProgressChanged(0.05f + 0.95f * fraction); });
 
     connect(&mEdgeTracer, &VectorizationStageBase::ProgressChanged, this, [=](float fraction)
             { emit ProgressChanged(0.40f * fraction); });
 
+    connect(&mComponentEdgeTracer, &VectorizationStageBase::ProgressChanged, this, [=](float fraction)
+            { emit ProgressChanged(0.40f * fraction); });
+
     connect(&mPotrace, &VectorizationStageBase::ProgressChanged, this, [=](float fraction)
             { emit ProgressChanged(0.40f + 0.20f * fraction); });
 
@@ -51,10 +76,14 @@ void DiffusionCurveRenderer::VectorizationManager::Reset()
     mGaussianStack.Reset();
     mEdgeStack.Reset();
     mEdgeTracer.Reset();
+    mComponentEdgeTracer.Reset();
     mPotrace.Reset();
     mSplineCurveConstructor.Reset();
     mBezierCurveConstructor.Reset();
     mColorSampler.Reset();
+
+    QMutexLocker locker(&mImageMutex);
+    mCannyEdges.release();
 }
 
 void DiffusionCurveRenderer::VectorizationManager::LoadImage(const QString& path)
@@ -62,11 +91,30 @@ void DiffusionCurveRenderer::VectorizationManager::LoadImage(const QString& path
     qDebug() << "VectorizationManager::LoadImage: Current Thread: " << QThread::currentThread();
     qDebug() << "VectorizationManager::LoadImage: Path:" << path;
 
-    mOriginalImage = cv::imread(path.toStdString(), cv::IMREAD_COLOR);
+    // Images of the previous one still queued are not needed anymore
+    ++mLatestImageRequest;
+
+    // Raised by the Cancel() that precedes every load, nothing of the previous image is running anymore
+    mCancelRequested = false;
+
+    cv::Mat image = cv::imread(path.toStdString(), cv::IMREAD_COLOR);
 
-    emit ImageLoaded(mOriginalImage);
+    {
+        QMutexLocker locker(&mImageMutex);
+        mOriginalImage = image;
+        mCannyEdges.release();
+    }
+
+    const QByteArray hash = VectorizationCache::HashImage(image);
+
+    emit ImageLoaded(image);
 
     Prepare();
+
+    // Edges computed from now on belong to this image, until the next Prepare()
+    QMutexLocker locker(&mImageMutex);
+    mImageHash = hash;
+    mEdgeStackGeneration = mEdgeStack.GetGeneration();
 }
 
 void DiffusionCurveRenderer::VectorizationManager::Prepare()
@@ -75,20 +123,60 @@ void DiffusionCurveRenderer::VectorizationManager::Prepare()
 
     SetVectorizationStage(VectorizationStage::Initial);
 
-    cv::Canny(mOriginalImage, mCannyEdges, mCannyUpperThreshold, mCannyLowerThreshold);
-
+    // Both stacks are lazy, layers are computed when the GUI or Vectorize() requests them
     SetVectorizationStage(VectorizationStage::GaussianStack);
-    mGaussianStack.Run(mOriginalImage);
+    {
+        MEASURE_CALL_TIME(VECTORIZATION_GAUSSIAN_STACK);
+        mGaussianStack.Run(mOriginalImage, mStdDevCutoff, mMaximumStackHeight, mSigmaStep);
+    }
     emit VectorizationStageFinished(VectorizationStage::GaussianStack, mGaussianStack.GetHeight() - 1);
 
     SetVectorizationStage(VectorizationStage::EdgeStack);
-    mEdgeStack.Run(&mGaussianStack, mCannyLowerThreshold, mCannyUpperThreshold);
+    {
+        MEASURE_CALL_TIME(VECTORIZATION_EDGE_STACK);
+        mEdgeStack.Run(&mGaussianStack, mCannyLowerThreshold, mCannyUpperThreshold);
+    }
     emit VectorizationStageFinished(VectorizationStage::EdgeStack, mEdgeStack.GetHeight() - 1);
 }
 
-void DiffusionCurveRenderer::VectorizationManager::Vectorize(VectorizationCurveType curveType, int edgeLevel)
+void DiffusionCurveRenderer::VectorizationManager::RequestVectorization(VectorizationCurveType curveType, EdgeTracerType tracerType, int edgeLevel)
+{
+    const int request = ++mLatestVectorizationRequest;
+    mCancelRequested = true;
+
+    QMetaObject::invokeMethod(
+        this,
+        [=]() {
+            // Cleared before the check, a Cancel() in between either drops this request or stops it later
+            mCancelRequested = false;
+
+            if (request != mLatestVectorizationRequest)
+                return;
+
+            Vectorize(curveType, tracerType, edgeLevel);
+        },
+        Qt::QueuedConnection);
+}
+
+void DiffusionCurveRenderer::VectorizationManager::Cancel()
+{
+    const int request = ++mLatestVectorizationRequest;
+    mCancelRequested = true;
+
+    // Runs once the cancelled vectorization has returned, or right away if none was running
+    QMetaObject::invokeMethod(
+        this,
+        [=]() {
+            if (request == mLatestVectorizationRequest)
+                mCancelRequested = false;
+        },
+        Qt::QueuedConnection);
+}
+
+void DiffusionCurveRenderer::VectorizationManager::Vectorize(VectorizationCurveType curveType, EdgeTracerType tracerType, int edgeLevel)
 {
     mEdgeTracer.Reset();
+    mComponentEdgeTracer.Reset();
     mPotrace.Reset();
     mSplineCurveConstructor.Reset();
     mBezierCurveConstructor.Reset();
@@ -97,18 +185,89 @@ void DiffusionCurveRenderer::VectorizationManager::Vectorize(VectorizationCurveT
     qDebug() << "VectorizationManager::LoadImage: Current Thread: " << QThread::currentThread();
     qDebug() << "VectorizationManager::LoadImage: Chosen Edge Level:" << edgeLevel;
 
-    SetVectorizationStage(VectorizationStage::EdgeTracer);
-    mEdgeTracer.Run(mEdgeStack.GetLayer(edgeLevel), 10);
-    emit VectorizationStageFinished(VectorizationStage::EdgeTracer);
+    // Products are keyed by the parameters of every stage that led to them. Both tracers return the same chains.
+    const QString chainParameters = GetEdgeParameters(edgeLevel) + QString(";chains:%1").arg(mChainLengthThreshold);
+    const QString polylineParameters = chainParameters + ";polylines";
+    const QString curveParameters = polylineParameters + QString(";curves:%1,%2,%3").arg(int(curveType)).arg(mSampleDensity, 0, 'g', 17).arg(mColorSampler.GetSeed());
+
+    const QByteArray chainKey = VectorizationCache::MakeKey(mImageHash, chainParameters);
+    const QByteArray polylineKey = VectorizationCache::MakeKey(mImageHash, polylineParameters);
+    const QByteArray curveKey = VectorizationCache::MakeKey(mImageHash, curveParameters);
+
+    // Every stage is skipped if its product, or that of a later stage, is cached
+    QVector<CurvePtr> curves;
 
-    qInfo() << "Chains detected."
-            << "Number of chains is:" << mEdgeTracer.GetChains().size();
+    if (mCache.LoadCurves(curveKey, curves))
+    {
+        qInfo() << "Curves loaded from the cache."
+                << "Number of curves is:" << curves.size();
+
+        SetVectorizationStage(VectorizationStage::Finished);
+
+        emit VectorizationFinished(curves);
+        return;
+    }
 
-    SetVectorizationStage(VectorizationStage::Potrace);
-    mPotrace.Run(mEdgeTracer.GetChains());
-    emit VectorizationStageFinished(VectorizationStage::Potrace);
+    QVector<QVector<Point>> polylines;
 
-    qInfo() << "Number of polylines is:" << mPotrace.GetPolylines().size();
+    if (mCache.LoadPolylines(polylineKey, polylines) == false)
+    {
+        QList<PixelChain> chains;
+
+        if (mCache.LoadChains(chainKey, chains) == false)
+        {
+            // Only the chosen level is computed, unless it has been viewed or cached before
+            cv::Mat edges;
+            {
+                MEASURE_CALL_TIME(VECTORIZATION_EDGE_STACK);
+                edges = GetEdgeStackLayer(edgeLevel);
+            }
+
+            if (edges.empty())
+            {
+                LOG_WARN("VectorizationManager::Vectorize: There is no edge level {}.", edgeLevel);
+                SetVectorizationStage(VectorizationStage::EdgeStack);
+                return;
+            }
+
+            SetVectorizationStage(VectorizationStage::EdgeTracer);
+            {
+                MEASURE_CALL_TIME(VECTORIZATION_EDGE_TRACER);
+
+                if (tracerType == EdgeTracerType::Components)
+                    mComponentEdgeTracer.Run(edges, mChainLengthThreshold);
+                else
+                    mEdgeTracer.Run(edges, mChainLengthThreshold);
+            }
+
+            if (StopIfCancelled())
+                return;
+
+            emit VectorizationStageFinished(VectorizationStage::EdgeTracer);
+
+            chains = tracerType == EdgeTracerType::Components ? mComponentEdgeTracer.GetChains() : mEdgeTracer.GetChains();
+            mCache.StoreChains(chainKey, chains);
+        }
+
+        qInfo() << "Chains detected."
+                << "Number of chains is:" << chains.size();
+
+        SetVectorizationStage(VectorizationStage::Potrace);
+        {
+            MEASURE_CALL_TIME(VECTORIZATION_POTRACE);
+            mPotrace.Run(chains);
+        }
+
+        if (StopIfCancelled())
+            return;
+
+        emit VectorizationStageFinished(VectorizationStage::Potrace);
+
+        polylines = mPotrace.GetPolylines();
+        mCache.StorePolylines(polylineKey, polylines);
+    }
+
+    qInfo() << "Number of polylines is:" << polylines.size();
 
     mCurrentCurveConstructor = nullptr;
 
@@ -120,19 +279,211 @@ void DiffusionCurveRenderer::VectorizationManager::Vectorize(VectorizationCurveT
     DCR_ASSERT(mCurrentCurveConstructor != nullptr);
 
     SetVectorizationStage(VectorizationStage::CurveContructor);
-    mCurrentCurveConstructor->Run(mPotrace.GetPolylines());
+    {
+        MEASURE_CALL_TIME(VECTORIZATION_CURVE_CONSTRUCTOR);
+        mCurrentCurveConstructor->Run(polylines);
+    }
+
+    if (StopIfCancelled())
+        return;
+
     emit VectorizationStageFinished(VectorizationStage::CurveContructor);
 
     cv::Mat imageLAB;
     cv::cvtColor(mOriginalImage, imageLAB, cv::COLOR_BGR2Lab);
 
     SetVectorizationStage(VectorizationStage::ColorSampler);
-    mColorSampler.Run(mCurrentCurveConstructor->GetCurves(), mOriginalImage, imageLAB, 0.05);
+    {
+        MEASURE_CALL_TIME(VECTORIZATION_COLOR_SAMPLER);
+        mColorSampler.Run(mCurrentCurveConstructor->GetCurves(), mOriginalImage, imageLAB, mSampleDensity);
+    }
+
+    if (StopIfCancelled())
+        return;
+
     emit VectorizationStageFinished(VectorizationStage::ColorSampler);
 
+    curves = mCurrentCurveConstructor->GetCurves();
+    mCache.StoreCurves(curveKey, curves);
+
     SetVectorizationStage(VectorizationStage::Finished);
 
-    emit VectorizationFinished(mCurrentCurveConstructor->GetCurves());
+    emit VectorizationFinished(curves);
+}
+
+cv::Mat DiffusionCurveRenderer::VectorizationManager::GetEdgeStackLayer(int index)
+{
+    if (mEdgeStack.HasLayer(index))
+        return mEdgeStack.GetLayer(index);
+
+    // A LoadImage() on the thread of the manager may replace both while the layer is loaded or computed
+    QByteArray imageHash;
+    int generation;
+
+    {
+        QMutexLocker locker(&mImageMutex);
+        imageHash = mImageHash;
+        generation = mEdgeStackGeneration;
+    }
+
+    const QByteArray key = VectorizationCache::MakeKey(imageHash, GetEdgeParameters(index));
+
+    cv::Mat edges;
+
+    if (mCache.LoadEdges(key, edges))
+    {
+        // Dropped if the stack belongs to another image by now
+        mEdgeStack.SetLayer(index, edges, generation);
+        return edges;
+    }
+
+    int edgesGeneration;
+    edges = mEdgeStack.GetLayer(index, &edgesGeneration);
+
+    // Edges of another image must not be stored under the key of this one
+    if (!edges.empty() && edgesGeneration == generation)
+        mCache.StoreEdges(key, edges);
+
+    return edges;
+}
+
+QString DiffusionCurveRenderer::VectorizationManager::GetEdgeParameters(int edgeLevel) const
+{
+    return QString("edges:%1,%2,%3,%4,%5,%6")
+        .arg(mStdDevCutoff, 0, 'g', 17)
+        .arg(mMaximumStackHeight)
+        .arg(mSigmaStep, 0, 'g', 17)
+        .arg(mCannyLowerThreshold, 0, 'g', 17)
+        .arg(mCannyUpperThreshold, 0, 'g', 17)
+        .arg(edgeLevel);
+}
+
+bool DiffusionCurveRenderer::VectorizationManager::StopIfCancelled()
+{
+    if (!mCancelRequested)
+        return false;
+
+    LOG_INFO("VectorizationManager::StopIfCancelled: Vectorization cancelled in stage {}.", int(mVectorizationStage));
+
+    // The run has stopped, later requests lower it themselves as well
+    mCancelRequested = false;
+
+    // The stacks are kept, the partial results are reset by the next vectorization
+    SetVectorizationStage(VectorizationStage::EdgeStack);
+    emit ProgressChanged(0.0f);
+
+    return true;
+}
+
+cv::Mat DiffusionCurveRenderer::VectorizationManager::GetOriginalImage()
+{
+    QMutexLocker locker(&mImageMutex);
+
+    return mOriginalImage;
+}
+
+cv::Mat DiffusionCurveRenderer::VectorizationManager::GetCannyEdges()
+{
+    QMutexLocker locker(&mImageMutex);
+
+    if (mCannyEdges.empty() && !mOriginalImage.empty())
+    {
+        MEASURE_CALL_TIME(VECTORIZATION_CANNY);
+        cv::Canny(mOriginalImage, mCannyEdges, mCannyUpperThreshold, mCannyLowerThreshold);
+    }
+
+    return mCannyEdges;
+}
+
+void DiffusionCurveRenderer::VectorizationManager::RequestImage(VectorizationViewOption option, int layer)
+{
+    const int request = ++mLatestImageRequest;
+
+    QThreadPool::globalInstance()->start([=]() {
+        // Superseded while waiting for a thread, e.g. while the layer slider is dragged
+        if (request != mLatestImageRequest)
+            return;
+
+        cv::Mat image;
+
+        switch (option)
+        {
+            case VectorizationViewOption::ViewOriginalImage:
+                return;
+            case VectorizationViewOption::ViewEdges:
+                image = GetCannyEdges();
+                break;
+            // The stacks check the layer under the lock they compute it under, they may be reset meanwhile
+            case VectorizationViewOption::ViewGaussianStack:
+                image = mGaussianStack.GetLayer(layer);
+                break;
+            case VectorizationViewOption::ChooseEdgeStackLevel:
+                image = GetEdgeStackLayer(layer);
+                break;
+        }
+
+        // An image loaded meanwhile supersedes the request as well
+        if (image.empty() || request != mLatestImageRequest)
+            return;
+
+        emit ImageReady(option, layer, image);
+
+        if (option == VectorizationViewOption::ChooseEdgeStackLevel)
+            PrefetchEdgeStackLayers(layer, request);
+    });
+}
+
+void DiffusionCurveRenderer::VectorizationManager::PrefetchEdgeStackLayers(int layer, int request)
+{
+    const int first = std::max(0, layer - EDGE_STACK_PREFETCH_RADIUS);
+    const int last = std::min(mEdgeStack.GetHeight() - 1, layer + EDGE_STACK_PREFETCH_RADIUS);
+
+    QByteArray imageHash;
+    int generation;
+
+    {
+        QMutexLocker locker(&mImageMutex);
+        imageHash = mImageHash;
+        generation = mEdgeStackGeneration;
+    }
+
+    // Cached levels are loaded, the others are computed together so their Canny runs in parallel
+    QVector<int> computed;
+
+    for (int index = first; index <= last; ++index)
+    {
+        if (request != mLatestImageRequest)
+            return;
+
+        if (mEdgeStack.HasLayer(index))
+            continue;
+
+        cv::Mat edges;
+
+        if (mCache.LoadEdges(VectorizationCache::MakeKey(imageHash, GetEdgeParameters(index)), edges))
+            mEdgeStack.SetLayer(index, edges, generation);
+        else
+            computed.push_back(index);
+    }
+
+    if (computed.isEmpty() || request != mLatestImageRequest)
+        return;
+
+    // Superseded by newer image requests, not by the vectorization token, which belongs to Vectorize()
+    mEdgeStack.Precompute(computed.first(), computed.last(), [&]() { return request != mLatestImageRequest; });
+
+    for (const int index : computed)
+    {
+        // Skipped if the prefetch was cancelled, it is not worth computing now
+        if (!mEdgeStack.HasLayer(index))
+            continue;
+
+        int edgesGeneration;
+        const cv::Mat edges = mEdgeStack.GetLayer(index, &edgesGeneration);
+
+        if (!edges.empty() && edgesGeneration == generation)
+            mCache.StoreEdges(VectorizationCache::MakeKey(imageHash, GetEdgeParameters(index)), edges);
+    }
 }
 
 void DiffusionCurveRenderer::VectorizationManager::SetVectorizationStage(VectorizationStage stage)
@@ -4,14 +4,18 @@
 #include "Util/Logger.h"
 #include "Util/Macros.h"
 #include "Vectorization/Stages/ColorSampler/ColorSampler.h"
+#include "Vectorization/Stages/ComponentEdgeTracer/ComponentEdgeTracer.h"
 #include "Vectorization/Stages/CurveConstructor/BezierCurveConstructor.h"
 #include "Vectorization/Stages/CurveConstructor/SplineCurveConstructor.h"
 #include "Vectorization/Stages/EdgeStack/EdgeStack.h"
 #include "Vectorization/Stages/EdgeTracer/EdgeTracer.h"
 #include "Vectorization/Stages/Potrace/Potrace.h"
+#include "Vectorization/VectorizationCache.h"
 
+#include <QMutex>
 #include <QObject>
 #include <QVariant>
+#include <atomic>
 #include <opencv2/core/mat.hpp>
 
 namespace DiffusionCurveRenderer
@@ -25,10 +29,29 @@ namespace DiffusionCurveRenderer
         explicit VectorizationManager(QObject* parent = nullptr);
 
         void LoadImage(const QString& path);
-        void Vectorize(VectorizationCurveType curveType, int edgeLevel);
 
+        // Thread safe. Queues a vectorization of the loaded image on the thread of the manager. A request supersedes
+        // the earlier ones, the running vectorization is cancelled and those that have not started yet are dropped.
+        void RequestVectorization(VectorizationCurveType curveType, EdgeTracerType tracerType, int edgeLevel);
+
+        // Thread safe. Stops the running vectorization after the item its stages are working on, drops queued ones.
+        // Call it directly, not through a queued connection, since the thread of the manager is busy vectorizing.
+        void Cancel();
+
+        // Thread safe
+        cv::Mat GetOriginalImage();
         cv::Mat GetGaussianStackLayer(int index) { return mGaussianStack.GetLayer(index); }
-        cv::Mat GetEdgeStackLayer(int index) { return mEdgeStack.GetLayer(index); }
+        // Thread safe. Loads the layer from the cache or computes and stores it, unless it has been requested before.
+        cv::Mat GetEdgeStackLayer(int index);
+        cv::Mat GetCannyEdges();
+
+        // Thread safe. Computes the image shown for option (and layer) on the global thread pool and emits ImageReady.
+        // A request supersedes the earlier ones, those that have not started yet are dropped.
+        void RequestImage(VectorizationViewOption option, int layer);
+
+        // Thread safe. Bytes the Gaussian stack may keep, see GaussianStack::SetMemoryBudget().
+        void SetGaussianStackMemoryBudget(size_t bytes) { mGaussianStack.SetMemoryBudget(bytes); }
+        size_t GetGaussianStackMemoryBudget() { return mGaussianStack.GetMemoryBudget(); }
 
       signals:
         void ImageLoaded(cv::Mat image);
@@ -36,31 +59,66 @@ namespace DiffusionCurveRenderer
         void VectorizationStageChanged(VectorizationStage stage);
         void VectorizationStageFinished(VectorizationStage stage, QVariant additionalData = QVariant());
         void VectorizationFinished(const QVector<CurvePtr>& curves);
+        void ImageReady(VectorizationViewOption option, int layer, cv::Mat image);
 
       private:
         void Setup();
         void Reset();
         void Prepare();
+        void Vectorize(VectorizationCurveType curveType, EdgeTracerType tracerType, int edgeLevel);
+
+        // Returns to the choice of the edge level if the vectorization was cancelled
+        bool StopIfCancelled();
+
+        // Parameters that determine the edges of a level, the root of the cache keys of every product
+        QString GetEdgeParameters(int edgeLevel) const;
+
+        // Loads or computes the edge levels around the one shown while the slider is at it. Runs on the thread pool.
+        void PrefetchEdgeStackLayers(int layer, int request);
 
         void SetVectorizationStage(VectorizationStage state);
 
-        DEFINE_MEMBER_CONST(cv::Mat, OriginalImage);
+        // Written on the thread of the manager, read from the GUI and the thread pool under mImageMutex
+        cv::Mat mOriginalImage;
 
-        // Edges
-        DEFINE_MEMBER_CONST(cv::Mat, CannyEdges);
+        // Edges of the original image, computed on first request
+        cv::Mat mCannyEdges;
+        QMutex mImageMutex;
         float mCannyUpperThreshold{ 200.0f };
         float mCannyLowerThreshold{ 20.0f };
+        double mStdDevCutoff{ 40.0 };
+        int mMaximumStackHeight{ 60 };
+        double mSigmaStep{ 0.4 };
+        int mChainLengthThreshold{ 10 };
+        double mSampleDensity{ 0.05 };
 
         VectorizationStage mVectorizationStage{ VectorizationStage::Initial };
 
         GaussianStack mGaussianStack;
         EdgeStack mEdgeStack;
         EdgeTracer mEdgeTracer;
+        ComponentEdgeTracer mComponentEdgeTracer;
         Potrace mPotrace;
         SplineCurveConstructor mSplineCurveConstructor;
         BezierCurveConstructor mBezierCurveConstructor;
         ColorSampler mColorSampler;
 
         CurveConstructor* mCurrentCurveConstructor{ nullptr };
+
+        // Products of earlier runs on disk, keyed by the hash of the original image and the parameters
+        VectorizationCache mCache;
+
+        // Hash of the image the edge stack was prepared from and the generation of the stack it was prepared at.
+        // Updated together under mImageMutex after Prepare(), edges of any other generation are not cached under it.
+        QByteArray mImageHash;
+        int mEdgeStackGeneration{ -1 };
+
+        std::atomic_int mLatestImageRequest{ 0 };
+        std::atomic_int mLatestVectorizationRequest{ 0 };
+
+        // Cancellation token of every stage. Any thread may raise it through RequestVectorization() and Cancel(), only
+        // the thread of the manager lowers it: when a cancelled run stops, before a queued request starts, after a
+        // Cancel() has been processed and when an image is loaded. Stages only read it.
+        std::atomic_bool mCancelRequested{ false };
     };
 }
\ No newline at end of file
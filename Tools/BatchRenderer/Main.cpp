@@ -0,0 +1,327 @@
+#include "Core/Constants.h"
+#include "Core/CurveContainer.h"
+#include "Core/OffscreenContext.h"
+#include "Core/OrthographicCamera.h"
+#include "Renderer/DiffusionRenderer/Solvers/DiffusionSolverFactory.h"
+#include "Renderer/RendererManager.h"
+#include "Renderer/TiledExporter/DeepZoomExporter.h"
+#include "Renderer/TiledExporter/TiledExporter.h"
+#include "Util/Importer.h"
+#include "Util/Logger.h"
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <algorithm>
+
+using namespace DiffusionCurveRenderer;
+
+namespace
+{
+    struct Job
+    {
+        QString input;
+        QString output;
+    };
+
+    QString DefaultOutputPath(const QString& input, const QString& outputDirectory, const QString& format)
+    {
+        const QFileInfo info(input);
+        const QString directory = outputDirectory.isEmpty() ? info.absolutePath() : outputDirectory;
+        return QDir(directory).filePath(info.completeBaseName() + "." + format);
+    }
+
+    bool ReadJobList(const QString& path, const QString& outputDirectory, const QString& format, QVector<Job>& jobs)
+    {
+        QFile file(path);
+
+        if (file.open(QIODevice::ReadOnly | QIODevice::Text) == false)
+        {
+            LOG_FATAL("ReadJobList: Could not open job list '{}'.", path.toStdString());
+            return false;
+        }
+
+        // Each line is "<input> [<output>]", empty lines and lines starting with '#' are skipped
+        QTextStream stream(&file);
+
+        while (stream.atEnd() == false)
+        {
+            const QString line = stream.readLine().trimmed();
+
+            if (line.isEmpty() || line.startsWith('#'))
+                continue;
+
+            const QStringList tokens = line.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+
+            Job job;
+            job.input = tokens[0];
+            job.output = tokens.size() > 1 ? tokens[1] : DefaultOutputPath(job.input, outputDirectory, format);
+            jobs.push_back(job);
+        }
+
+        return true;
+    }
+
+    QVector<CurvePtr> Import(const QString& path)
+    {
+        if (path.endsWith(".json", Qt::CaseInsensitive))
+            return Importer::ImportFromJson(path);
+
+        return Importer::ImportFromXml(path);
+    }
+
+    void FitToCurves(OrthographicCamera& camera, const CurveContainer& container)
+    {
+        const QRectF box = container.GetBoundingBox();
+
+        if (box.isNull())
+            return;
+
+        const float width = camera.GetWidth();
+        const float height = camera.GetHeight();
+        const float zoom = std::max(box.width() / width, box.height() / height);
+
+        camera.SetZoom(zoom);
+        camera.SetLeft(box.center().x() - 0.5f * width * zoom);
+        camera.SetTop(box.center().y() - 0.5f * height * zoom);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // Headless by default, an explicit QT_QPA_PLATFORM (e.g. xcb under xvfb-run) still wins
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QGuiApplication app(argc, argv);
+
+    qInstallMessageHandler(Logger::QtMessageOutputCallback);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders diffusion curve scenes (.xml or .json) to PNG or TIFF images without a window.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("scenes", "Scene files to render.", "[scenes...]");
+
+    QCommandLineOption jobsOption("jobs", "Reads jobs from <file>, one '<input> [<output>]' per line.", "file");
+    QCommandLineOption outputDirectoryOption("output-dir", "Writes images into <dir> instead of next to the scene files.", "dir");
+    QCommandLineOption widthOption("width", "Image width in pixels.", "pixels", QString::number(INITIAL_WIDTH));
+    QCommandLineOption heightOption("height", "Image height in pixels.", "pixels", QString::number(INITIAL_HEIGHT));
+    QCommandLineOption iterationsOption("iterations", "Number of smoothing iterations.", "count", QString::number(DEFAULT_SMOOTH_ITERATIONS));
+    QCommandLineOption framebufferSizeOption("framebuffer-size", "Size of the diffusion framebuffer.", "pixels", QString::number(DEFAULT_FRAMEBUFFER_SIZE));
+    QCommandLineOption modeOption("mode", "What to render: diffusion, contour or both.", "mode", "diffusion");
+    QCommandLineOption solverOption("solver", "Diffusion solver: gpu, cpu or pcg.", "name", "gpu");
+    QCommandLineOption fitOption("fit", "Fits the camera to the bounding box of the curves instead of using scene coordinates.");
+    QCommandLineOption formatOption("format", "Output format: png, tif or dzi (Deep Zoom tiles for web viewers).", "format", "png");
+    QCommandLineOption tiledOption("tiled", "Solves the diffusion in tiles at full image resolution, for very large images.");
+    QCommandLineOption tileSizeOption("tile-size", "Tile size for --tiled and the render window size for dzi, a power of two.", "pixels", "2048");
+    QCommandLineOption tileOverlapOption("tile-overlap", "Pixels shared by neighboring tiles for --tiled and dzi.", "pixels", "128");
+
+    parser.addOptions({ jobsOption, outputDirectoryOption, widthOption, heightOption, iterationsOption, framebufferSizeOption, modeOption, solverOption, fitOption, formatOption, tiledOption, tileSizeOption, tileOverlapOption });
+    parser.process(app);
+
+    const QString outputDirectory = parser.value(outputDirectoryOption);
+    const int width = parser.value(widthOption).toInt();
+    const int height = parser.value(heightOption).toInt();
+    const int iterations = parser.value(iterationsOption).toInt();
+    const int framebufferSize = parser.value(framebufferSizeOption).toInt();
+    const QString mode = parser.value(modeOption);
+    const QString format = parser.value(formatOption);
+    const bool tiled = parser.isSet(tiledOption);
+
+    if (width <= 0 || height <= 0 || iterations < 0 || framebufferSize <= 0)
+    {
+        LOG_FATAL("main: Invalid image size, iteration count or framebuffer size.");
+        return 1;
+    }
+
+    RenderModes renderModes;
+
+    if (mode == "diffusion")
+        renderModes = RenderMode::Diffusion;
+    else if (mode == "contour")
+        renderModes = RenderMode::Contour;
+    else if (mode == "both")
+        renderModes = RenderMode::Diffusion | RenderMode::Contour;
+    else
+    {
+        LOG_FATAL("main: Unknown render mode '{}'.", mode.toStdString());
+        return 1;
+    }
+
+    if (format != "png" && format != "tif" && format != "dzi")
+    {
+        LOG_FATAL("main: Unknown format '{}'.", format.toStdString());
+        return 1;
+    }
+
+    DiffusionSolverType solverType;
+
+    if (DiffusionSolverFactory::FromName(parser.value(solverOption), solverType) == false)
+    {
+        LOG_FATAL("main: Unknown solver '{}'.", parser.value(solverOption).toStdString());
+        return 1;
+    }
+
+    QVector<Job> jobs;
+
+    for (const auto& input : parser.positionalArguments())
+        jobs.push_back({ input, DefaultOutputPath(input, outputDirectory, format) });
+
+    if (parser.isSet(jobsOption) && ReadJobList(parser.value(jobsOption), outputDirectory, format, jobs) == false)
+        return 1;
+
+    if (jobs.isEmpty())
+    {
+        parser.showHelp(1);
+    }
+
+    if (outputDirectory.isEmpty() == false)
+        QDir().mkpath(outputDirectory);
+
+    // One context and one set of renderers for all jobs, shaders are compiled only once
+    OffscreenContext context;
+
+    if (context.Initialize() == false)
+        return 1;
+
+    OrthographicCamera camera;
+    CurveContainer container;
+
+    RendererManager manager;
+    manager.SetCamera(&camera);
+    manager.SetCurveContainer(&container);
+    manager.Initialize();
+    manager.SetFramebufferSize(framebufferSize);
+    manager.SetSmoothIterations(iterations);
+    manager.SetDiffusionSolverType(solverType);
+
+    TiledExporter exporter;
+    exporter.SetCamera(&camera);
+    exporter.SetCurveContainer(&container);
+    exporter.SetTileSize(parser.value(tileSizeOption).toInt());
+    exporter.SetTileOverlap(parser.value(tileOverlapOption).toInt());
+    exporter.SetSmoothIterations(iterations);
+    exporter.SetSolverType(solverType);
+
+    DeepZoomExporter deepZoomExporter;
+    deepZoomExporter.SetCamera(&camera);
+    deepZoomExporter.SetCurveContainer(&container);
+    deepZoomExporter.SetWindowSize(parser.value(tileSizeOption).toInt());
+    deepZoomExporter.SetWindowOverlap(parser.value(tileOverlapOption).toInt());
+    deepZoomExporter.SetSmoothIterations(iterations);
+    deepZoomExporter.SetSolverType(solverType);
+
+    if (tiled)
+        exporter.Initialize();
+
+    if (format == "dzi")
+        deepZoomExporter.Initialize();
+
+    int failures = 0;
+
+    for (const auto& job : jobs)
+    {
+        // Importer treats unreadable files as fatal, so check up front to keep the batch going
+        if (QFileInfo(job.input).isReadable() == false)
+        {
+            LOG_WARN("main: Skipping '{}', file is not readable.", job.input.toStdString());
+            ++failures;
+            continue;
+        }
+
+        container.Clear();
+        container.AddCurves(Import(job.input));
+
+        camera.Resize(width, height, 1.0f);
+        camera.Reset();
+
+        if (parser.isSet(fitOption))
+            FitToCurves(camera, container);
+
+        if (format == "dzi")
+        {
+            if (deepZoomExporter.Start(job.output, width, height, renderModes) == false)
+            {
+                ++failures;
+                continue;
+            }
+
+            int reported = 0;
+
+            // Every step draws like a frame, the GPU timer recycles its queries at frame boundaries
+            while (true)
+            {
+                manager.BeginFrame();
+
+                if (deepZoomExporter.Step() == false)
+                    break;
+
+                const int percent = int(100 * deepZoomExporter.GetProgress());
+
+                if (percent >= reported + 10)
+                {
+                    LOG_INFO("main: '{}' {}%", job.output.toStdString(), percent);
+                    reported = percent;
+                }
+            }
+
+            if (deepZoomExporter.GetLastExportSucceeded() == false)
+            {
+                ++failures;
+                continue;
+            }
+        }
+        else if (tiled)
+        {
+            if (exporter.Start(job.output, width, height, renderModes) == false)
+            {
+                ++failures;
+                continue;
+            }
+
+            int reported = 0;
+
+            // Every step draws like a frame, the GPU timer recycles its queries at frame boundaries
+            while (true)
+            {
+                manager.BeginFrame();
+
+                if (exporter.Step() == false)
+                    break;
+
+                const int percent = int(100 * exporter.GetProgress());
+
+                if (percent >= reported + 10)
+                {
+                    LOG_INFO("main: '{}' {}%", job.output.toStdString(), percent);
+                    reported = percent;
+                }
+            }
+
+            if (exporter.GetLastExportSucceeded() == false)
+            {
+                ++failures;
+                continue;
+            }
+        }
+        else
+        {
+            manager.BeginFrame();
+
+            if (manager.Save(job.output, renderModes) == false)
+            {
+                LOG_WARN("main: Could not render '{}' to '{}'.", job.input.toStdString(), job.output.toStdString());
+                ++failures;
+                continue;
+            }
+        }
+
+        LOG_INFO("main: '{}' -> '{}' ({} curves)", job.input.toStdString(), job.output.toStdString(), container.GetTotalNumberOfCurves());
+    }
+
+    return failures == 0 ? 0 : 2;
+}
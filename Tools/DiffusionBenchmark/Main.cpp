@@ -0,0 +1,380 @@
+#include "Core/Constants.h"
+#include "Core/CurveContainer.h"
+#include "Core/OffscreenContext.h"
+#include "Core/OrthographicCamera.h"
+#include "Renderer/DiffusionRenderer/Solvers/CpuDiffusionSolver.h"
+#include "Renderer/DiffusionRenderer/Solvers/DiffusionSolverFactory.h"
+#include "Util/Importer.h"
+#include "Util/Logger.h"
+#include "Util/Parallel.h"
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QTextStream>
+#include <QThread>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <opencv2/core.hpp>
+
+using namespace DiffusionCurveRenderer;
+
+namespace
+{
+    struct Settings
+    {
+        QStringList scenes;
+        QVector<int> sizes;
+        QVector<DiffusionSolverType> solvers;
+        int iterations;
+        int referenceIterations;
+        int repeats;
+        int maxThreads;
+        double tolerance;
+        QString csvPath;
+    };
+
+    struct Measurement
+    {
+        double milliseconds;
+        SolveStats stats;
+        double residual;
+        double psnr;
+    };
+
+    // Fits the scene into a square view, so that the whole framebuffer carries content
+    void SetUpCamera(OrthographicCamera& camera, const CurveContainer& container, int size)
+    {
+        camera.Resize(size, size, 1.0f);
+        camera.Reset();
+
+        const QRectF box = container.GetBoundingBox();
+
+        if (box.isNull())
+            return;
+
+        const float zoom = std::max(box.width(), box.height()) / size;
+        camera.SetZoom(zoom);
+        camera.SetLeft(box.center().x() - 0.5f * size * zoom);
+        camera.SetTop(box.center().y() - 0.5f * size * zoom);
+    }
+
+    double ComputePsnr(const cv::Mat& image, const cv::Mat& reference)
+    {
+        const double mse = cv::norm(image, reference, cv::NORM_L2SQR) / (double(image.total()) * image.channels());
+        return mse > 0.0 ? 10.0 * std::log10(1.0 / mse) : INFINITY;
+    }
+
+    Measurement Measure(DiffusionSolver& solver, int repeats, const cv::Mat& reference)
+    {
+        // Warm up, the first solve allocates the pyramid
+        solver.Solve();
+        solver.Finish();
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < repeats; ++i)
+        {
+            solver.Solve();
+        }
+
+        solver.Finish();
+
+        const auto end = std::chrono::steady_clock::now();
+
+        const cv::Mat result = solver.GetResultImage();
+
+        Measurement measurement;
+        measurement.milliseconds = std::chrono::duration<double, std::milli>(end - start).count() / repeats;
+        measurement.stats = solver.GetLastSolveStats();
+        measurement.residual = DiffusionSolver::ComputeResidual(result, solver.GetConstraintImage());
+        measurement.psnr = ComputePsnr(result, reference);
+        return measurement;
+    }
+
+    QVector<CurvePtr> Import(const QString& path)
+    {
+        if (path.endsWith(".json", Qt::CaseInsensitive))
+            return Importer::ImportFromJson(path);
+
+        return Importer::ImportFromXml(path);
+    }
+
+    // Every backend on every scene and size, scored against a converged CPU solution
+    int RunSuite(const Settings& settings, bool hasContext)
+    {
+        std::unique_ptr<QTextStream> csv;
+        QFile csvFile(settings.csvPath);
+
+        if (settings.csvPath.isEmpty() == false)
+        {
+            if (csvFile.open(QIODevice::WriteOnly | QIODevice::Text) == false)
+            {
+                LOG_FATAL("RunSuite: Could not open '{}' for writing.", settings.csvPath.toStdString());
+                return 1;
+            }
+
+            csv = std::make_unique<QTextStream>(&csvFile);
+            *csv << "scene,size,solver,milliseconds,levels,iterations,residual,psnr\n";
+        }
+
+        OrthographicCamera camera;
+        CurveContainer container;
+
+        std::printf("%-24s %6s %-8s %12s %8s %11s %12s %10s\n", "Scene", "Size", "Solver", "Time [ms]", "Levels", "Iterations", "Residual", "PSNR [dB]");
+
+        for (const auto& scene : settings.scenes)
+        {
+            if (QFileInfo(scene).isReadable() == false)
+            {
+                LOG_WARN("RunSuite: Skipping '{}', file is not readable.", scene.toStdString());
+                continue;
+            }
+
+            container.Clear();
+            container.AddCurves(Import(scene));
+
+            const QString sceneName = QFileInfo(scene).completeBaseName();
+
+            for (const int size : settings.sizes)
+            {
+                SetUpCamera(camera, container, size);
+
+                CpuDiffusionSolver referenceSolver;
+                referenceSolver.SetCamera(&camera);
+                referenceSolver.SetCurveContainer(&container);
+                referenceSolver.SetFramebufferSize(size);
+                referenceSolver.SetSmoothIterations(settings.referenceIterations);
+                referenceSolver.Solve();
+
+                const cv::Mat reference = referenceSolver.GetResultImage();
+
+                for (const auto type : settings.solvers)
+                {
+                    if (type == DiffusionSolverType::Gpu && hasContext == false)
+                        continue;
+
+                    std::unique_ptr<DiffusionSolver> solver(DiffusionSolverFactory::Create(type));
+                    solver->SetCamera(&camera);
+                    solver->SetCurveContainer(&container);
+                    solver->SetFramebufferSize(size);
+                    solver->SetSmoothIterations(settings.iterations);
+
+                    if (hasContext)
+                        solver->Initialize();
+
+                    const Measurement measurement = Measure(*solver, settings.repeats, reference);
+                    const char* solverName = DiffusionSolverFactory::GetName(type);
+
+                    std::printf("%-24s %6d %-8s %12.2f %8d %11d %12.3e %10.2f\n",
+                                sceneName.toStdString().c_str(),
+                                size,
+                                solverName,
+                                measurement.milliseconds,
+                                measurement.stats.levels,
+                                measurement.stats.iterations,
+                                measurement.residual,
+                                measurement.psnr);
+
+                    if (csv)
+                    {
+                        *csv << sceneName << ',' << size << ',' << solverName << ',' << measurement.milliseconds << ',' //
+                             << measurement.stats.levels << ',' << measurement.stats.iterations << ',' << measurement.residual << ',' << measurement.psnr << '\n';
+                    }
+                }
+            }
+        }
+
+        return 0;
+    }
+
+    // The CPU solver must reproduce the OpenGL pipeline, up to 8-bit storage on the GPU
+    int RunParity(const Settings& settings)
+    {
+        OrthographicCamera camera;
+        CurveContainer container;
+
+        const QString scene = settings.scenes.first();
+        const int size = settings.sizes.first();
+
+        container.AddCurves(Import(scene));
+        SetUpCamera(camera, container, size);
+
+        QVector<cv::Mat> results;
+
+        for (const auto type : { DiffusionSolverType::Gpu, DiffusionSolverType::Cpu })
+        {
+            std::unique_ptr<DiffusionSolver> solver(DiffusionSolverFactory::Create(type));
+            solver->SetCamera(&camera);
+            solver->SetCurveContainer(&container);
+            solver->SetFramebufferSize(size);
+            solver->SetSmoothIterations(settings.iterations);
+            solver->Initialize();
+            solver->Solve();
+            results << solver->GetResultImage();
+        }
+
+        cv::Mat difference;
+        cv::absdiff(results[0], results[1], difference);
+
+        double maximum = 0.0;
+        cv::minMaxLoc(difference.reshape(1), nullptr, &maximum);
+
+        const cv::Scalar channelMeans = cv::mean(difference);
+        const double mean = (channelMeans[0] + channelMeans[1] + channelMeans[2] + channelMeans[3]) / 4.0;
+        const bool passed = mean <= settings.tolerance;
+
+        std::printf("Parity on %s at %dpx: max %.4f, mean %.5f, PSNR %.2f dB -> %s\n",
+                    QFileInfo(scene).fileName().toStdString().c_str(),
+                    size,
+                    maximum,
+                    mean,
+                    ComputePsnr(results[1], results[0]),
+                    passed ? "PASSED" : "FAILED");
+
+        return passed ? 0 : 2;
+    }
+
+    int RunScaling(const Settings& settings)
+    {
+        OrthographicCamera camera;
+        CurveContainer container;
+
+        const int size = settings.sizes.last();
+
+        container.AddCurves(Import(settings.scenes.first()));
+        SetUpCamera(camera, container, size);
+
+        CpuDiffusionSolver solver;
+        solver.SetCamera(&camera);
+        solver.SetCurveContainer(&container);
+        solver.SetFramebufferSize(size);
+        solver.SetSmoothIterations(settings.iterations);
+
+        std::printf("CPU scaling at %dpx, %d iterations:\n", size, settings.iterations);
+
+        double singleThreadMilliseconds = 0.0;
+
+        for (int threads = 1; threads <= settings.maxThreads; threads = threads < settings.maxThreads ? std::min(2 * threads, settings.maxThreads) : threads + 1)
+        {
+            Parallel::SetThreadCount(threads);
+
+            solver.Solve();
+
+            const auto start = std::chrono::steady_clock::now();
+
+            for (int i = 0; i < settings.repeats; ++i)
+            {
+                solver.Solve();
+            }
+
+            const auto end = std::chrono::steady_clock::now();
+            const double milliseconds = std::chrono::duration<double, std::milli>(end - start).count() / settings.repeats;
+
+            if (threads == 1)
+                singleThreadMilliseconds = milliseconds;
+
+            std::printf("  %3d threads: %9.2f ms, speedup %5.2fx\n", threads, milliseconds, singleThreadMilliseconds / milliseconds);
+        }
+
+        Parallel::SetThreadCount(QThread::idealThreadCount());
+
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QGuiApplication app(argc, argv);
+
+    qInstallMessageHandler(Logger::QtMessageOutputCallback);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks the diffusion solvers: wall time, smoothing iterations, residual and PSNR against a converged reference.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("scenes", "Scene files, defaults to Resources/CurveData/*.xml.", "[scenes...]");
+
+    QCommandLineOption sizesOption("sizes", "Comma separated framebuffer sizes.", "list", "512,1024,2048");
+    QCommandLineOption solversOption("solvers", "Comma separated solver names, defaults to all.", "list");
+    QCommandLineOption iterationsOption("iterations", "Smoothing iterations per level.", "count", QString::number(DEFAULT_SMOOTH_ITERATIONS));
+    QCommandLineOption referenceIterationsOption("reference-iterations", "Smoothing iterations per level of the reference solution.", "count", "400");
+    QCommandLineOption repeatsOption("repeats", "Timed solves per measurement.", "count", "5");
+    QCommandLineOption csvOption("csv", "Also writes the suite results to <file>.", "file");
+    QCommandLineOption parityOption("parity", "Compares the CPU solver against the OpenGL one on the first scene and size.");
+    QCommandLineOption toleranceOption("tolerance", "Largest accepted mean absolute difference of the parity check.", "value", "0.01");
+    QCommandLineOption scalingOption("scaling", "Measures the CPU solver with 1 to --max-threads threads on the first scene and largest size.");
+    QCommandLineOption maxThreadsOption("max-threads", "Largest thread count of the scaling run.", "count", QString::number(QThread::idealThreadCount()));
+
+    parser.addOptions({ sizesOption, solversOption, iterationsOption, referenceIterationsOption, repeatsOption, csvOption, parityOption, toleranceOption, scalingOption, maxThreadsOption });
+    parser.process(app);
+
+    Settings settings;
+    settings.scenes = parser.positionalArguments();
+    settings.iterations = parser.value(iterationsOption).toInt();
+    settings.referenceIterations = parser.value(referenceIterationsOption).toInt();
+    settings.repeats = std::max(1, parser.value(repeatsOption).toInt());
+    settings.maxThreads = std::max(1, parser.value(maxThreadsOption).toInt());
+    settings.tolerance = parser.value(toleranceOption).toDouble();
+    settings.csvPath = parser.value(csvOption);
+
+    if (settings.scenes.isEmpty())
+    {
+        const QDir directory("Resources/CurveData");
+
+        for (const auto& file : directory.entryList({ "*.xml" }, QDir::Files, QDir::Name))
+            settings.scenes << directory.filePath(file);
+    }
+
+    for (const auto& size : parser.value(sizesOption).split(',', Qt::SkipEmptyParts))
+    {
+        if (size.toInt() > 2)
+            settings.sizes << size.toInt();
+    }
+
+    if (parser.isSet(solversOption))
+    {
+        for (const auto& name : parser.value(solversOption).split(',', Qt::SkipEmptyParts))
+        {
+            DiffusionSolverType type;
+
+            if (DiffusionSolverFactory::FromName(name.trimmed(), type) == false)
+            {
+                LOG_FATAL("main: Unknown solver '{}'.", name.toStdString());
+                return 1;
+            }
+
+            settings.solvers << type;
+        }
+    }
+    else
+    {
+        settings.solvers = DiffusionSolverFactory::GetTypes();
+    }
+
+    if (settings.scenes.isEmpty() || settings.sizes.isEmpty())
+    {
+        parser.showHelp(1);
+    }
+
+    // Without a context, e.g. on a machine without any OpenGL, only the CPU backends run
+    OffscreenContext context;
+    const bool hasContext = context.Initialize();
+
+    if (hasContext == false)
+        LOG_WARN("main: No OpenGL context, OpenGL backends are skipped.");
+
+    if (parser.isSet(parityOption))
+        return hasContext ? RunParity(settings) : 1;
+
+    if (parser.isSet(scalingOption))
+        return RunScaling(settings);
+
+    return RunSuite(settings, hasContext);
+}
@@ -0,0 +1,157 @@
+#include "Util/Logger.h"
+#include "Util/Parallel.h"
+#include "Vectorization/Stages/EdgeStack/EdgeStack.h"
+#include "Vectorization/Stages/GaussianStack/GaussianStack.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QThread>
+#include <chrono>
+#include <cstdio>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+using namespace DiffusionCurveRenderer;
+
+namespace
+{
+    struct Settings
+    {
+        QStringList images;
+        int maxHeight;
+        int repeats;
+        int maxThreads;
+    };
+
+    // Builds the whole Gaussian and edge stack of the image, as the vectorization does before tracing
+    double Measure(const cv::Mat& image, const Settings& settings)
+    {
+        double milliseconds = 0.0;
+
+        for (int i = 0; i < settings.repeats; ++i)
+        {
+            GaussianStack gaussianStack(nullptr);
+            EdgeStack edgeStack(nullptr);
+
+            const auto start = std::chrono::steady_clock::now();
+
+            gaussianStack.Run(image, 40.0, settings.maxHeight);
+            edgeStack.Run(&gaussianStack, 20.0, 200.0);
+            edgeStack.Precompute(0, edgeStack.GetHeight() - 1);
+
+            const auto end = std::chrono::steady_clock::now();
+            milliseconds += std::chrono::duration<double, std::milli>(end - start).count();
+        }
+
+        return milliseconds / settings.repeats;
+    }
+
+    int RunScaling(const Settings& settings)
+    {
+        QVector<cv::Mat> images;
+        QStringList names;
+
+        for (const auto& path : settings.images)
+        {
+            cv::Mat image = cv::imread(path.toStdString(), cv::IMREAD_COLOR);
+
+            if (image.empty())
+            {
+                LOG_WARN("RunScaling: Skipping '{}', file is not a readable image.", path.toStdString());
+                continue;
+            }
+
+            images << image;
+            names << QFileInfo(path).completeBaseName();
+        }
+
+        if (images.isEmpty())
+        {
+            LOG_FATAL("RunScaling: No images to measure.");
+            return 1;
+        }
+
+        // OpenCV threads its own filters, only the stacks' parallelism is measured
+        cv::setNumThreads(1);
+
+        std::printf("Scale space scaling, %d layers, over %d images:\n", settings.maxHeight, int(images.size()));
+        std::printf("%-40s %8s %12s %8s\n", "Image", "Threads", "Time [ms]", "Speedup");
+
+        QVector<double> singleThreadMilliseconds(images.size(), 0.0);
+        double singleThreadTotal = 0.0;
+
+        for (int threads = 1; threads <= settings.maxThreads; threads = threads < settings.maxThreads ? std::min(2 * threads, settings.maxThreads) : threads + 1)
+        {
+            Parallel::SetThreadCount(threads);
+
+            double total = 0.0;
+
+            for (int i = 0; i < images.size(); ++i)
+            {
+                const double milliseconds = Measure(images[i], settings);
+
+                if (threads == 1)
+                    singleThreadMilliseconds[i] = milliseconds;
+
+                std::printf("%-40s %8d %12.2f %7.2fx\n",
+                            names[i].left(40).toStdString().c_str(),
+                            threads,
+                            milliseconds,
+                            singleThreadMilliseconds[i] / milliseconds);
+
+                total += milliseconds;
+            }
+
+            if (threads == 1)
+                singleThreadTotal = total;
+
+            std::printf("  %3d threads: %9.2f ms in total, speedup %5.2fx\n", threads, total, singleThreadTotal / total);
+        }
+
+        Parallel::SetThreadCount(QThread::idealThreadCount());
+
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    qInstallMessageHandler(Logger::QtMessageOutputCallback);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks building the Gaussian and edge stacks of the vectorization with 1 to --max-threads threads.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("images", "Image files, defaults to Resources/Images/*.", "[images...]");
+
+    QCommandLineOption heightOption("height", "Layers of the stacks.", "count", "60");
+    QCommandLineOption repeatsOption("repeats", "Timed builds per measurement.", "count", "3");
+    QCommandLineOption maxThreadsOption("max-threads", "Largest thread count.", "count", QString::number(QThread::idealThreadCount()));
+
+    parser.addOptions({ heightOption, repeatsOption, maxThreadsOption });
+    parser.process(app);
+
+    Settings settings;
+    settings.images = parser.positionalArguments();
+    settings.maxHeight = std::max(1, parser.value(heightOption).toInt());
+    settings.repeats = std::max(1, parser.value(repeatsOption).toInt());
+    settings.maxThreads = std::max(1, parser.value(maxThreadsOption).toInt());
+
+    if (settings.images.isEmpty())
+    {
+        const QDir directory("Resources/Images");
+
+        for (const auto& file : directory.entryList({ "*.jpg", "*.jpeg", "*.png" }, QDir::Files, QDir::Name))
+            settings.images << directory.filePath(file);
+    }
+
+    if (settings.images.isEmpty())
+    {
+        parser.showHelp(1);
+    }
+
+    return RunScaling(settings);
+}
@@ -0,0 +1,208 @@
+#include "Util/Logger.h"
+#include "Util/Parallel.h"
+#include "Vectorization/Stages/ColorSampler/ColorSampler.h"
+#include "Vectorization/Stages/ComponentEdgeTracer/ComponentEdgeTracer.h"
+#include "Vectorization/Stages/CurveConstructor/BezierCurveConstructor.h"
+#include "Vectorization/Stages/EdgeStack/EdgeStack.h"
+#include "Vectorization/Stages/GaussianStack/GaussianStack.h"
+#include "Vectorization/Stages/Potrace/Potrace.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QThread>
+#include <chrono>
+#include <cstdio>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+using namespace DiffusionCurveRenderer;
+
+namespace
+{
+    struct Settings
+    {
+        QStringList images;
+        int level;
+        int repeats;
+        int maxThreads;
+    };
+
+    struct Measurement
+    {
+        double potraceMilliseconds{ 0.0 };
+        double constructorMilliseconds{ 0.0 };
+        double colorSamplerMilliseconds{ 0.0 };
+        size_t fingerprint{ 0 };
+        int curves{ 0 };
+
+        double Total() const { return potraceMilliseconds + constructorMilliseconds + colorSamplerMilliseconds; }
+    };
+
+    double Since(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Hash of every control and color point, equal outputs of two runs have equal fingerprints
+    size_t Fingerprint(const QVector<CurvePtr>& curves)
+    {
+        QVector<float> values;
+
+        for (const auto& curve : curves)
+        {
+            const auto bezier = std::dynamic_pointer_cast<Bezier>(curve);
+
+            if (bezier == nullptr)
+                continue;
+
+            for (const auto& point : bezier->GetControlPoints())
+                values << point->position.x() << point->position.y();
+
+            for (const auto& point : bezier->GetColorPoints())
+                values << float(point->type) << point->color.x() << point->color.y() << point->color.z() << point->position;
+        }
+
+        return qHashBits(values.constData(), values.size() * sizeof(float));
+    }
+
+    // The stages after edge tracing, each of them loops over independent chains or curves
+    Measurement Measure(const QList<PixelChain>& chains, cv::Mat image, cv::Mat imageLab, const Settings& settings)
+    {
+        Measurement measurement;
+
+        for (int i = 0; i < settings.repeats; ++i)
+        {
+            Potrace potrace(nullptr);
+            BezierCurveConstructor constructor(nullptr);
+            ColorSampler colorSampler(nullptr);
+
+            auto start = std::chrono::steady_clock::now();
+            potrace.Run(chains);
+            measurement.potraceMilliseconds += Since(start);
+
+            start = std::chrono::steady_clock::now();
+            constructor.Run(potrace.GetPolylines());
+            measurement.constructorMilliseconds += Since(start);
+
+            start = std::chrono::steady_clock::now();
+            colorSampler.Run(constructor.GetCurves(), image, imageLab, 0.05);
+            measurement.colorSamplerMilliseconds += Since(start);
+
+            measurement.fingerprint = Fingerprint(constructor.GetCurves());
+            measurement.curves = constructor.GetCurves().size();
+        }
+
+        measurement.potraceMilliseconds /= settings.repeats;
+        measurement.constructorMilliseconds /= settings.repeats;
+        measurement.colorSamplerMilliseconds /= settings.repeats;
+
+        return measurement;
+    }
+
+    int RunScaling(const Settings& settings)
+    {
+        std::printf("%-28s %8s %8s %12s %12s %12s %12s %8s %6s\n", "Image", "Chains", "Threads", "Potrace", "Curves", "Colors", "Total [ms]", "Speedup", "Same");
+
+        bool allSame = true;
+
+        for (const auto& path : settings.images)
+        {
+            cv::Mat image = cv::imread(path.toStdString(), cv::IMREAD_COLOR);
+
+            if (image.empty())
+            {
+                LOG_WARN("RunScaling: Skipping '{}', file is not a readable image.", path.toStdString());
+                continue;
+            }
+
+            cv::Mat imageLab;
+            cv::cvtColor(image, imageLab, cv::COLOR_BGR2Lab);
+
+            // Edges and chains are the same for every thread count, they are computed once
+            GaussianStack gaussianStack(nullptr);
+            EdgeStack edgeStack(nullptr);
+            ComponentEdgeTracer tracer(nullptr);
+
+            gaussianStack.Run(image);
+            edgeStack.Run(&gaussianStack, 20.0, 200.0);
+            tracer.Run(edgeStack.GetLayer(std::min(settings.level, edgeStack.GetHeight() - 1)), 10);
+
+            const QString name = QFileInfo(path).completeBaseName().left(28);
+
+            Measurement singleThread;
+
+            for (int threads = 1; threads <= settings.maxThreads; threads = threads < settings.maxThreads ? std::min(2 * threads, settings.maxThreads) : threads + 1)
+            {
+                Parallel::SetThreadCount(threads);
+
+                const Measurement measurement = Measure(tracer.GetChains(), image, imageLab, settings);
+
+                if (threads == 1)
+                    singleThread = measurement;
+
+                const bool same = measurement.fingerprint == singleThread.fingerprint && measurement.curves == singleThread.curves;
+                allSame = allSame && same;
+
+                std::printf("%-28s %8d %8d %12.2f %12.2f %12.2f %12.2f %7.2fx %6s\n",
+                            name.toStdString().c_str(),
+                            int(tracer.GetChains().size()),
+                            threads,
+                            measurement.potraceMilliseconds,
+                            measurement.constructorMilliseconds,
+                            measurement.colorSamplerMilliseconds,
+                            measurement.Total(),
+                            singleThread.Total() / measurement.Total(),
+                            same ? "yes" : "NO");
+            }
+        }
+
+        Parallel::SetThreadCount(QThread::idealThreadCount());
+
+        // Outputs must not depend on the thread count
+        return allSame ? 0 : 2;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    qInstallMessageHandler(Logger::QtMessageOutputCallback);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks Potrace, curve construction and color sampling of the vectorization with 1 to --max-threads threads.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("images", "Image files, defaults to the butterfly and rose images in Resources/Images.", "[images...]");
+
+    QCommandLineOption levelOption("level", "Edge stack level the chains are traced from.", "level", "4");
+    QCommandLineOption repeatsOption("repeats", "Timed runs per measurement.", "count", "3");
+    QCommandLineOption maxThreadsOption("max-threads", "Largest thread count.", "count", QString::number(QThread::idealThreadCount()));
+
+    parser.addOptions({ levelOption, repeatsOption, maxThreadsOption });
+    parser.process(app);
+
+    Settings settings;
+    settings.images = parser.positionalArguments();
+    settings.level = std::max(0, parser.value(levelOption).toInt());
+    settings.repeats = std::max(1, parser.value(repeatsOption).toInt());
+    settings.maxThreads = std::max(1, parser.value(maxThreadsOption).toInt());
+
+    if (settings.images.isEmpty())
+    {
+        const QDir directory("Resources/Images");
+
+        for (const auto& file : directory.entryList({ "butterfly*", "*rose*" }, QDir::Files, QDir::Name))
+            settings.images << directory.filePath(file);
+    }
+
+    if (settings.images.isEmpty())
+    {
+        parser.showHelp(1);
+    }
+
+    return RunScaling(settings);
+}